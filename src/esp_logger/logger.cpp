@@ -1,9 +1,17 @@
 #include "esp_logger/logger.h"
+#include "esp_logger/logger_deferred.h"
+#include "esp_logger/logger_format.h"
+#include "esp_logger/logger_json_writer.h"
+#include "esp_logger/logger_lock.h"
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <iterator>
+#include <new>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -16,28 +24,53 @@
 #include <inttypes.h>
 #endif
 
-class LockGuard {
-  public:
-	explicit LockGuard(SemaphoreHandle_t handle) : _handle(handle) {
-		if (_handle != nullptr) {
-			xSemaphoreTake(_handle, portMAX_DELAY);
-		}
-	}
+constexpr const char *kSyncTaskName = "ESPLoggerSync";
+constexpr uint8_t kNoTagLevel = 0xFF;
+constexpr const char *kLevelNames[kLogLevelCount] = {"debug", "info", "warn", "error"};
+#if ESPLOGGER_HAS_ARDUINOJSON_V7
+// Format-pointer sentinel for records whose payload is a MessagePack copy of a JSON variant.
+static const char kMsgPackFormat[] = "{msgpack}";
+#endif
 
-	~LockGuard() {
-		if (_handle != nullptr) {
-			xSemaphoreGive(_handle);
-		}
+// Arena-style view of a record read back from a LogRetainedRing, with the format pointer
+// the sentinel or NUL-terminated format text that renderEntryMessage expects.
+static ArenaRecordView ringRecordView(const RetainedRecordView &view) {
+	ArenaRecordView record;
+	record.level = view.level;
+	record.millis = view.millis;
+	record.timestamp = view.timestamp;
+	record.tag = view.tag.data();
+	record.tagLength = view.tag.size();
+	record.payload = view.payload.data();
+	record.payloadLength = view.payload.size();
+	record.printed = view.printed;
+	switch (view.kind) {
+	case RetainedKind::Text:
+		break;
+	case RetainedKind::Fields:
+		record.format = logger_fields_detail::kFieldsFormat;
+		break;
+	case RetainedKind::MsgPack:
+#if ESPLOGGER_HAS_ARDUINOJSON_V7
+		record.format = kMsgPackFormat;
+#endif
+		break;
+	case RetainedKind::Printf:
+		record.format = view.format.data();
+		break;
 	}
+	return record;
+}
 
-	LockGuard(const LockGuard &) = delete;
-	LockGuard &operator=(const LockGuard &) = delete;
-
-  private:
-	SemaphoreHandle_t _handle;
-};
+static bool sameText(const char *a, const char *b) {
+	return a == b || (a != nullptr && b != nullptr && std::strcmp(a, b) == 0);
+}
 
-constexpr const char *kSyncTaskName = "ESPLoggerSync";
+// `maxLogBytes` is split between the region producers fill and the one the sync path
+// drains, so arena mode allocates exactly the configured budget.
+static size_t arenaRegionBytes(size_t maxLogBytes) {
+	return maxLogBytes / 2;
+}
 
 #if ESPLOGGER_USE_ESP_LOG
 static void logWithEsp(
@@ -118,7 +151,8 @@ static void invokeLiveCallback(const LiveCallback &callback, const Log &entry) {
 #endif
 }
 
-static void invokeSyncCallback(const SyncCallback &callback, const std::vector<Log> &logs) {
+template <typename Callback, typename Batch>
+static void invokeSyncCallback(const Callback &callback, const Batch &logs) {
 	if (!callback) {
 		return;
 	}
@@ -155,77 +189,424 @@ bool ESPLogger::init(const LoggerConfig &config) {
 
 	_usePSRAMBuffers = normalized.usePSRAMBuffers;
 	_logAllocator = LoggerAllocator<Log>(_usePSRAMBuffers);
-	_charAllocator = LoggerAllocator<char>(_usePSRAMBuffers);
 
 	{
 		LockGuard guard(_mutex);
-		_logs = InternalLogDeque(_logAllocator);
+		_logs = InternalLogQueue(_logAllocator);
 		_config = normalized;
 		_logLevel = _config.consoleLogLevel;
 	}
+	applyRuntimeSettings();
 
-	_running = false;
-	const bool shouldCreateTask = _config.enableSyncTask && _config.syncIntervalMS > 0;
+	if (!createStorage()) {
+		releaseStorage();
+		vSemaphoreDelete(_mutex);
+		_mutex = nullptr;
+		_config = LoggerConfig{};
+		_logLevel = _config.consoleLogLevel;
+		return false;
+	}
 
-	if (shouldCreateTask) {
-		_running = true;
-		const BaseType_t created = xTaskCreatePinnedToCore(
-		    &ESPLogger::syncTaskThunk,
-		    kSyncTaskName,
-		    _config.stackSize,
-		    this,
-		    _config.priority,
-		    &_syncTask,
-		    _config.coreId
-		);
+	const bool hasSurvivors = !_previousBootLogs.empty();
+	if (!startSyncTask()) {
+		{
+			LockGuard guard(_mutex);
+			_logs = InternalLogQueue(_logAllocator);
+			_syncCallback = nullptr;
+			_syncViewCallback = nullptr;
+			_config = LoggerConfig{};
+			_logLevel = _config.consoleLogLevel;
+		}
+		detach();
+		releaseStorage();
+		_usePSRAMBuffers = false;
+		_logAllocator = LoggerAllocator<Log>(_usePSRAMBuffers);
+		if (_mutex != nullptr) {
+			vSemaphoreDelete(_mutex);
+			_mutex = nullptr;
+		}
+		return false;
+	}
 
-		if (created != pdPASS) {
-			_running = false;
-			{
-				LockGuard guard(_mutex);
-				_logs = InternalLogDeque(_logAllocator);
-				_syncCallback = nullptr;
-				_liveCallback = nullptr;
-				_config = LoggerConfig{};
-				_logLevel = _config.consoleLogLevel;
-			}
-			_usePSRAMBuffers = false;
-			_logAllocator = LoggerAllocator<Log>(_usePSRAMBuffers);
-			_charAllocator = LoggerAllocator<char>(_usePSRAMBuffers);
-			if (_mutex != nullptr) {
-				vSemaphoreDelete(_mutex);
-				_mutex = nullptr;
+	_initialized = true;
+	if (hasSurvivors) {
+		requestSync();
+	}
+	return true;
+}
+
+bool ESPLogger::reconfigure(const LoggerConfig &config) {
+	if (!_initialized.load(std::memory_order_acquire)) {
+		return init(config);
+	}
+
+	LoggerConfig normalized = config;
+	if (normalized.maxLogInRam == 0) {
+		normalized.maxLogInRam = 1;
+	}
+
+	const LoggerConfig previous = currentConfig();
+	// These select allocators or storage layouts that buffered records depend on.
+	if (normalized.usePSRAMBuffers != previous.usePSRAMBuffers ||
+	    normalized.useLockFreeRing != previous.useLockFreeRing ||
+	    normalized.maxTags != previous.maxTags ||
+	    normalized.retainedBuffer != previous.retainedBuffer ||
+	    normalized.retainedBufferSize != previous.retainedBufferSize ||
+	    !sameText(normalized.mappedLogPath, previous.mappedLogPath) ||
+	    normalized.mappedLogBytes != previous.mappedLogBytes ||
+	    (normalized.maxLogBytes > 0) != (previous.maxLogBytes > 0) ||
+	    // Producers push into the ring without the logger mutex, so it cannot be rebuilt
+	    // under them.
+	    (normalized.useLockFreeRing && normalized.maxLogInRam != previous.maxLogInRam)) {
+		return false;
+	}
+
+	std::unique_ptr<LogArena> arena;
+	std::unique_ptr<LogArena> retiredArena;
+	if (!_mapped && normalized.maxLogBytes != previous.maxLogBytes) {
+		// Both budgets are held until the records are copied over.
+		const size_t regionBytes = arenaRegionBytes(normalized.maxLogBytes);
+		arena.reset(new (std::nothrow) LogArena(regionBytes, _usePSRAMBuffers));
+		retiredArena.reset(new (std::nothrow) LogArena(regionBytes, _usePSRAMBuffers));
+		if (!arena || !arena->valid() || !retiredArena || !retiredArena->valid()) {
+			return false;
+		}
+	}
+
+	// Swap the task before committing anything else, so a task that cannot be created leaves
+	// the previous configuration and task in place.
+	const bool wantsTask = normalized.enableSyncTask && normalized.syncIntervalMS > 0;
+	const bool hadTask = previous.enableSyncTask && previous.syncIntervalMS > 0;
+	if (wantsTask != hadTask || (wantsTask && (normalized.coreId != previous.coreId ||
+	                                           normalized.stackSize != previous.stackSize))) {
+		stopSyncTask();
+		setTaskConfig(normalized);
+		if (!startSyncTask()) {
+			setTaskConfig(previous);
+			if (!startSyncTask()) {
+				// Make the config say what is running: no task at all.
+				LoggerConfig stopped = previous;
+				stopped.enableSyncTask = false;
+				setTaskConfig(stopped);
+				logToConsole(
+				    LogLevel::Error,
+				    kSyncTaskName,
+				    static_cast<uint32_t>(millis()),
+				    std::time(nullptr),
+				    "sync task could not be restarted; call sync() or init() again"
+				);
 			}
-			_syncTask = nullptr;
 			return false;
 		}
 	}
 
-	_initialized = true;
+	{
+		// Same order as performSync, so a flush in progress finishes with the old buffers.
+		LockGuard syncGuard(_syncMutex);
+		// Holding it proves that a task abandoned above has let go of it.
+		_syncTaskAbandoned = false;
+		LockGuard guard(_mutex);
+		drainRingLocked();
+		_config = normalized;
+		_logLevel = _config.consoleLogLevel;
+		if (arena) {
+			// Replaying oldest to newest keeps the newest suffix; what no longer fits is
+			// evicted, and counted, the way an overflow would.
+			_arena->forEach([this, &arena](const ArenaRecordView &view) {
+				while (arena->count() > 0 && !arena->fits(view)) {
+					ArenaRecordView oldest;
+					arena->front(oldest);
+					dropRecord(oldest);
+					arena->popFront();
+				}
+				if (arena->append(view) < 0) {
+					dropRecord(view);
+				}
+			});
+			_arena = std::move(arena);
+			_retiredArena = std::move(retiredArena);
+		}
+		shrinkLocked();
+	}
+	applyRuntimeSettings();
+
+	TaskHandle_t task = _syncTask.load(std::memory_order_acquire);
+	if (task == nullptr) {
+		return true;
+	}
+	if (normalized.priority != previous.priority) {
+		vTaskPrioritySet(task, normalized.priority);
+	}
+	if (normalized.syncIntervalMS != previous.syncIntervalMS) {
+		// Restart the pending wait with the new interval rather than waiting out the old one.
+		_intervalChanged.store(true, std::memory_order_release);
+		xTaskNotifyGive(task);
+	}
 	return true;
 }
 
-void ESPLogger::deinit() {
-	_running = false;
+void ESPLogger::setTaskConfig(const LoggerConfig &config) {
+	LockGuard guard(_mutex);
+	_config.enableSyncTask = config.enableSyncTask;
+	_config.syncIntervalMS = config.syncIntervalMS;
+	_config.coreId = config.coreId;
+	_config.stackSize = config.stackSize;
+	_config.priority = config.priority;
+}
+
+void ESPLogger::applyRuntimeSettings() {
+	_deferFormatting.store(_config.deferFormatting, std::memory_order_relaxed);
+	_deferJson.store(_config.deferJson, std::memory_order_relaxed);
+	_usePrettyJson.store(_config.usePrettyJson, std::memory_order_relaxed);
+	_captureLevel.store(_config.captureLevel, std::memory_order_relaxed);
+	_syncIntervalMS.store(_config.syncIntervalMS, std::memory_order_relaxed);
+	_syncWatermarkPercent.store(_config.syncWatermarkPercent, std::memory_order_relaxed);
+	_syncTriggerLevel.store(_config.syncTriggerLevel, std::memory_order_relaxed);
+	_overflowPolicy.store(_config.overflowPolicy, std::memory_order_relaxed);
+}
+
+bool ESPLogger::createStorage() {
+	_syncMutex = xSemaphoreCreateMutex();
+	_roomAvailable = xSemaphoreCreateBinary();
+	if (_syncMutex == nullptr || _roomAvailable == nullptr) {
+		return false;
+	}
+
+	_tags.reset(new (std::nothrow) LogTagRegistry(_config.maxTags));
+	if (!_tags || !_tags->valid()) {
+		return false;
+	}
+	_tagLevels.reset(new (std::nothrow) std::atomic<uint8_t>[_tags->capacity()]);
+	if (!_tagLevels) {
+		return false;
+	}
+	for (size_t id = 0; id < _tags->capacity(); ++id) {
+		_tagLevels[id].store(kNoTagLevel, std::memory_order_relaxed);
+	}
+
+	_retiredLogs = InternalLogQueue(_logAllocator);
+	if (_config.mappedLogPath != nullptr) {
+		_mappedFile.reset(new (std::nothrow) LogMappedFile());
+		const size_t fileSize = LogRetainedRing::kHeaderSize + _config.mappedLogBytes;
+		if (!_mappedFile || !_mappedFile->open(_config.mappedLogPath, fileSize)) {
+			return false;
+		}
+		_mapped.reset(new (std::nothrow) LogRetainedRing(_mappedFile->data(), _mappedFile->size()));
+		if (!_mapped || !_mapped->valid()) {
+			return false;
+		}
+		// Earlier runs' entries stay in the file for other readers but are not synced again.
+		if (!_mapped->recover(nullptr)) {
+			_mapped->reset(0);
+		}
+		_mappedCursor = _mapped->headCursor();
+		_mappedPending = 0;
+	} else if (_config.maxLogBytes > 0) {
+		// The second region is what the sync path drains while producers fill the first.
+		const size_t regionBytes = arenaRegionBytes(_config.maxLogBytes);
+		_arena.reset(new (std::nothrow) LogArena(regionBytes, _usePSRAMBuffers));
+		_retiredArena.reset(new (std::nothrow) LogArena(regionBytes, _usePSRAMBuffers));
+		if (!_arena || !_arena->valid() || !_retiredArena || !_retiredArena->valid()) {
+			return false;
+		}
+	}
+
+	if (_config.useLockFreeRing) {
+		_ring.reset(new (std::nothrow) InternalLogRing(_config.maxLogInRam, _usePSRAMBuffers));
+		if (!_ring) {
+			return false;
+		}
+	}
+
+	if (_config.retainedBuffer != nullptr) {
+		_retained.reset(new (std::nothrow)
+		                    LogRetainedRing(_config.retainedBuffer, _config.retainedBufferSize));
+		if (!_retained || !_retained->valid()) {
+			return false;
+		}
+		recoverRetained();
+	}
+	return true;
+}
+
+// Copies what survived in the retained ring into `_previousBootLogs`, then starts a new
+// generation so the same entries are never replayed twice.
+void ESPLogger::recoverRetained() {
+	_previousBootLogs.clear();
+	const bool intact = _retained->recover([this](const RetainedRecordView &view) {
+		const ArenaRecordView record = ringRecordView(view);
+		if (view.kind == RetainedKind::MsgPack && record.format == nullptr) {
+			return; // Written by a build with ArduinoJson; this one cannot render it.
+		}
+		Log entry = toLog(record);
+		entry.previousBoot = true;
+		_previousBootLogs.push_back(std::move(entry));
+	});
+	_retained->reset(intact ? _retained->storedGeneration() + 1 : 0);
+}
+
+void ESPLogger::releaseStorage() {
+	_ring.reset();
+	_retained.reset();
+	_previousBootLogs.clear();
+	_mapped.reset();
+	_mappedFile.reset();
+	_mappedCursor = 0;
+	_mappedPending = 0;
+	_retiredMapped = std::string();
+	_arena.reset();
+	_retiredArena.reset();
+	_retiredLogs = InternalLogQueue(_logAllocator);
+	_tagLevelCount.store(0, std::memory_order_relaxed);
+	_tagLevels.reset();
+	_tags.reset();
+	if (_syncMutex != nullptr) {
+		// Leaked when an abandoned task may still release it.
+		if (!_syncTaskAbandoned) {
+			vSemaphoreDelete(_syncMutex);
+		}
+		_syncMutex = nullptr;
+	}
+	_syncTaskAbandoned = false;
+	if (_roomAvailable != nullptr) {
+		vSemaphoreDelete(_roomAvailable);
+		_roomAvailable = nullptr;
+	}
+	_syncCount.store(0, std::memory_order_relaxed);
+	_lastSyncBatchSize.store(0, std::memory_order_relaxed);
+	_lastSyncLockHoldMicros.store(0, std::memory_order_relaxed);
+	_maxSyncLockHoldMicros.store(0, std::memory_order_relaxed);
+	_syncTriggerCount.store(0, std::memory_order_relaxed);
+	_spilledCount.store(0, std::memory_order_relaxed);
+	_spillFailedCount.store(0, std::memory_order_relaxed);
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		_droppedCount[level].store(0, std::memory_order_relaxed);
+		_droppedReported[level] = 0;
+	}
+	_syncRequested.store(false, std::memory_order_relaxed);
+}
+
+// Shared by the logger and one sync task. The phase tells stopSyncTask() whether the task
+// can be deleted, must be waited for, or has to be abandoned; an abandoned task keeps the
+// block, so it can still learn that it must not touch the logger once its handler returns.
+struct ESPLogger::SyncTaskControl {
+	enum Phase : uint8_t {
+		Idle,     // Waiting for a notification; holds no logger lock
+		Busy,     // Running logger code, which always finishes
+		Blocked,  // In a handler, a spill store, or waiting for another flush
+		Abandoned // Given up on by stopSyncTask(); never touches the logger again
+	};
+
+	explicit SyncTaskControl(ESPLogger *owner) : logger(owner) {
+	}
+	~SyncTaskControl() {
+		if (done != nullptr) {
+			vSemaphoreDelete(done);
+		}
+	}
+
+	bool enter(uint8_t from, uint8_t to) {
+		return phase.compare_exchange_strong(from, to, std::memory_order_acq_rel);
+	}
+
+	ESPLogger *const logger;
+	SemaphoreHandle_t done = nullptr;
+	std::atomic<bool> running{true};
+	std::atomic<uint8_t> phase{Idle};
+};
+
+bool ESPLogger::startSyncTask() {
+	if (!_config.enableSyncTask || _config.syncIntervalMS == 0) {
+		return true;
+	}
+
+	auto *task = new (std::nothrow) SyncTaskControl(this);
+	if (task == nullptr) {
+		return false;
+	}
+	task->done = xSemaphoreCreateBinary();
+	if (task->done == nullptr) {
+		delete task;
+		return false;
+	}
+
+	TaskHandle_t handle = nullptr;
+	const BaseType_t created = xTaskCreatePinnedToCore(
+	    &ESPLogger::syncTaskThunk,
+	    kSyncTaskName,
+	    _config.stackSize,
+	    task,
+	    _config.priority,
+	    &handle,
+	    _config.coreId
+	);
+	if (created != pdPASS) {
+		delete task;
+		return false;
+	}
+	_taskControl = task;
+	_syncTask.store(handle, std::memory_order_release);
+	return true;
+}
+
+void ESPLogger::stopSyncTask() {
+	SyncTaskControl *task = _taskControl;
+	_taskControl = nullptr;
+	TaskHandle_t handle = _syncTask.exchange(nullptr, std::memory_order_acq_rel);
+	if (task == nullptr) {
+		return;
+	}
 
-	if (_syncTask != nullptr) {
-		TickType_t start = xTaskGetTickCount();
-		while (_syncTask != nullptr && (xTaskGetTickCount() - start) <= pdMS_TO_TICKS(200)) {
-			vTaskDelay(pdMS_TO_TICKS(10));
+	// Wake the task so it sees the stop now rather than at the end of its interval, then
+	// wait for it to signal that it has left the loop.
+	task->running.store(false, std::memory_order_release);
+	xTaskNotifyGive(handle);
+	const TickType_t deadline = pdMS_TO_TICKS(_config.shutdownTimeoutMS);
+	while (xSemaphoreTake(task->done, deadline) != pdPASS) {
+		if (task->enter(SyncTaskControl::Idle, SyncTaskControl::Abandoned)) {
+			// Not inside a flush, so it holds no logger lock.
+			vTaskDelete(handle);
+			break;
 		}
-		if (_syncTask != nullptr) {
-			vTaskDelete(_syncTask);
-			_syncTask = nullptr;
+		if (task->enter(SyncTaskControl::Blocked, SyncTaskControl::Abandoned)) {
+			// Deleting the task would leave `_syncMutex` held forever, so it is left to
+			// return from the handler on its own. It then frees `task` and exits without
+			// touching the logger, which may be gone by then.
+			logToConsole(
+			    LogLevel::Error,
+			    kSyncTaskName,
+			    static_cast<uint32_t>(millis()),
+			    std::time(nullptr),
+			    "sync task still flushing after shutdownTimeoutMS; abandoning it"
+			);
+			_syncTaskAbandoned = true;
+			return;
 		}
+		// Busy: logger code between two handlers, which always finishes.
 	}
+	delete task;
+}
+
+void ESPLogger::deinit() {
+	stopSyncTask();
 
 	if (_mutex != nullptr) {
-		performSync();
+		// An abandoned task may still hold `_syncMutex`; the last entries are dropped
+		// rather than waiting on it.
+		if (!_syncTaskAbandoned) {
+			performSync();
+		}
 		{
 			LockGuard guard(_mutex);
-			_logs = InternalLogDeque(_logAllocator);
+			if (_retained) {
+				// A clean shutdown leaves nothing to recover.
+				_retained->clear();
+			}
+			_logs = InternalLogQueue(_logAllocator);
 			_syncCallback = nullptr;
-			_liveCallback = nullptr;
+			_syncViewCallback = nullptr;
+			_spillStore = LogSpillStore{};
+			std::fill(std::begin(_spillPending), std::end(_spillPending), 0);
 			_config = LoggerConfig{};
 			_logLevel = _config.consoleLogLevel;
 		}
@@ -235,29 +616,56 @@ void ESPLogger::deinit() {
 
 	_usePSRAMBuffers = false;
 	_logAllocator = LoggerAllocator<Log>(_usePSRAMBuffers);
-	_charAllocator = LoggerAllocator<char>(_usePSRAMBuffers);
-	_logs = InternalLogDeque(_logAllocator);
+	releaseStorage();
+	_logs = InternalLogQueue(_logAllocator);
 	_syncCallback = nullptr;
-	_liveCallback = nullptr;
+	_syncViewCallback = nullptr;
+	_spillStore = LogSpillStore{};
+	std::fill(std::begin(_spillPending), std::end(_spillPending), 0);
+	detach();
 	_config = LoggerConfig{};
 	_logLevel = _config.consoleLogLevel;
+	_deferFormatting.store(false, std::memory_order_relaxed);
+	_deferJson.store(false, std::memory_order_relaxed);
+	_captureLevel.store(LogLevel::Debug, std::memory_order_relaxed);
 	_initialized = false;
-	_syncTask = nullptr;
 }
 
 void ESPLogger::onSync(SyncCallback callback) {
 	LockGuard guard(_mutex);
 	_syncCallback = std::move(callback);
+	_syncViewCallback = nullptr;
 }
 
-void ESPLogger::attach(LiveCallback callback) {
+void ESPLogger::onSync(SyncViewCallback callback) {
 	LockGuard guard(_mutex);
-	_liveCallback = std::move(callback);
+	_syncViewCallback = std::move(callback);
+	_syncCallback = nullptr;
+}
+
+void ESPLogger::onSync(std::nullptr_t) {
+	LockGuard guard(_mutex);
+	_syncCallback = nullptr;
+	_syncViewCallback = nullptr;
+}
+
+void ESPLogger::attach(LiveCallback callback) {
+	std::shared_ptr<const LiveCallback> shared;
+	if (callback) {
+		shared = std::make_shared<const LiveCallback>(std::move(callback));
+	}
+	_hasLiveCallback.store(static_cast<bool>(shared), std::memory_order_release);
+	std::atomic_store(&_liveCallback, std::move(shared));
 }
 
 void ESPLogger::detach() {
+	_hasLiveCallback.store(false, std::memory_order_release);
+	std::atomic_store(&_liveCallback, std::shared_ptr<const LiveCallback>());
+}
+
+void ESPLogger::setSpillStore(LogSpillStore store) {
 	LockGuard guard(_mutex);
-	_liveCallback = nullptr;
+	_spillStore = std::move(store);
 }
 
 void ESPLogger::sync() {
@@ -265,6 +673,9 @@ void ESPLogger::sync() {
 }
 
 void ESPLogger::debug(const char *tag, const char *fmt, ...) {
+	if (!isLevelEnabled(LogLevel::Debug, tag)) {
+		return;
+	}
 	va_list args;
 	va_start(args, fmt);
 	logInternal(LogLevel::Debug, tag, fmt, args);
@@ -272,6 +683,9 @@ void ESPLogger::debug(const char *tag, const char *fmt, ...) {
 }
 
 void ESPLogger::info(const char *tag, const char *fmt, ...) {
+	if (!isLevelEnabled(LogLevel::Info, tag)) {
+		return;
+	}
 	va_list args;
 	va_start(args, fmt);
 	logInternal(LogLevel::Info, tag, fmt, args);
@@ -279,6 +693,9 @@ void ESPLogger::info(const char *tag, const char *fmt, ...) {
 }
 
 void ESPLogger::warn(const char *tag, const char *fmt, ...) {
+	if (!isLevelEnabled(LogLevel::Warn, tag)) {
+		return;
+	}
 	va_list args;
 	va_start(args, fmt);
 	logInternal(LogLevel::Warn, tag, fmt, args);
@@ -286,76 +703,130 @@ void ESPLogger::warn(const char *tag, const char *fmt, ...) {
 }
 
 void ESPLogger::error(const char *tag, const char *fmt, ...) {
+	if (!isLevelEnabled(LogLevel::Error, tag)) {
+		return;
+	}
 	va_list args;
 	va_start(args, fmt);
 	logInternal(LogLevel::Error, tag, fmt, args);
 	va_end(args);
 }
 
+LogEntryBuilder ESPLogger::debug(const char *tag) {
+	ESPLogger *target = isLevelEnabled(LogLevel::Debug, tag) ? this : nullptr;
+	return LogEntryBuilder(target, LogLevel::Debug, tag);
+}
+
+LogEntryBuilder ESPLogger::info(const char *tag) {
+	ESPLogger *target = isLevelEnabled(LogLevel::Info, tag) ? this : nullptr;
+	return LogEntryBuilder(target, LogLevel::Info, tag);
+}
+
+LogEntryBuilder ESPLogger::warn(const char *tag) {
+	ESPLogger *target = isLevelEnabled(LogLevel::Warn, tag) ? this : nullptr;
+	return LogEntryBuilder(target, LogLevel::Warn, tag);
+}
+
+LogEntryBuilder ESPLogger::error(const char *tag) {
+	ESPLogger *target = isLevelEnabled(LogLevel::Error, tag) ? this : nullptr;
+	return LogEntryBuilder(target, LogLevel::Error, tag);
+}
+
+void LogEntryBuilder::emit() {
+	if (_logger == nullptr) {
+		return;
+	}
+	_logger->logFields(_level, _tag, std::move(_fields));
+	_logger = nullptr;
+}
+
 #if ESPLOGGER_HAS_ARDUINOJSON_V7
 void ESPLogger::debug(const char *tag, const ArduinoJson::JsonDocument &json) {
-	logMessage(
-	    LogLevel::Debug,
-	    tag,
-	    serializeJsonMessage(json.as<ArduinoJson::JsonVariantConst>())
-	);
+	logJson(LogLevel::Debug, tag, json.as<ArduinoJson::JsonVariantConst>());
 }
 
 void ESPLogger::info(const char *tag, const ArduinoJson::JsonDocument &json) {
-	logMessage(LogLevel::Info, tag, serializeJsonMessage(json.as<ArduinoJson::JsonVariantConst>()));
+	logJson(LogLevel::Info, tag, json.as<ArduinoJson::JsonVariantConst>());
 }
 
 void ESPLogger::warn(const char *tag, const ArduinoJson::JsonDocument &json) {
-	logMessage(LogLevel::Warn, tag, serializeJsonMessage(json.as<ArduinoJson::JsonVariantConst>()));
+	logJson(LogLevel::Warn, tag, json.as<ArduinoJson::JsonVariantConst>());
 }
 
 void ESPLogger::error(const char *tag, const ArduinoJson::JsonDocument &json) {
-	logMessage(
-	    LogLevel::Error,
-	    tag,
-	    serializeJsonMessage(json.as<ArduinoJson::JsonVariantConst>())
-	);
+	logJson(LogLevel::Error, tag, json.as<ArduinoJson::JsonVariantConst>());
 }
 
 void ESPLogger::debug(const char *tag, ArduinoJson::JsonVariantConst json) {
-	logMessage(LogLevel::Debug, tag, serializeJsonMessage(json));
+	logJson(LogLevel::Debug, tag, json);
 }
 
 void ESPLogger::info(const char *tag, ArduinoJson::JsonVariantConst json) {
-	logMessage(LogLevel::Info, tag, serializeJsonMessage(json));
+	logJson(LogLevel::Info, tag, json);
 }
 
 void ESPLogger::warn(const char *tag, ArduinoJson::JsonVariantConst json) {
-	logMessage(LogLevel::Warn, tag, serializeJsonMessage(json));
+	logJson(LogLevel::Warn, tag, json);
 }
 
 void ESPLogger::error(const char *tag, ArduinoJson::JsonVariantConst json) {
-	logMessage(LogLevel::Error, tag, serializeJsonMessage(json));
+	logJson(LogLevel::Error, tag, json);
+}
+
+void ESPLogger::logJson(LogLevel level, const char *tag, ArduinoJson::JsonVariantConst json) {
+	// Gate before serializing: a disabled level should not pay for the serializer.
+	if (!isLevelEnabled(level, tag)) {
+		return;
+	}
+	if (_deferJson.load(std::memory_order_relaxed) &&
+	    _initialized.load(std::memory_order_acquire) && !printsAtLogTime(level)) {
+		// MessagePack is close to a straight copy of the variant; the text (pretty or
+		// compact per `usePrettyJson` at that point) is produced when the record is rendered.
+		LogRecord record = makeRecord(level, tag);
+		record.format = kMsgPackFormat;
+		LogStringWriter writer(record.payload);
+		if (ArduinoJson::serializeMsgPack(json, writer) > 0) {
+			storeRecord(std::move(record));
+			return;
+		}
+	}
+	logMessage(level, tag, serializeJsonMessage(json));
 }
 #endif
 
 std::vector<Log> ESPLogger::getAllLogs() {
 	LockGuard guard(_mutex);
-	return std::vector<Log>(_logs.begin(), _logs.end());
+	drainRingLocked();
+	std::vector<Log> result;
+	result.reserve(recordCountLocked());
+	forEachRecordLocked([this, &result](const auto &record) {
+		result.push_back(toLog(record));
+	});
+	return result;
 }
 
 int ESPLogger::getLogCount(LogLevel level) {
 	LockGuard guard(_mutex);
-	return static_cast<int>(std::count_if(_logs.begin(), _logs.end(), [level](const Log &entry) {
-		return entry.level == level;
-	}));
+	drainRingLocked();
+	int matches = 0;
+	forEachRecordLocked([level, &matches](const auto &record) {
+		if (record.level == level) {
+			++matches;
+		}
+	});
+	return matches;
 }
 
 std::vector<Log> ESPLogger::getLogs(LogLevel level) {
 	LockGuard guard(_mutex);
+	drainRingLocked();
 	std::vector<Log> matches;
-	matches.reserve(_logs.size());
-	std::copy_if(
-	    _logs.begin(),
-	    _logs.end(),
-	    std::back_inserter(matches),
-	    [level](const Log &entry) { return entry.level == level; }
-	);
+	matches.reserve(recordCountLocked());
+	forEachRecordLocked([this, level, &matches](const auto &record) {
+		if (record.level == level) {
+			matches.push_back(toLog(record));
+		}
+	});
 	return matches;
 }
 
@@ -374,26 +845,39 @@ std::vector<Log> ESPLogger::getLogs(const std::vector<Log> &logs, LogLevel level
 	return matches;
 }
 
+int ESPLogger::getLogCount(LogBatchView logs, LogLevel level) {
+	return static_cast<int>(std::count_if(logs.begin(), logs.end(), [level](const Log &entry) {
+		return entry.level == level;
+	}));
+}
+
+std::vector<Log> ESPLogger::getLogs(LogBatchView logs, LogLevel level) {
+	std::vector<Log> matches;
+	matches.reserve(logs.size());
+	std::copy_if(logs.begin(), logs.end(), std::back_inserter(matches), [level](const Log &entry) {
+		return entry.level == level;
+	});
+	return matches;
+}
+
 std::vector<Log> ESPLogger::getLastLogs(size_t count) {
 	LockGuard guard(_mutex);
-	if (count == 0 || _logs.empty()) {
+	drainRingLocked();
+	const size_t available = recordCountLocked();
+	if (count == 0 || available == 0) {
 		return {};
 	}
 
-	const size_t available = _logs.size();
-	if (count >= available) {
-		return std::vector<Log>(_logs.begin(), _logs.end());
-	}
+	const size_t startIndex = count >= available ? 0 : available - count;
 
 	std::vector<Log> result;
-	result.reserve(count);
-	const size_t startIndex = available - count;
+	result.reserve(available - startIndex);
 	size_t index = 0;
-	for (const auto &entry : _logs) {
+	forEachRecordLocked([this, startIndex, &index, &result](const auto &record) {
 		if (index++ >= startIndex) {
-			result.push_back(entry);
+			result.push_back(toLog(record));
 		}
-	}
+	});
 	return result;
 }
 
@@ -409,157 +893,1048 @@ void ESPLogger::setLogLevel(LogLevel level) {
 }
 
 LogLevel ESPLogger::logLevel() const {
+	return _logLevel.load(std::memory_order_relaxed);
+}
+
+void ESPLogger::setCaptureLevel(LogLevel level) {
 	LockGuard guard(_mutex);
-	return _logLevel;
+	_captureLevel.store(level, std::memory_order_relaxed);
+	_config.captureLevel = level;
+}
+
+LogLevel ESPLogger::captureLevel() const {
+	return _captureLevel.load(std::memory_order_relaxed);
+}
+
+bool ESPLogger::setTagLevel(const char *tag, LogLevel level) {
+	if (!_initialized.load(std::memory_order_acquire) || tag == nullptr) {
+		return false;
+	}
+	const uint16_t id = _tags->intern(tag);
+	if (id == LogTagRegistry::kOverflowId) {
+		return false;
+	}
+	const uint8_t previous = _tagLevels[id].exchange(static_cast<uint8_t>(level));
+	if (previous == kNoTagLevel) {
+		_tagLevelCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+void ESPLogger::clearTagLevel(const char *tag) {
+	if (!_initialized.load(std::memory_order_acquire) || tag == nullptr) {
+		return;
+	}
+	const uint16_t id = _tags->find(tag);
+	if (id == LogTagRegistry::kOverflowId) {
+		return;
+	}
+	if (_tagLevels[id].exchange(kNoTagLevel) != kNoTagLevel) {
+		_tagLevelCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+void ESPLogger::clearTagLevels() {
+	if (!_initialized.load(std::memory_order_acquire)) {
+		return;
+	}
+	for (size_t id = 0; id < _tags->capacity(); ++id) {
+		if (_tagLevels[id].exchange(kNoTagLevel) != kNoTagLevel) {
+			_tagLevelCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+bool ESPLogger::tagLevelEnabled(LogLevel level, const char *tag) const {
+	// Overrides exist only while initialized, so the registry is live here. Interning hits
+	// the lock-free pointer cache for every call site after its first line.
+	const uint16_t id = _tags->intern(tag);
+	const uint8_t tagLevel =
+	    id != LogTagRegistry::kOverflowId ? _tagLevels[id].load(std::memory_order_relaxed)
+	                                      : kNoTagLevel;
+	const int threshold = tagLevel != kNoTagLevel
+	                          ? tagLevel
+	                          : static_cast<int>(_captureLevel.load(std::memory_order_relaxed));
+	return static_cast<int>(level) >= threshold;
 }
 
 void ESPLogger::logInternal(LogLevel level, const char *tag, const char *fmt, va_list args) {
-	if (fmt == nullptr) {
+	if (fmt == nullptr || !_initialized.load(std::memory_order_acquire)) {
 		return;
 	}
 
-	va_list argsForMessage;
-	va_copy(argsForMessage, args);
-	std::string message = formatMessage(fmt, argsForMessage);
-	va_end(argsForMessage);
+	if (_deferFormatting.load(std::memory_order_relaxed) && fmt[0] != '\0' &&
+	    !printsAtLogTime(level) && logger_deferred_detail::isStaticFormat(fmt)) {
+		LogRecord record = makeRecord(level, tag);
+		record.format = fmt;
+		if (logger_deferred_detail::packArguments(fmt, args, record.payload)) {
+			// Console output for deferred records happens when the sync path renders them.
+			storeRecord(std::move(record));
+			return;
+		}
+	}
 
-	logMessage(level, tag, std::move(message));
+	logMessage(level, tag, logger_format_detail::formatMessage(fmt, args));
 }
 
 void ESPLogger::logMessage(LogLevel level, const char *tag, std::string message) {
-	if (message.empty()) {
+	if (message.empty() || !_initialized.load(std::memory_order_acquire)) {
 		return;
 	}
 
-	Log entry{
-	    level,
-	    tag != nullptr ? tag : "",
-	    static_cast<uint32_t>(millis()),
-	    std::time(nullptr),
-	    std::move(message)
-	};
+	LogRecord record = makeRecord(level, tag);
+	record.payload = std::move(message);
+
+	// Console output happens before the record is moved into the buffer so the message
+	// never has to be copied just to print it.
+	if (static_cast<int>(level) >= static_cast<int>(_logLevel.load(std::memory_order_relaxed))) {
+		logToConsole(
+		    level,
+		    tag != nullptr ? tag : "",
+		    record.millis,
+		    record.timestamp,
+		    record.payload
+		);
+	}
+
+	storeRecord(std::move(record));
+}
 
-	bool shouldLogToConsole = false;
-	bool shouldInvokeLiveCallback = false;
-	LiveCallback liveCallback;
+void ESPLogger::logFields(LogLevel level, const char *tag, std::string fields) {
+	if (fields.empty() || !_initialized.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	// Stored like a deferred record: the fields are rendered, and printed to the console,
+	// only when the sync path or a query turns the record into a `Log`. Without a sync task
+	// the console line is printed now, and the record keeps its fields for the batch.
+	LogRecord record = makeRecord(level, tag);
+	record.format = logger_fields_detail::kFieldsFormat;
+	record.payload = std::move(fields);
+	if (printsAtLogTime(level)) {
+		const Log entry = toLog(record);
+		logToConsole(entry.level, entry.tag.c_str(), entry.millis, entry.timestamp, entry.message);
+		record.printed = true;
+	}
+	storeRecord(std::move(record));
+}
+
+// Unrendered records reach the console when the sync path renders them, which without a
+// sync task only happens on a manual sync(). Records the console shows are then printed as
+// they are logged instead.
+bool ESPLogger::printsAtLogTime(LogLevel level) const {
+	return _syncTask.load(std::memory_order_acquire) == nullptr &&
+	       static_cast<int>(level) >= static_cast<int>(_logLevel.load(std::memory_order_relaxed));
+}
+
+LogRecord ESPLogger::makeRecord(LogLevel level, const char *tag) {
+	LogRecord record;
+	record.level = level;
+	record.tagId = _tags->intern(tag);
+	if (record.tagId == LogTagRegistry::kOverflowId) {
+		record.tag = tag != nullptr ? tag : "";
+	}
+	record.millis = static_cast<uint32_t>(millis());
+	record.timestamp = std::time(nullptr);
+	return record;
+}
+
+void ESPLogger::storeRecord(LogRecord record) {
+	if (!_initialized.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	std::shared_ptr<const LiveCallback> liveCallback;
+	if (_hasLiveCallback.load(std::memory_order_acquire)) {
+		liveCallback = std::atomic_load(&_liveCallback);
+	}
 	Log liveEntry;
+	if (liveCallback) {
+		liveEntry = toLog(record);
+	}
 
-	{
+	bool wakeSync = static_cast<int>(record.level) >=
+	                static_cast<int>(_syncTriggerLevel.load(std::memory_order_relaxed));
+	if (_ring) {
+		pushToRing(std::move(record));
+		const size_t percent = _syncWatermarkPercent.load(std::memory_order_relaxed);
+		wakeSync = wakeSync ||
+		           (percent > 0 && _ring->sizeApprox() * 100 >= _ring->capacity() * percent);
+	} else {
+		if (_overflowPolicy.load(std::memory_order_relaxed) == LogOverflowPolicy::Block) {
+			waitForRoom(record);
+		}
 		LockGuard guard(_mutex);
 		if (!_initialized) {
 			return;
 		}
 
-		shouldLogToConsole = static_cast<int>(level) >= static_cast<int>(_logLevel);
+		if (makeRoomLocked(record)) {
+			retainRecordLocked(record);
+			appendRecordLocked(std::move(record));
+		}
+		wakeSync = wakeSync || aboveWatermarkLocked();
+	}
 
-		if (_logs.size() >= _config.maxLogInRam) {
-			_logs.pop_front();
+	if (wakeSync) {
+		requestSync();
+	}
+	if (liveCallback) {
+		invokeLiveCallback(*liveCallback, liveEntry);
+	}
+}
+
+bool ESPLogger::aboveWatermarkLocked() const {
+	const size_t percent = _syncWatermarkPercent.load(std::memory_order_relaxed);
+	if (percent == 0) {
+		return false;
+	}
+	if (_mapped) {
+		const uint64_t oldest = std::max(_mappedCursor, _mapped->tailCursor());
+		const uint64_t pending = _mapped->headCursor() - oldest;
+		return pending * 100 >= _mapped->capacityBytes() * percent;
+	}
+	if (_arena) {
+		return _arena->usedBytes() * 100 >= _arena->capacityBytes() * percent;
+	}
+	return _logs.size() * 100 >= _config.maxLogInRam * percent;
+}
+
+bool ESPLogger::bufferFullLocked(const LogRecord &record) const {
+	if (_mapped) {
+		// The mapped ring makes room by bytes on its own.
+		return false;
+	}
+	if (_arena) {
+		return _arena->count() > 0 && !_arena->fits(arenaView(record));
+	}
+	return _logs.size() >= _config.maxLogInRam;
+}
+
+// Block policy: waits without the logger mutex until a sync makes room or
+// `overflowBlockMS` passes; makeRoomLocked then drops the entry if it is still full.
+void ESPLogger::waitForRoom(const LogRecord &record) {
+	TaskHandle_t syncTask = _syncTask.load(std::memory_order_acquire);
+	if (syncTask != nullptr && xTaskGetCurrentTaskHandle() == syncTask) {
+		// Only the sync task makes room, so it must not wait for itself.
+		return;
+	}
+
+	const TickType_t start = xTaskGetTickCount();
+	bool woken = false;
+	for (;;) {
+		TickType_t timeout = 0;
+		{
+			LockGuard guard(_mutex);
+			if (!_initialized || !bufferFullLocked(record)) {
+				break;
+			}
+			timeout = pdMS_TO_TICKS(_config.overflowBlockMS);
+		}
+		requestSync();
+		const TickType_t waited = xTaskGetTickCount() - start;
+		if (waited >= timeout || xSemaphoreTake(_roomAvailable, timeout - waited) != pdPASS) {
+			return;
 		}
+		woken = true;
+	}
+	if (woken) {
+		// A sync wakes a single waiter; pass it on to any other blocked producer.
+		xSemaphoreGive(_roomAvailable);
+	}
+}
 
-		_logs.emplace_back(entry);
+// Applies the overflow policy before `record` is stored. Returns false when the policy
+// drops `record` itself.
+bool ESPLogger::makeRoomLocked(const LogRecord &record) {
+	if (!bufferFullLocked(record)) {
+		return true;
+	}
+	if (_spillStore.write) {
+		while (bufferFullLocked(record)) {
+			spillOldestLocked(spillBatchLocked());
+		}
+		return true;
+	}
 
-		if (_liveCallback) {
-			shouldInvokeLiveCallback = true;
-			liveCallback = _liveCallback;
-			liveEntry = _logs.back();
+	switch (_config.overflowPolicy) {
+	case LogOverflowPolicy::DropNewest:
+	case LogOverflowPolicy::Block:
+		dropRecord(record);
+		return false;
+	case LogOverflowPolicy::DropLowestLevel:
+		if (!_arena) {
+			return evictLowestLevelLocked(&record);
 		}
+		// Arena records cannot be removed from the middle of the region.
+		break;
+	case LogOverflowPolicy::DropOldest:
+		if (!_arena && hasReservesLocked()) {
+			return evictLowestLevelLocked(&record);
+		}
+		break;
+	}
+	while (bufferFullLocked(record)) {
+		evictOldestLocked();
 	}
+	return true;
+}
 
-	if (shouldLogToConsole) {
-		logToConsole(level, entry.tag.c_str(), entry.millis, entry.timestamp, entry.message);
+// Brings the deque down to `maxLogInRam` after it shrank: spilled when a spill store is
+// set, otherwise evicted as an overflow would, honoring the per-level reserves.
+void ESPLogger::shrinkLocked() {
+	if (_logs.size() > _config.maxLogInRam && _spillStore.write) {
+		spillOldestLocked(_logs.size() - _config.maxLogInRam);
+	}
+	const bool byLevel =
+	    _config.overflowPolicy == LogOverflowPolicy::DropLowestLevel || hasReservesLocked();
+	while (_logs.size() > _config.maxLogInRam) {
+		if (byLevel) {
+			evictLowestLevelLocked(nullptr);
+		} else {
+			evictOldestLocked();
+		}
 	}
+}
 
-	if (shouldInvokeLiveCallback) {
-		invokeLiveCallback(liveCallback, liveEntry);
+void ESPLogger::evictOldestLocked() {
+	if (_arena) {
+		ArenaRecordView view;
+		if (_arena->front(view)) {
+			dropRecord(view);
+			_arena->popFront();
+		}
+		return;
+	}
+	if (!_logs.empty()) {
+		dropRecord(_logs.front());
+		_logs.pop_front();
 	}
 }
 
-std::string ESPLogger::formatMessage(const char *fmt, va_list args) {
-	if (fmt == nullptr) {
-		return {};
+bool ESPLogger::hasReservesLocked() const {
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		if (_config.reservedPerLevel[level] > 0) {
+			return true;
+		}
 	}
+	return false;
+}
 
-	va_list args_copy;
-	va_copy(args_copy, args);
-	int required = vsnprintf(nullptr, 0, fmt, args_copy);
-	va_end(args_copy);
+// Evicts the oldest entry of the lowest level holding more than its reserve, counting the
+// incoming entry (if any) in its own level, so one chatty level cycles through its share of
+// the deque instead of the whole buffer. Returns false when the incoming entry is the one to
+// drop. Each level has its own FIFO, so the victim is a pop_front() rather than a search.
+bool ESPLogger::evictLowestLevelLocked(const LogRecord *incoming) {
+	if (_logs.empty()) {
+		return true;
+	}
 
-	if (required <= 0) {
-		return {};
+	const size_t incomingLevel =
+	    incoming != nullptr ? static_cast<size_t>(incoming->level) : kLogLevelCount - 1;
+	size_t held[kLogLevelCount];
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		held[level] = _logs.count(level) + (incoming != nullptr && level == incomingLevel);
 	}
+	size_t victimLevel = kLogLevelCount;
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		if (held[level] > _config.reservedPerLevel[level]) {
+			victimLevel = level;
+			break;
+		}
+	}
+	if (victimLevel == kLogLevelCount) {
+		// The reserves add up to more than the buffer; fall back to the lowest level held.
+		victimLevel = incomingLevel;
+		for (size_t level = 0; level < incomingLevel; ++level) {
+			if (held[level] > 0) {
+				victimLevel = level;
+				break;
+			}
+		}
+	}
+	if (_logs.count(victimLevel) == 0) {
+		if (incoming != nullptr) {
+			dropRecord(*incoming);
+		}
+		return false;
+	}
+
+	dropRecord(_logs.front(victimLevel));
+	_logs.pop_front(victimLevel);
+	return true;
+}
+
+void ESPLogger::countDropped(LogLevel level, uint32_t count) {
+	_droppedCount[static_cast<size_t>(level)].fetch_add(count, std::memory_order_relaxed);
+}
+
+// Counts a record lost to overflow. Deferred, structured and MessagePack records only reach
+// the console when they are rendered, so one dropped unrendered is printed here instead.
+template <typename Record> void ESPLogger::dropRecord(const Record &record) {
+	countDropped(record.level);
+	const LogLevel consoleLevel = _logLevel.load(std::memory_order_relaxed);
+	if (record.format == nullptr || record.printed ||
+	    static_cast<int>(record.level) < static_cast<int>(consoleLevel)) {
+		return;
+	}
+	const Log entry = toLog(record);
+	logToConsole(entry.level, entry.tag.c_str(), entry.millis, entry.timestamp, entry.message);
+}
+
+// Builds the "N entries dropped" notice for drops not announced yet. Called by the sync
+// path with `_syncMutex` held.
+bool ESPLogger::takeDropNotice(Log &notice) {
+	uint32_t total = 0;
+	std::string detail;
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		const uint32_t dropped = _droppedCount[level].load(std::memory_order_relaxed);
+		const uint32_t pending = dropped - _droppedReported[level];
+		_droppedReported[level] = dropped;
+		if (pending == 0) {
+			continue;
+		}
+		total += pending;
+		detail += detail.empty() ? " (" : ", ";
+		detail += std::string(kLevelNames[level]) + " " + std::to_string(pending);
+	}
+	if (total == 0) {
+		return false;
+	}
+
+	notice =
+	    Log{LogLevel::Warn, kDropNoticeTag, static_cast<uint32_t>(millis()), {}, {}, {}, false};
+	notice.timestamp = std::time(nullptr);
+	notice.message = std::to_string(total) + (total == 1 ? " entry" : " entries") + " dropped" +
+	                 detail + ")";
+	return true;
+}
+
+void ESPLogger::requestSync() {
+	// One notification per batch is enough; performSync re-arms the trigger.
+	TaskHandle_t task = _syncTask.load(std::memory_order_acquire);
+	if (task == nullptr || _syncRequested.exchange(true, std::memory_order_acq_rel)) {
+		return;
+	}
+	_syncTriggerCount.fetch_add(1, std::memory_order_relaxed);
+	xTaskNotifyGive(task);
+}
+
+void ESPLogger::pushToRing(LogRecord record) {
+	// Producers never wait: when the ring is full they either drop the new entry or evict
+	// the ring's oldest one themselves. Block and DropLowestLevel only apply to the buffer
+	// the ring drains into.
+	const LogOverflowPolicy policy = _overflowPolicy.load(std::memory_order_relaxed);
+	const bool dropNewest = policy == LogOverflowPolicy::DropNewest ||
+	                        policy == LogOverflowPolicy::Block;
+	while (!_ring->tryPush(record)) {
+		if (dropNewest) {
+			dropRecord(record);
+			return;
+		}
+		LogRecord evicted;
+		if (_ring->tryPop(evicted)) {
+			dropRecord(evicted);
+		}
+	}
+}
+
+void ESPLogger::drainRingLocked() {
+	if (!_ring) {
+		return;
+	}
+
+	LogRecord record;
+	while (_ring->tryPop(record)) {
+		if (makeRoomLocked(record)) {
+			retainRecordLocked(record);
+			appendRecordLocked(std::move(record));
+		}
+	}
+}
 
-	InternalCharVector buffer(static_cast<size_t>(required) + 1, '\0', _charAllocator);
+void ESPLogger::appendRecordLocked(LogRecord &&record) {
+	if (_mapped) {
+		copyToRing(*_mapped, record);
+		++_mappedPending;
+		return;
+	}
+	// makeRoomLocked() has already applied the overflow policy.
+	if (!_arena) {
+		_logs.push_back(std::move(record));
+		return;
+	}
 
-	va_list args_copy2;
-	va_copy(args_copy2, args);
-	vsnprintf(buffer.data(), buffer.size(), fmt, args_copy2);
-	va_end(args_copy2);
+	if (_arena->append(arenaView(record)) >= 0) {
+		return;
+	}
 
-	return std::string(buffer.data(), static_cast<size_t>(required));
+	// The record is larger than the whole arena: keep its (rendered) head rather than
+	// dropping it outright. Rendering it here is also its only chance at the console.
+	if (record.format != nullptr) {
+		Log rendered;
+		renderEntryMessage(rendered, record.format, std::move(record.payload));
+		if (!record.printed && static_cast<int>(record.level) >=
+		                           static_cast<int>(_logLevel.load(std::memory_order_relaxed))) {
+			logToConsole(
+			    record.level,
+			    tagName(record).c_str(),
+			    record.millis,
+			    record.timestamp,
+			    rendered.message
+			);
+		}
+		record.payload = std::move(rendered.message);
+		record.format = nullptr;
+	}
+	record.payload.resize(std::min(record.payload.size(), _arena->maxPayloadFor(0)));
+	_arena->append(arenaView(record));
+}
+
+size_t ESPLogger::spillBatchLocked() const {
+	if (_config.spillBatch > 0) {
+		return _config.spillBatch;
+	}
+	return std::max<size_t>(1, recordCountLocked() / 4);
 }
 
+// Renders the `count` oldest buffered records and hands them to the spill store as one
+// batch. Entries the store does not keep are dropped, which is what overflow did before.
+void ESPLogger::spillOldestLocked(size_t count) {
+	const LogLevel consoleLevel = _logLevel.load(std::memory_order_relaxed);
+	std::vector<Log> batch;
+	batch.reserve(count);
+	while (batch.size() < count) {
+		bool unprinted = false;
+		if (_arena) {
+			ArenaRecordView view;
+			if (!_arena->front(view)) {
+				break;
+			}
+			unprinted = view.format != nullptr && !view.printed;
+			batch.push_back(toLog(view));
+			_arena->popFront();
+		} else {
+			if (_logs.empty()) {
+				break;
+			}
+			unprinted = _logs.front().format != nullptr && !_logs.front().printed;
+			batch.push_back(toLog(std::move(_logs.front())));
+			_logs.pop_front();
+		}
+
+		// Deferred records print when rendered, and these will not be rendered again.
+		const Log &entry = batch.back();
+		if (unprinted && static_cast<int>(entry.level) >= static_cast<int>(consoleLevel)) {
+			logToConsole(
+			    entry.level,
+			    entry.tag.c_str(),
+			    entry.millis,
+			    entry.timestamp,
+			    entry.message
+			);
+		}
+	}
+
+	size_t kept = 0;
+#if defined(__cpp_exceptions)
+	try {
+		kept = _spillStore.write(LogBatchView(batch.data(), batch.size()));
+	} catch (...) {
+		kept = 0;
+	}
+#else
+	kept = _spillStore.write(LogBatchView(batch.data(), batch.size()));
+#endif
+	kept = std::min(kept, batch.size());
+	for (size_t index = 0; index < batch.size(); ++index) {
+		if (index < kept) {
+			++_spillPending[static_cast<size_t>(batch[index].level)];
+		} else {
+			countDropped(batch[index].level);
+		}
+	}
+	_spilledCount.fetch_add(static_cast<uint32_t>(kept), std::memory_order_relaxed);
+	_spillFailedCount.fetch_add(
+	    static_cast<uint32_t>(batch.size() - kept),
+	    std::memory_order_relaxed
+	);
+}
+
+void ESPLogger::retainRecordLocked(const LogRecord &record) {
+	if (_retained) {
+		copyToRing(*_retained, record);
+	}
+}
+
+void ESPLogger::copyToRing(LogRetainedRing &ring, const LogRecord &record) const {
+	RetainedKind kind = RetainedKind::Printf;
+	std::string_view format;
+	if (record.format == nullptr) {
+		kind = RetainedKind::Text;
+	} else if (record.format == logger_fields_detail::kFieldsFormat) {
+		kind = RetainedKind::Fields;
 #if ESPLOGGER_HAS_ARDUINOJSON_V7
-std::string ESPLogger::serializeJsonMessage(ArduinoJson::JsonVariantConst json) const {
-	const bool usePrettyJson = _config.usePrettyJson;
-	const size_t required =
-	    usePrettyJson ? ArduinoJson::measureJsonPretty(json) : ArduinoJson::measureJson(json);
+	} else if (record.format == kMsgPackFormat) {
+		kind = RetainedKind::MsgPack;
+#endif
+	} else {
+		format = record.format;
+	}
+	ring.append(
+	    record.level,
+	    kind,
+	    record.millis,
+	    record.timestamp,
+	    tagName(record),
+	    format,
+	    record.payload,
+	    record.printed
+	);
+}
 
-	if (required == 0) {
-		return {};
+size_t ESPLogger::recordCountLocked() const {
+	if (_mapped) {
+		// Pending records are the newest ones, so evictions only cut into them once every
+		// older record is gone.
+		return std::min(_mappedPending, _mapped->count());
+	}
+	return _arena ? _arena->count() : _logs.size();
+}
+
+template <typename Fn> void ESPLogger::forEachRecordLocked(Fn &&fn) const {
+	if (_mapped) {
+		std::string records;
+		uint64_t cursor = _mappedCursor;
+		_mapped->copySince(cursor, records);
+		LogRetainedRing::forEachRecord(records, [&fn](const RetainedRecordView &view) {
+			fn(ringRecordView(view));
+		});
+		return;
+	}
+	if (_arena) {
+		_arena->forEach(fn);
+		return;
+	}
+	_logs.forEach(fn);
+}
+
+void ESPLogger::retireRecordsLocked() {
+	// Both buffers are owned by the logger, so retiring the live one is a pointer swap and
+	// producers never wait on a copy of the batch. The mapped ring is the exception: its
+	// pending bytes are copied out, one memcpy per contiguous record run.
+	if (_mapped) {
+		_retiredMapped.clear();
+		_mapped->copySince(_mappedCursor, _retiredMapped);
+		_mappedPending = 0;
+		return;
+	}
+	if (_arena) {
+		std::swap(_arena, _retiredArena);
+		_arena->clear();
+		return;
+	}
+	_logs.swap(_retiredLogs);
+}
+
+template <typename Fn> void ESPLogger::forEachRetiredRecord(Fn &&fn) {
+	if (!_retiredMapped.empty()) {
+		LogRetainedRing::forEachRecord(_retiredMapped, [&fn](const RetainedRecordView &view) {
+			ArenaRecordView record = ringRecordView(view);
+			fn(record);
+		});
+		return;
+	}
+	if (_retiredArena && _retiredArena->count() > 0) {
+		_retiredArena->forEach(fn);
+		return;
+	}
+	_retiredLogs.forEach(fn);
+}
+
+void ESPLogger::clearRetiredRecords() {
+	_retiredMapped.clear();
+	if (_retiredArena) {
+		_retiredArena->clear();
 	}
+	_retiredLogs.clear();
+}
+
+// Records retired by a flush whose task was abandoned in a handler were never delivered;
+// the next flush counts them as dropped before it retires its own batch.
+void ESPLogger::dropRetiredRecords() {
+	forEachRetiredRecord([this](const auto &record) { countDropped(record.level); });
+	clearRetiredRecords();
+}
 
-	InternalCharVector buffer(required + 1, '\0', _charAllocator);
-	const size_t written =
-	    usePrettyJson ? ArduinoJson::serializeJsonPretty(json, buffer.data(), buffer.size())
-	                  : ArduinoJson::serializeJson(json, buffer.data(), buffer.size());
+ArenaRecordView ESPLogger::arenaView(const LogRecord &record) {
+	// Arena records reference the interned tag id; only tags the registry had no room for
+	// are stored inline.
+	ArenaRecordView view;
+	view.level = record.level;
+	view.millis = record.millis;
+	view.timestamp = record.timestamp;
+	view.format = record.format;
+	view.printed = record.printed;
+	view.tagId = record.tagId;
+	if (record.tagId == LogTagRegistry::kOverflowId) {
+		view.tag = record.tag.data();
+		view.tagLength = record.tag.size();
+	}
+	view.payload = record.payload.data();
+	view.payloadLength = record.payload.size();
+	return view;
+}
 
+// Fills in the message of an entry whose payload may still be unrendered: packed printf
+// arguments for deferred records, encoded fields for structured ones, or MessagePack for
+// deferred JSON.
+void ESPLogger::renderEntryMessage(Log &entry, const char *format, std::string payload) const {
+	if (format == nullptr) {
+		entry.message = std::move(payload);
+	} else if (format == logger_fields_detail::kFieldsFormat) {
+		entry.message = logFieldsToText(payload);
+		entry.fields = std::move(payload);
+#if ESPLOGGER_HAS_ARDUINOJSON_V7
+	} else if (format == kMsgPackFormat) {
+		entry.message = renderMsgPackMessage(payload);
+#endif
+	} else {
+		entry.message = logger_deferred_detail::renderMessage(format, payload);
+	}
+}
+
+const std::string &ESPLogger::tagName(const LogRecord &record) const {
+	return record.tagId == LogTagRegistry::kOverflowId ? record.tag : _tags->name(record.tagId);
+}
+
+Log ESPLogger::toLog(const LogRecord &record) const {
+	Log entry{record.level, tagName(record), record.millis, record.timestamp, {}, {}, false};
+	renderEntryMessage(entry, record.format, record.payload);
+	return entry;
+}
+
+Log ESPLogger::toLog(const ArenaRecordView &view) const {
+	Log entry{view.level, {}, view.millis, view.timestamp, {}, {}, false};
+	entry.tag =
+	    view.tag != nullptr ? std::string(view.tag, view.tagLength) : _tags->name(view.tagId);
+	renderEntryMessage(entry, view.format, std::string(view.payload, view.payloadLength));
+	return entry;
+}
+
+Log ESPLogger::toLog(LogRecord &&record) const {
+	Log entry{record.level, {}, record.millis, record.timestamp, {}, {}, false};
+	entry.tag = record.tagId == LogTagRegistry::kOverflowId ? std::move(record.tag)
+	                                                        : _tags->name(record.tagId);
+	renderEntryMessage(entry, record.format, std::move(record.payload));
+	return entry;
+}
+
+#if ESPLOGGER_HAS_ARDUINOJSON_V7
+std::string ESPLogger::serializeJsonMessage(ArduinoJson::JsonVariantConst json) const {
+	// Single pass: the writer grows the returned string in place and ArduinoJson reports
+	// the length, so there is no measure pass and no staging buffer to copy out of.
+	std::string message;
+	LogStringWriter writer(message);
+	const size_t written = _usePrettyJson.load(std::memory_order_relaxed)
+	                           ? ArduinoJson::serializeJsonPretty(json, writer)
+	                           : ArduinoJson::serializeJson(json, writer);
 	if (written == 0) {
 		return {};
 	}
+	return message;
+}
 
-	return std::string(buffer.data(), written);
+std::string ESPLogger::renderMsgPackMessage(const std::string &packed) const {
+	ArduinoJson::JsonDocument document;
+	if (ArduinoJson::deserializeMsgPack(document, packed.data(), packed.size())) {
+		return {};
+	}
+	return serializeJsonMessage(document.as<ArduinoJson::JsonVariantConst>());
 }
 #endif
 
-void ESPLogger::performSync() {
+// Materializes the retired records straight into the container handed to the sync
+// callback, moving each payload so message text is never duplicated. A null `batch` only
+// drains console output.
+template <typename Batch> void ESPLogger::renderSyncBatch(size_t count, Batch *batch) {
+	// Deferred records are rendered here, which is also where their console output is
+	// drained; immediate records were already printed by the caller.
+	const LogLevel consoleLevel = _logLevel.load(std::memory_order_relaxed);
+	if (batch != nullptr) {
+		batch->reserve(count);
+	}
+	forEachRetiredRecord([this, consoleLevel, batch](auto &record) {
+		const bool printDeferred = record.format != nullptr && !record.printed &&
+		                           static_cast<int>(record.level) >= static_cast<int>(consoleLevel);
+		if (batch == nullptr && !printDeferred) {
+			return;
+		}
+
+		Log entry = toLog(std::move(record));
+		if (printDeferred) {
+			logToConsole(
+			    entry.level,
+			    entry.tag.c_str(),
+			    entry.millis,
+			    entry.timestamp,
+			    entry.message
+			);
+		}
+		if (batch != nullptr) {
+			batch->push_back(std::move(entry));
+		}
+	});
+}
+
+// Runs `fn`, which may block outside the logger's control, in the Blocked phase of `task`
+// (if any). Returns false when stopSyncTask() gave up on the task meanwhile; the caller
+// must then return without touching the logger.
+template <typename Fn> bool ESPLogger::runBlocking(SyncTaskControl *task, Fn &&fn) {
+	if (task == nullptr) {
+		fn();
+		return true;
+	}
+	task->phase.store(SyncTaskControl::Blocked, std::memory_order_release);
+	fn();
+	return task->enter(SyncTaskControl::Blocked, SyncTaskControl::Busy);
+}
+
+void ESPLogger::performSync(SyncTaskControl *task) {
+	// Serializes flushes so the retired buffer has a single reader; producers never take it.
+	// Another flush may be inside a slow handler, so the wait counts as blocking.
+	std::optional<LockGuard> syncGuard;
+	const SemaphoreHandle_t syncMutex = _syncMutex;
+	if (!runBlocking(task, [&syncGuard, syncMutex] { syncGuard.emplace(syncMutex); })) {
+		return;
+	}
+	dropRetiredRecords();
 	SyncCallback callback;
-	InternalLogVector logsSnapshot(_logAllocator);
+	SyncViewCallback viewCallback;
+	size_t count = 0;
+	uint32_t lockHoldMicros = 0;
+	std::vector<Log> previousBoot;
+	LogSpillStore spillStore;
+	size_t spilled[kLogLevelCount] = {};
+	size_t spilledCount = 0;
 
 	{
 		LockGuard guard(_mutex);
-		if (_logs.empty()) {
+		const unsigned long lockedAt = micros();
+		_syncRequested.store(false, std::memory_order_relaxed);
+		drainRingLocked();
+		callback = _syncCallback;
+		viewCallback = _syncViewCallback;
+		if (callback || viewCallback) {
+			previousBoot.swap(_previousBootLogs);
+			// Entries spilled after this point are newer than the batch retired below, so
+			// they wait for the next sync.
+			for (size_t level = 0; level < kLogLevelCount; ++level) {
+				spilled[level] = _spillPending[level];
+				spilledCount += spilled[level];
+				_spillPending[level] = 0;
+			}
+			if (spilledCount > 0) {
+				spillStore = _spillStore;
+			}
+		}
+		count = recordCountLocked();
+		if (count == 0 && previousBoot.empty() && spilledCount == 0) {
 			return;
 		}
 
-		callback = _syncCallback;
-		if (!callback) {
-			_logs.clear();
+		if (_retained && (callback || viewCallback) && (count > 0 || spilledCount > 0)) {
+			// Everything retained so far is in this batch, so it is not replayed again.
+			_retained->clear();
+		}
+		if (count > 0) {
+			retireRecordsLocked();
+			// Wake a producer waiting under the Block policy.
+			xSemaphoreGive(_roomAvailable);
+		}
+		lockHoldMicros = static_cast<uint32_t>(micros() - lockedAt);
+	}
+
+	// The previous boot's entries go out first, as a batch of their own. After every
+	// handler a task that stopSyncTask() gave up on returns at once: the logger it belongs
+	// to may have been released or already handed to the next task.
+	if (!previousBoot.empty() && !runBlocking(task, [&] {
+		    if (viewCallback) {
+			    invokeSyncCallback(
+			        viewCallback,
+			        LogBatchView(previousBoot.data(), previousBoot.size())
+			    );
+		    } else {
+			    invokeSyncCallback(callback, previousBoot);
+		    }
+	    })) {
+		return;
+	}
+	// Then the spilled entries, which are older than anything still buffered.
+	if (spilledCount > 0 && spillStore.read) {
+		const bool current = viewCallback
+		                         ? deliverSpilled(spillStore, spilled, viewCallback, task)
+		                         : deliverSpilled(spillStore, spilled, callback, task);
+		if (!current) {
 			return;
 		}
-		logsSnapshot.reserve(_logs.size());
-		std::move(_logs.begin(), _logs.end(), std::back_inserter(logsSnapshot));
-		_logs.clear();
 	}
+	if (count == 0) {
+		return;
+	}
+
+	_syncCount.fetch_add(1, std::memory_order_relaxed);
+	_lastSyncBatchSize.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+	_lastSyncLockHoldMicros.store(lockHoldMicros, std::memory_order_relaxed);
+	if (lockHoldMicros > _maxSyncLockHoldMicros.load(std::memory_order_relaxed)) {
+		_maxSyncLockHoldMicros.store(lockHoldMicros, std::memory_order_relaxed);
+	}
+
+	// Drops since the last delivered batch are announced at its start.
+	Log dropNotice;
+	const bool hasDropNotice = (callback || viewCallback) && takeDropNotice(dropNotice);
+	if (viewCallback) {
+		InternalLogVector batch(_logAllocator);
+		if (hasDropNotice) {
+			batch.reserve(count + 1);
+			batch.push_back(std::move(dropNotice));
+		}
+		renderSyncBatch(count, &batch);
+		clearRetiredRecords();
+		runBlocking(task, [&] {
+			invokeSyncCallback(viewCallback, LogBatchView(batch.data(), batch.size()));
+		});
+	} else if (callback) {
+		// Compatibility path: the public signature fixes the container type, so build it
+		// directly instead of staging through a logger-allocated vector first.
+		std::vector<Log> batch;
+		if (hasDropNotice) {
+			batch.reserve(count + 1);
+			batch.push_back(std::move(dropNotice));
+		}
+		renderSyncBatch(count, &batch);
+		clearRetiredRecords();
+		runBlocking(task, [&] { invokeSyncCallback(callback, batch); });
+	} else {
+		renderSyncBatch(count, static_cast<InternalLogVector *>(nullptr));
+		clearRetiredRecords();
+	}
+}
 
-	std::vector<Log> callbackLogs(logsSnapshot.begin(), logsSnapshot.end());
-	invokeSyncCallback(callback, callbackLogs);
+// Reads spilled entries back in batches of at most `maxLogInRam`, so replaying a long
+// outage never holds the whole backlog in memory. `pending` holds the spilled entries
+// still expected, by level; whatever the store cannot return is counted as dropped.
+// Returns false when the sync task was abandoned in the store or a handler.
+template <typename Callback>
+bool ESPLogger::deliverSpilled(
+    const LogSpillStore &store,
+    size_t (&pending)[kLogLevelCount],
+    const Callback &callback,
+    SyncTaskControl *task
+) {
+	const size_t batchSize = std::max<size_t>(1, _config.maxLogInRam);
+	size_t count = 0;
+	for (const size_t left : pending) {
+		count += left;
+	}
+	std::vector<Log> batch;
+	while (count > 0) {
+		batch.clear();
+		size_t read = 0;
+		if (!runBlocking(task, [&] { read = store.read(std::min(batchSize, count), batch); })) {
+			return false;
+		}
+		if (read == 0 || batch.empty()) {
+			// The store lost entries (e.g. a damaged file); what is left is gone too. They
+			// show up in the stats and in the next drop notice.
+			for (size_t level = 0; level < kLogLevelCount; ++level) {
+				const uint32_t lost = static_cast<uint32_t>(pending[level]);
+				if (lost > 0) {
+					countDropped(static_cast<LogLevel>(level), lost);
+				}
+			}
+			return true;
+		}
+		for (const Log &entry : batch) {
+			size_t &left = pending[static_cast<size_t>(entry.level)];
+			left -= std::min<size_t>(left, 1);
+		}
+		count -= std::min(read, count);
+		const bool current = runBlocking(task, [&] {
+			if constexpr (std::is_same<Callback, SyncViewCallback>::value) {
+				invokeSyncCallback(callback, LogBatchView(batch.data(), batch.size()));
+			} else {
+				invokeSyncCallback(callback, batch);
+			}
+		});
+		if (!current) {
+			return false;
+		}
+	}
+	return true;
 }
 
-void ESPLogger::syncTaskThunk(void *arg) {
-	auto *instance = static_cast<ESPLogger *>(arg);
-	if (instance != nullptr) {
-		instance->syncTaskLoop();
+LoggerStats ESPLogger::getStats() const {
+	LoggerStats stats;
+	stats.syncCount = _syncCount.load(std::memory_order_relaxed);
+	stats.lastSyncBatchSize = _lastSyncBatchSize.load(std::memory_order_relaxed);
+	stats.lastSyncLockHoldMicros = _lastSyncLockHoldMicros.load(std::memory_order_relaxed);
+	stats.maxSyncLockHoldMicros = _maxSyncLockHoldMicros.load(std::memory_order_relaxed);
+	stats.syncTriggerCount = _syncTriggerCount.load(std::memory_order_relaxed);
+	stats.spilledCount = _spilledCount.load(std::memory_order_relaxed);
+	stats.spillFailedCount = _spillFailedCount.load(std::memory_order_relaxed);
+	for (size_t level = 0; level < kLogLevelCount; ++level) {
+		stats.droppedCount[level] = _droppedCount[level].load(std::memory_order_relaxed);
 	}
+	return stats;
 }
 
-void ESPLogger::syncTaskLoop() {
-	while (_running) {
-		vTaskDelay(pdMS_TO_TICKS(_config.syncIntervalMS));
-		if (!_running) {
+void ESPLogger::syncTaskThunk(void *arg) {
+	auto *task = static_cast<SyncTaskControl *>(arg);
+	task->logger->syncTaskLoop(task);
+	vTaskDelete(nullptr);
+}
+
+void ESPLogger::syncTaskLoop(SyncTaskControl *task) {
+	TickType_t wait = pdMS_TO_TICKS(_syncIntervalMS.load(std::memory_order_relaxed));
+	for (;;) {
+		// Producers notify on watermark or severity triggers; the interval is only a ceiling.
+		ulTaskNotifyTake(pdTRUE, wait);
+		if (!task->enter(SyncTaskControl::Idle, SyncTaskControl::Busy)) {
+			// stopSyncTask() gave up waiting and deletes this task and `task`.
+			return;
+		}
+		if (!task->running.load(std::memory_order_acquire)) {
 			break;
 		}
-		performSync();
+		if (!_intervalChanged.exchange(false, std::memory_order_acq_rel) ||
+		    _syncRequested.load(std::memory_order_acquire)) {
+			performSync(task);
+			if (task->phase.load(std::memory_order_acquire) == SyncTaskControl::Abandoned) {
+				// The logger may be gone; `task` now belongs to this task alone.
+				delete task;
+				return;
+			}
+		}
+		wait = pdMS_TO_TICKS(_syncIntervalMS.load(std::memory_order_relaxed));
+		task->phase.store(SyncTaskControl::Idle, std::memory_order_release);
 	}
-	_syncTask = nullptr;
-	vTaskDelete(nullptr);
+	// Still Busy, so stopSyncTask() is waiting for this and frees `task` once it is given.
+	xSemaphoreGive(task->done);
+}
+
+SyncViewCallback binarySyncCallback(
+    std::function<void(const std::string &)> sink,
+    size_t maxTags,
+    size_t maxTemplates
+) {
+	auto encoder = std::make_shared<LogBinaryEncoder>(maxTags, maxTemplates);
+	return [encoder, sink = std::move(sink)](LogBatchView batch) {
+		if (!sink || batch.empty()) {
+			return;
+		}
+		std::string bytes;
+		encoder->encodeBatch(batch, bytes);
+		sink(bytes);
+	};
 }
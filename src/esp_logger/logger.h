@@ -1,9 +1,10 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include <cstdarg>
+#include <cstddef>
 #include <ctime>
-#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -29,7 +30,16 @@
 #endif
 
 #include "esp_logger/logger_allocator.h"
+#include "esp_logger/logger_arena.h"
+#include "esp_logger/logger_binary.h"
 #include "esp_logger/logger_config.h"
+#include "esp_logger/logger_fields.h"
+#include "esp_logger/logger_fmt.h"
+#include "esp_logger/logger_mapped.h"
+#include "esp_logger/logger_queue.h"
+#include "esp_logger/logger_retained.h"
+#include "esp_logger/logger_ring.h"
+#include "esp_logger/logger_tags.h"
 
 struct Log {
 	LogLevel level;
@@ -37,28 +47,168 @@ struct Log {
 	uint32_t millis;
 	std::time_t timestamp;
 	std::string message;
+	// Encoded key/value fields of entries built with `kv()`, empty otherwise. `message`
+	// holds their text rendering; see LogFieldReader and logFieldsToJson for typed access.
+	std::string fields;
+	// Recovered from `retainedBuffer` after a reset; delivered ahead of this boot's entries.
+	bool previousBoot = false;
+};
+
+// Buffered entry as stored internally. The tag is an id into the logger's tag registry,
+// or its text in `tag` when the registry was full (`tagId` is then kOverflowId).
+// Deferred records keep the caller's format pointer and carry packed printf arguments in
+// `payload` until they are rendered into a `Log`.
+struct LogRecord {
+	LogLevel level = LogLevel::Debug;
+	uint16_t tagId = 0;
+	std::string tag;
+	uint32_t millis = 0;
+	std::time_t timestamp = 0;
+	std::string payload;
+	const char *format = nullptr;
+	bool printed = false; // Unrendered, but already written to the console when logged
+};
+
+// Read-only view over one drained sync batch. The entries live in logger-owned storage
+// (PSRAM when `usePSRAMBuffers` is set) and are only valid for the duration of the callback.
+class LogBatchView {
+  public:
+	using value_type = Log;
+	using const_iterator = const Log *;
+
+	LogBatchView() = default;
+	LogBatchView(const Log *data, size_t size) : _data(data), _size(size) {
+	}
+
+	const Log *begin() const {
+		return _data;
+	}
+	const Log *end() const {
+		return _data + _size;
+	}
+	const Log *data() const {
+		return _data;
+	}
+	size_t size() const {
+		return _size;
+	}
+	bool empty() const {
+		return _size == 0;
+	}
+	const Log &operator[](size_t index) const {
+		return _data[index];
+	}
+	const Log &front() const {
+		return _data[0];
+	}
+	const Log &back() const {
+		return _data[_size - 1];
+	}
+
+  private:
+	const Log *_data = nullptr;
+	size_t _size = 0;
+};
+
+// Counters describing the sync path. The lock hold time covers the part of a flush that
+// blocks producers on the logger mutex; it stays flat as the buffer grows because the
+// batch is retired by swapping buffers rather than moving entries.
+struct LoggerStats {
+	uint32_t syncCount = 0;
+	uint32_t lastSyncBatchSize = 0;
+	uint32_t lastSyncLockHoldMicros = 0;
+	uint32_t maxSyncLockHoldMicros = 0;
+	uint32_t syncTriggerCount = 0; // Early wake-ups requested by producers
+	uint32_t spilledCount = 0;     // Entries moved to the spill store instead of dropped
+	uint32_t spillFailedCount = 0; // Entries the spill store refused; those were dropped
+	uint32_t droppedCount[kLogLevelCount] = {}; // Entries lost to overflow, by LogLevel
+};
+
+// Secondary storage for entries a full buffer would otherwise drop; see
+// ESPLogger::setSpillStore. `write` runs on the logging task with the logger mutex held and
+// `read` on the sync path without it, so an implementation must be safe to call from both.
+// LogMemorySpill and LogFileStore::spillStore() provide one.
+struct LogSpillStore {
+	// Stores the oldest buffered entries, in order, and returns how many of them it kept;
+	// the entries after that count are dropped.
+	std::function<size_t(LogBatchView batch)> write;
+	// Removes up to `maxCount` of the oldest stored entries, appending them to `out`, and
+	// returns how many it appended.
+	std::function<size_t(size_t maxCount, std::vector<Log> &out)> read;
+};
+
+class ESPLogger;
+
+// Returned by the single-argument `debug/info/warn/error(tag)` overloads. Each `kv()`
+// appends one typed field to the record being built; `emit()` stores it. When the level
+// is disabled the builder is inert and `kv()` does no work.
+class LogEntryBuilder {
+  public:
+	LogEntryBuilder(ESPLogger *logger, LogLevel level, const char *tag)
+	    : _logger(logger), _level(level), _tag(tag) {
+	}
+
+	template <typename T> [[nodiscard]] LogEntryBuilder &kv(const char *key, const T &value) {
+		static_assert(
+		    logger_fmt_detail::argKind<T>() != logger_fmt_detail::ArgKind::Unsupported,
+		    "kv: field type cannot be encoded"
+		);
+		if (_logger != nullptr) {
+			logger_fields_detail::appendField(_fields, key, logger_fmt_detail::makeArg(value));
+		}
+		return *this;
+	}
+
+	void emit();
+
+  private:
+	ESPLogger *_logger;
+	LogLevel _level;
+	const char *_tag;
+	std::string _fields;
 };
 
 using SyncCallback = std::function<void(const std::vector<Log> &)>;
+using SyncViewCallback = std::function<void(LogBatchView)>;
 using LiveCallback = std::function<void(const Log &)>;
-using InternalLogDeque = std::deque<Log, LoggerAllocator<Log>>;
+using InternalLogQueue = LogLevelQueue<LogRecord, kLogLevelCount>;
 using InternalCharVector = std::vector<char, LoggerAllocator<char>>;
 using InternalLogVector = std::vector<Log, LoggerAllocator<Log>>;
+using InternalLogRing = LogRing<LogRecord>;
 
 class ESPLogger {
   public:
+	// Tag of the synthetic Warn entry that opens a synced batch after entries were dropped,
+	// e.g. "12 entries dropped (debug 10, info 2)".
+	static constexpr const char *kDropNoticeTag = "ESPLogger";
+
 	ESPLogger() = default;
 	~ESPLogger();
 
 	bool init(const LoggerConfig &config = LoggerConfig{});
+	// Applies `config` without tearing down: buffered entries (newest first when shrinking),
+	// callbacks and the sync task are kept; the task is only recreated when its core or
+	// stack size changes. Returns false and changes nothing if `usePSRAMBuffers`,
+	// `useLockFreeRing`, `maxTags`, the retained buffer, the mapped file or arena mode on/off
+	// differ; those need `init()`.
+	bool reconfigure(const LoggerConfig &config);
 	void deinit();
 	bool isInitialized() const {
-		return _initialized;
+		return _initialized.load(std::memory_order_acquire);
 	}
 
+	// Registering either sync callback replaces the other. The view overload hands over
+	// the drained batch without copying it into a `std::vector<Log>`.
 	void onSync(SyncCallback callback);
+	void onSync(SyncViewCallback callback);
+	void onSync(std::nullptr_t);
 	void attach(LiveCallback callback);
 	void detach();
+	// When the buffer is full, moves its oldest `spillBatch` entries to `store` instead of
+	// dropping the oldest one. Spilled entries are read back at the next sync with a
+	// callback and delivered ahead of the buffered batch, in order. Not used by the
+	// lock-free ring itself or by mapped storage. Pass an empty store to turn it off.
+	void setSpillStore(LogSpillStore store);
 
 	void sync();
 
@@ -78,38 +228,248 @@ class ESPLogger {
 	void error(const char *tag, ArduinoJson::JsonVariantConst json);
 #endif
 
+	// Structured entries: `info("NET").kv("rssi", -61).kv("ip", ip).emit()`. Fields are
+	// stored in binary form and rendered to text (or JSON, on request) by consumers.
+	[[nodiscard]] LogEntryBuilder debug(const char *tag);
+	[[nodiscard]] LogEntryBuilder info(const char *tag);
+	[[nodiscard]] LogEntryBuilder warn(const char *tag);
+	[[nodiscard]] LogEntryBuilder error(const char *tag);
+
+	// `{}`-style overloads taking an ESPLOGGER_FMT literal, e.g.
+	// `info("NET", ESPLOGGER_FMT("rssi={} ip={}"), rssi, ip)`. Placeholders are checked
+	// against the argument types at compile time and the message is written without
+	// vsnprintf. See logger_fmt.h for the supported specs.
+	template <typename Format, typename... Args, logger_fmt_detail::EnableIfFormat<Format> = 0>
+	void debug(const char *tag, Format format, const Args &...args) {
+		logFormatted(LogLevel::Debug, tag, format, args...);
+	}
+	template <typename Format, typename... Args, logger_fmt_detail::EnableIfFormat<Format> = 0>
+	void info(const char *tag, Format format, const Args &...args) {
+		logFormatted(LogLevel::Info, tag, format, args...);
+	}
+	template <typename Format, typename... Args, logger_fmt_detail::EnableIfFormat<Format> = 0>
+	void warn(const char *tag, Format format, const Args &...args) {
+		logFormatted(LogLevel::Warn, tag, format, args...);
+	}
+	template <typename Format, typename... Args, logger_fmt_detail::EnableIfFormat<Format> = 0>
+	void error(const char *tag, Format format, const Args &...args) {
+		logFormatted(LogLevel::Error, tag, format, args...);
+	}
+
 	std::vector<Log> getAllLogs();
 	int getLogCount(LogLevel level);
 	std::vector<Log> getLogs(LogLevel level);
 	static int getLogCount(const std::vector<Log> &logs, LogLevel level);
 	static std::vector<Log> getLogs(const std::vector<Log> &logs, LogLevel level);
+	static int getLogCount(LogBatchView logs, LogLevel level);
+	static std::vector<Log> getLogs(LogBatchView logs, LogLevel level);
 	std::vector<Log> getLastLogs(size_t count);
 
+	// True when `level` is compiled in (ESPLOGGER_MIN_LEVEL) and at or above the runtime
+	// capture level, or the per-tag override for `tag` when any are set. Without overrides
+	// this is one relaxed load; once any are set, a call with a tag also interns it and reads
+	// its override. The ESPLOGGER_* macros call it before evaluating arguments.
+	bool isLevelEnabled(LogLevel level, const char *tag = nullptr) const {
+		if (static_cast<int>(level) < ESPLOGGER_MIN_LEVEL) {
+			return false;
+		}
+		if (_tagLevelCount.load(std::memory_order_relaxed) != 0 && tag != nullptr) {
+			return tagLevelEnabled(level, tag);
+		}
+		return static_cast<int>(level) >=
+		       static_cast<int>(_captureLevel.load(std::memory_order_relaxed));
+	}
+
 	LoggerConfig currentConfig() const;
+	LoggerStats getStats() const;
 	void setLogLevel(LogLevel level);
 	LogLevel logLevel() const;
+	void setCaptureLevel(LogLevel level);
+	LogLevel captureLevel() const;
+	// Per-tag capture level that replaces `captureLevel` for that tag. Returns false when
+	// the logger is not initialized or the tag table (`maxTags`) is full.
+	bool setTagLevel(const char *tag, LogLevel level);
+	void clearTagLevel(const char *tag);
+	void clearTagLevels();
 
   private:
+	friend class LogEntryBuilder;
+	struct SyncTaskControl;
+
+	void setTaskConfig(const LoggerConfig &config);
+	void applyRuntimeSettings();
+	bool startSyncTask();
+	void stopSyncTask();
+	bool createStorage();
+	void releaseStorage();
+	void recoverRetained();
 	void logInternal(LogLevel level, const char *tag, const char *fmt, va_list args);
 	void logMessage(LogLevel level, const char *tag, std::string message);
-	std::string formatMessage(const char *fmt, va_list args);
+	void logFields(LogLevel level, const char *tag, std::string fields);
+	template <typename Format, typename... Args>
+	void logFormatted(LogLevel level, const char *tag, Format, const Args &...args) {
+		logger_fmt_detail::checkFormat<Format, Args...>();
+		if (!isLevelEnabled(level, tag)) {
+			return;
+		}
+		logMessage(level, tag, logger_fmt_detail::format(Format::value(), args...));
+	}
+	bool tagLevelEnabled(LogLevel level, const char *tag) const;
+	bool printsAtLogTime(LogLevel level) const;
+	LogRecord makeRecord(LogLevel level, const char *tag);
+	void storeRecord(LogRecord record);
+	bool aboveWatermarkLocked() const;
+	bool bufferFullLocked(const LogRecord &record) const;
+	void waitForRoom(const LogRecord &record);
+	bool makeRoomLocked(const LogRecord &record);
+	void shrinkLocked();
+	void evictOldestLocked();
+	bool hasReservesLocked() const;
+	bool evictLowestLevelLocked(const LogRecord *incoming);
+	void countDropped(LogLevel level, uint32_t count = 1);
+	template <typename Record> void dropRecord(const Record &record);
+	bool takeDropNotice(Log &notice);
+	void requestSync();
+	void pushToRing(LogRecord record);
+	void drainRingLocked();
+	void appendRecordLocked(LogRecord &&record);
+	size_t spillBatchLocked() const;
+	void spillOldestLocked(size_t count);
+	template <typename Callback>
+	bool deliverSpilled(
+	    const LogSpillStore &store,
+	    size_t (&pending)[kLogLevelCount],
+	    const Callback &callback,
+	    SyncTaskControl *task
+	);
+	void retainRecordLocked(const LogRecord &record);
+	void copyToRing(LogRetainedRing &ring, const LogRecord &record) const;
+	size_t recordCountLocked() const;
+	template <typename Fn> void forEachRecordLocked(Fn &&fn) const;
+	void retireRecordsLocked();
+	template <typename Fn> void forEachRetiredRecord(Fn &&fn);
+	void clearRetiredRecords();
+	void dropRetiredRecords();
+	static ArenaRecordView arenaView(const LogRecord &record);
+	void renderEntryMessage(Log &entry, const char *format, std::string payload) const;
+	const std::string &tagName(const LogRecord &record) const;
+	Log toLog(const LogRecord &record) const;
+	Log toLog(const ArenaRecordView &view) const;
+	Log toLog(LogRecord &&record) const;
 #if ESPLOGGER_HAS_ARDUINOJSON_V7
+	void logJson(LogLevel level, const char *tag, ArduinoJson::JsonVariantConst json);
 	std::string serializeJsonMessage(ArduinoJson::JsonVariantConst json) const;
+	std::string renderMsgPackMessage(const std::string &packed) const;
 #endif
-	void performSync();
+	template <typename Batch> void renderSyncBatch(size_t count, Batch *batch);
+	void performSync(SyncTaskControl *task = nullptr);
+	template <typename Fn> static bool runBlocking(SyncTaskControl *task, Fn &&fn);
 	static void syncTaskThunk(void *arg);
-	void syncTaskLoop();
+	void syncTaskLoop(SyncTaskControl *task);
 
 	LoggerConfig _config{};
-	bool _initialized = false;
-	bool _running = false;
-	TaskHandle_t _syncTask = nullptr;
+	std::atomic<bool> _initialized{false};
+	std::atomic<TaskHandle_t> _syncTask{nullptr};
+	// Owned by the logger until stopSyncTask() abandons the task, then by the task.
+	SyncTaskControl *_taskControl = nullptr;
+	// An abandoned task may still hold `_syncMutex`, so it is leaked instead of deleted.
+	bool _syncTaskAbandoned = false;
 	SemaphoreHandle_t _mutex = nullptr;
-	InternalLogDeque _logs;
+	SemaphoreHandle_t _syncMutex = nullptr;
+	SemaphoreHandle_t _roomAvailable = nullptr; // Given after each sync for Block producers
+	InternalLogQueue _logs;
+	InternalLogQueue _retiredLogs;
+	std::unique_ptr<InternalLogRing> _ring;
+	std::unique_ptr<LogArena> _arena;
+	std::unique_ptr<LogArena> _retiredArena;
+	// Mapped storage mode: the live ring is in the file, the sync path copies pending
+	// records out of it into `_retiredMapped`.
+	std::unique_ptr<LogMappedFile> _mappedFile;
+	std::unique_ptr<LogRetainedRing> _mapped;
+	uint64_t _mappedCursor = 0; // First record not yet handed to the sync path
+	size_t _mappedPending = 0;  // Appended since the last retire, before evictions
+	std::string _retiredMapped;
+	std::unique_ptr<LogTagRegistry> _tags;
+	std::unique_ptr<LogRetainedRing> _retained;
+	std::vector<Log> _previousBootLogs; // Held until a sync callback is registered
+	LogSpillStore _spillStore;
+	size_t _spillPending[kLogLevelCount] = {}; // Spilled, not yet read back, by level
+	// Indexed by tag id; 0xFF means the tag follows `captureLevel`.
+	std::unique_ptr<std::atomic<uint8_t>[]> _tagLevels;
+	std::atomic<size_t> _tagLevelCount{0};
 	SyncCallback _syncCallback;
-	LiveCallback _liveCallback;
-	LogLevel _logLevel = LogLevel::Debug;
+	SyncViewCallback _syncViewCallback;
+	std::shared_ptr<const LiveCallback> _liveCallback;
+	std::atomic<bool> _hasLiveCallback{false};
+	std::atomic<LogLevel> _logLevel{LogLevel::Debug};
+	std::atomic<LogLevel> _captureLevel{LogLevel::Debug};
+	std::atomic<bool> _deferFormatting{false};
+	std::atomic<bool> _deferJson{false};
+	std::atomic<bool> _usePrettyJson{true};
+	std::atomic<uint32_t> _syncIntervalMS{0};
+	std::atomic<bool> _intervalChanged{false};
+	std::atomic<bool> _syncRequested{false};
+	std::atomic<uint8_t> _syncWatermarkPercent{0};
+	std::atomic<LogLevel> _syncTriggerLevel{LogLevel::Error};
+	std::atomic<uint32_t> _syncTriggerCount{0};
+	std::atomic<uint32_t> _syncCount{0};
+	std::atomic<uint32_t> _lastSyncBatchSize{0};
+	std::atomic<uint32_t> _lastSyncLockHoldMicros{0};
+	std::atomic<uint32_t> _maxSyncLockHoldMicros{0};
+	std::atomic<uint32_t> _spilledCount{0};
+	std::atomic<uint32_t> _spillFailedCount{0};
+	std::atomic<uint32_t> _droppedCount[kLogLevelCount] = {};
+	uint32_t _droppedReported[kLogLevelCount] = {}; // Already announced; guarded by _syncMutex
+	std::atomic<LogOverflowPolicy> _overflowPolicy{LogOverflowPolicy::DropOldest};
 	bool _usePSRAMBuffers = false;
 	LoggerAllocator<Log> _logAllocator{};
-	LoggerAllocator<char> _charAllocator{};
 };
+
+// Sync callback that encodes each drained batch with one LogBinaryEncoder and hands the
+// bytes to `sink` (file append, UART, socket). The encoder, and so its dictionaries, live
+// as long as the callback; the first batch starts with the stream header.
+SyncViewCallback binarySyncCallback(
+    std::function<void(const std::string &)> sink,
+    size_t maxTags = LogBinaryEncoder::kDefaultMaxTags,
+    size_t maxTemplates = LogBinaryEncoder::kDefaultMaxTemplates
+);
+
+// Call-site macros that compile to nothing, arguments included, below ESPLOGGER_MIN_LEVEL
+// and skip argument evaluation when the level is disabled at runtime. `logger` and `tag`
+// are evaluated exactly once.
+#define ESPLOGGER_LOG_AT(logger, level, method, tag, ...)                                          \
+	do {                                                                                           \
+		auto &&esplogger_logger_ = (logger);                                                       \
+		const char *const esplogger_tag_ = (tag);                                                  \
+		if (esplogger_logger_.isLevelEnabled(level, esplogger_tag_)) {                             \
+			esplogger_logger_.method(esplogger_tag_, __VA_ARGS__);                                 \
+		}                                                                                          \
+	} while (0)
+
+#if ESPLOGGER_MIN_LEVEL <= 0
+#define ESPLOGGER_DEBUG(logger, tag, ...)                                                          \
+	ESPLOGGER_LOG_AT(logger, LogLevel::Debug, debug, tag, __VA_ARGS__)
+#else
+#define ESPLOGGER_DEBUG(logger, tag, ...) ((void)0)
+#endif
+
+#if ESPLOGGER_MIN_LEVEL <= 1
+#define ESPLOGGER_INFO(logger, tag, ...)                                                           \
+	ESPLOGGER_LOG_AT(logger, LogLevel::Info, info, tag, __VA_ARGS__)
+#else
+#define ESPLOGGER_INFO(logger, tag, ...) ((void)0)
+#endif
+
+#if ESPLOGGER_MIN_LEVEL <= 2
+#define ESPLOGGER_WARN(logger, tag, ...)                                                           \
+	ESPLOGGER_LOG_AT(logger, LogLevel::Warn, warn, tag, __VA_ARGS__)
+#else
+#define ESPLOGGER_WARN(logger, tag, ...) ((void)0)
+#endif
+
+#if ESPLOGGER_MIN_LEVEL <= 3
+#define ESPLOGGER_ERROR(logger, tag, ...)                                                          \
+	ESPLOGGER_LOG_AT(logger, LogLevel::Error, error, tag, __VA_ARGS__)
+#else
+#define ESPLOGGER_ERROR(logger, tag, ...) ((void)0)
+#endif
@@ -0,0 +1,236 @@
+#include "esp_logger/logger_arena.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kFlagPadding = 0x01;
+constexpr uint8_t kFlagDeferred = 0x02;
+// `tagLength` holds an interned tag id and no tag bytes follow the header.
+constexpr uint8_t kFlagTagId = 0x04;
+// An unrendered record that was already written to the console when it was logged.
+constexpr uint8_t kFlagPrinted = 0x08;
+
+struct RecordHeader {
+	uint32_t size;
+	uint8_t flags;
+	uint8_t level;
+	uint16_t tagLength;
+	uint32_t millis;
+	uint32_t payloadLength;
+	int64_t timestamp;
+	uintptr_t format;
+};
+
+constexpr size_t kHeaderSize = sizeof(RecordHeader);
+
+size_t alignUp(size_t value) {
+	return (value + LogArena::kAlignment - 1) & ~(LogArena::kAlignment - 1);
+}
+
+} // namespace
+
+LogArena::LogArena(size_t capacityBytes, bool usePSRAMBuffers) : _allocator(usePSRAMBuffers) {
+	_capacity = alignUp(capacityBytes < 2 * kHeaderSize ? 2 * kHeaderSize : capacityBytes);
+#if defined(__cpp_exceptions)
+	try {
+		_data = _allocator.allocate(_capacity);
+	} catch (...) {
+		_data = nullptr;
+		_capacity = 0;
+	}
+#else
+	_data = _allocator.allocate(_capacity);
+#endif
+}
+
+LogArena::~LogArena() {
+	if (_data != nullptr) {
+		_allocator.deallocate(_data, _capacity);
+	}
+}
+
+size_t LogArena::recordSize(size_t tagLength, size_t payloadLength) {
+	return alignUp(kHeaderSize + tagLength + payloadLength);
+}
+
+size_t LogArena::maxPayloadFor(size_t tagLength) const {
+	const size_t overhead = kHeaderSize + tagLength;
+	return _capacity > overhead ? _capacity - overhead : 0;
+}
+
+int LogArena::append(const ArenaRecordView &record) {
+	const size_t tagLength = record.tag != nullptr ? record.tagLength : 0;
+	if (_data == nullptr || tagLength > UINT16_MAX) {
+		return -1;
+	}
+	const size_t size = recordSize(tagLength, record.payloadLength);
+	if (size > _capacity) {
+		return -1;
+	}
+
+	int evicted = 0;
+	for (;;) {
+		if (_count == 0) {
+			_head = 0;
+			_tail = 0;
+			_used = 0;
+		}
+
+		const bool full = _used > 0 && _tail == _head;
+		if (_tail >= _head && !full) {
+			if (_capacity - _tail >= size) {
+				break;
+			}
+			if (_head >= size) {
+				// Not enough room before the end of the region: pad it out and wrap.
+				writePadding(_tail, _capacity - _tail);
+				_used += _capacity - _tail;
+				_tail = 0;
+				continue;
+			}
+		} else if (_head - _tail >= size) {
+			break;
+		}
+
+		evictOldest();
+		++evicted;
+	}
+
+	RecordHeader header{};
+	header.size = static_cast<uint32_t>(size);
+	header.flags = record.format != nullptr ? kFlagDeferred : 0;
+	header.level = static_cast<uint8_t>(record.level);
+	if (record.tag != nullptr) {
+		header.tagLength = static_cast<uint16_t>(tagLength);
+	} else {
+		header.flags |= kFlagTagId;
+		header.tagLength = record.tagId;
+	}
+	if (record.printed) {
+		header.flags |= kFlagPrinted;
+	}
+	header.millis = record.millis;
+	header.payloadLength = static_cast<uint32_t>(record.payloadLength);
+	header.timestamp = static_cast<int64_t>(record.timestamp);
+	header.format = reinterpret_cast<uintptr_t>(record.format);
+
+	uint8_t *target = _data + _tail;
+	std::memcpy(target, &header, kHeaderSize);
+	if (tagLength > 0) {
+		std::memcpy(target + kHeaderSize, record.tag, tagLength);
+	}
+	if (record.payloadLength > 0) {
+		std::memcpy(target + kHeaderSize + tagLength, record.payload, record.payloadLength);
+	}
+
+	_tail += size;
+	if (_tail == _capacity) {
+		_tail = 0;
+	}
+	_used += size;
+	++_count;
+	return evicted;
+}
+
+bool LogArena::fits(const ArenaRecordView &record) const {
+	const size_t tagLength = record.tag != nullptr ? record.tagLength : 0;
+	if (_data == nullptr || tagLength > UINT16_MAX) {
+		return false;
+	}
+	const size_t size = recordSize(tagLength, record.payloadLength);
+	if (_count == 0) {
+		return size <= _capacity;
+	}
+	// Same cases as append(): room before the end of the region, room after wrapping, or
+	// the gap up to the oldest record.
+	if (_tail > _head) {
+		return _capacity - _tail >= size || _head >= size;
+	}
+	return _head - _tail >= size;
+}
+
+bool LogArena::front(ArenaRecordView &out) const {
+	if (_count == 0) {
+		return false;
+	}
+	decode(skipPadding(_head), out);
+	return true;
+}
+
+bool LogArena::popFront() {
+	if (_count == 0) {
+		return false;
+	}
+	evictOldest();
+	return true;
+}
+
+void LogArena::clear() {
+	_head = 0;
+	_tail = 0;
+	_used = 0;
+	_count = 0;
+}
+
+size_t LogArena::skipPadding(size_t offset) const {
+	if (offset == _capacity) {
+		return 0;
+	}
+	RecordHeader header;
+	std::memcpy(&header, _data + offset, sizeof(header.size) + sizeof(header.flags));
+	return (header.flags & kFlagPadding) != 0 ? 0 : offset;
+}
+
+size_t LogArena::decode(size_t offset, ArenaRecordView &out) const {
+	RecordHeader header;
+	std::memcpy(&header, _data + offset, kHeaderSize);
+
+	const char *base = reinterpret_cast<const char *>(_data + offset);
+	out.level = static_cast<LogLevel>(header.level);
+	out.millis = header.millis;
+	out.timestamp = static_cast<std::time_t>(header.timestamp);
+	out.format = (header.flags & kFlagDeferred) != 0 ? reinterpret_cast<const char *>(header.format)
+	                                                 : nullptr;
+	out.printed = (header.flags & kFlagPrinted) != 0;
+	const size_t tagLength = (header.flags & kFlagTagId) != 0 ? 0 : header.tagLength;
+	out.tagId = (header.flags & kFlagTagId) != 0 ? header.tagLength : 0;
+	out.tag = (header.flags & kFlagTagId) != 0 ? nullptr : base + kHeaderSize;
+	out.tagLength = tagLength;
+	out.payload = base + kHeaderSize + tagLength;
+	out.payloadLength = header.payloadLength;
+
+	const size_t next = offset + header.size;
+	return next == _capacity ? 0 : next;
+}
+
+void LogArena::writePadding(size_t offset, size_t size) {
+	RecordHeader header{};
+	header.size = static_cast<uint32_t>(size);
+	header.flags = kFlagPadding;
+	std::memcpy(_data + offset, &header, sizeof(header.size) + sizeof(header.flags));
+}
+
+void LogArena::evictOldest() {
+	if (_count == 0) {
+		return;
+	}
+
+	RecordHeader header;
+	const size_t start = skipPadding(_head);
+	if (start != _head) {
+		_used -= _capacity - _head;
+	}
+	std::memcpy(&header, _data + start, sizeof(header.size));
+
+	_head = start + header.size;
+	if (_head == _capacity) {
+		_head = 0;
+	}
+	_used -= header.size;
+	--_count;
+
+	if (_count == 0) {
+		clear();
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "esp_logger/logger_allocator.h"
+#include "esp_logger/logger_config.h"
+
+// Read-only view of one record stored inline in a `LogArena`. Pointers stay valid until
+// the record is evicted or the arena is cleared. When `tag` is null the record refers to
+// an interned tag by `tagId` and no tag text is stored.
+struct ArenaRecordView {
+	LogLevel level = LogLevel::Debug;
+	uint32_t millis = 0;
+	std::time_t timestamp = 0;
+	const char *format = nullptr;
+	uint16_t tagId = 0;
+	const char *tag = nullptr;
+	size_t tagLength = 0;
+	const char *payload = nullptr;
+	size_t payloadLength = 0;
+	bool printed = false;
+};
+
+// Variable-length record ring over one contiguous byte region. Each record keeps its
+// header, tag and payload inline; appending evicts the oldest records until the new one
+// fits, so memory use is bounded by the region size instead of the entry count.
+class LogArena {
+  public:
+	static constexpr size_t kAlignment = 8;
+
+	LogArena(size_t capacityBytes, bool usePSRAMBuffers);
+	~LogArena();
+
+	LogArena(const LogArena &) = delete;
+	LogArena &operator=(const LogArena &) = delete;
+
+	bool valid() const {
+		return _data != nullptr;
+	}
+
+	// Appends a copy of `record`, evicting the oldest records as needed. Returns the
+	// number of evicted records, or -1 if the record can never fit.
+	int append(const ArenaRecordView &record);
+	// True when append() would store `record` without evicting anything.
+	bool fits(const ArenaRecordView &record) const;
+
+	bool front(ArenaRecordView &out) const;
+	bool popFront();
+	void clear();
+
+	size_t count() const {
+		return _count;
+	}
+	size_t usedBytes() const {
+		return _used;
+	}
+	size_t capacityBytes() const {
+		return _capacity;
+	}
+
+	// Largest payload that fits next to a tag of `tagLength` bytes in an empty arena.
+	size_t maxPayloadFor(size_t tagLength) const;
+
+	template <typename Fn> void forEach(Fn &&fn) const {
+		size_t offset = _head;
+		for (size_t index = 0; index < _count; ++index) {
+			offset = skipPadding(offset);
+			ArenaRecordView view;
+			offset = decode(offset, view);
+			fn(view);
+		}
+	}
+
+  private:
+	static size_t recordSize(size_t tagLength, size_t payloadLength);
+	size_t skipPadding(size_t offset) const;
+	size_t decode(size_t offset, ArenaRecordView &out) const;
+	void writePadding(size_t offset, size_t size);
+	void evictOldest();
+
+	LoggerAllocator<uint8_t> _allocator;
+	uint8_t *_data = nullptr;
+	size_t _capacity = 0;
+	size_t _head = 0;
+	size_t _tail = 0;
+	size_t _used = 0;
+	size_t _count = 0;
+};
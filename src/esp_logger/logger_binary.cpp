@@ -0,0 +1,428 @@
+#include "esp_logger/logger_binary.h"
+
+#include "esp_logger/logger_fields.h"
+
+namespace {
+
+constexpr char kMagic[] = {'E', 'L', 'B'};
+constexpr uint8_t kVersion = 1;
+
+constexpr uint8_t kEntryMarker = 0x80;
+constexpr uint8_t kLevelMask = 0x03;
+constexpr uint8_t kFlagNewTag = 0x04;
+constexpr uint8_t kFlagNewTemplate = 0x08;
+constexpr uint8_t kFlagTimestamp = 0x10;
+constexpr uint8_t kFlagRawMessage = 0x20;
+constexpr uint8_t kFlagFields = 0x40;
+
+constexpr char kPlaceholder = '\x01';
+// Longer messages are sent raw: they rarely repeat and would crowd out useful templates.
+constexpr size_t kMaxTemplateLength = 256;
+// Digit runs up to this length always fit in 64 bits.
+constexpr size_t kMaxNumberDigits = 18;
+
+void appendVarint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+void appendBytes(std::string &out, std::string_view bytes) {
+	appendVarint(out, bytes.size());
+	out.append(bytes.data(), bytes.size());
+}
+
+uint64_t zigzag(int64_t value) {
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Reader over a byte range; every read fails once the range is exhausted so a truncated
+// entry can be retried when more input arrives.
+class ByteReader {
+  public:
+	ByteReader(const char *cursor, const char *end) : _cursor(cursor), _end(end) {
+	}
+
+	bool byte(uint8_t &value) {
+		if (_cursor == _end) {
+			return false;
+		}
+		value = static_cast<uint8_t>(*_cursor++);
+		return true;
+	}
+
+	// Returns false with `malformed` set for varints longer than 64 bits.
+	bool varint(uint64_t &value, bool &malformed) {
+		value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			uint8_t next = 0;
+			if (!byte(next)) {
+				return false;
+			}
+			value |= static_cast<uint64_t>(next & 0x7F) << shift;
+			if ((next & 0x80) == 0) {
+				return true;
+			}
+		}
+		malformed = true;
+		return false;
+	}
+
+	bool bytes(std::string_view &value, bool &malformed) {
+		uint64_t length = 0;
+		if (!varint(length, malformed)) {
+			return false;
+		}
+		if (length > static_cast<uint64_t>(_end - _cursor)) {
+			return false;
+		}
+		value = std::string_view(_cursor, static_cast<size_t>(length));
+		_cursor += length;
+		return true;
+	}
+
+	const char *position() const {
+		return _cursor;
+	}
+
+  private:
+	const char *_cursor;
+	const char *_end;
+};
+
+// Splits `message` into a template and the numbers cut out of it. Returns false when the
+// message cannot be templated and must be sent raw.
+bool extractTemplate(std::string_view message, std::string &text, std::vector<uint64_t> &numbers) {
+	text.clear();
+	numbers.clear();
+	if (message.size() > kMaxTemplateLength) {
+		return false;
+	}
+
+	size_t index = 0;
+	while (index < message.size()) {
+		const char value = message[index];
+		if (value == kPlaceholder) {
+			return false;
+		}
+		if (value < '0' || value > '9') {
+			text.push_back(value);
+			++index;
+			continue;
+		}
+
+		size_t end = index;
+		while (end < message.size() && message[end] >= '0' && message[end] <= '9') {
+			++end;
+		}
+		const std::string_view digits = message.substr(index, end - index);
+		if ((digits.size() > 1 && digits[0] == '0') || digits.size() > kMaxNumberDigits) {
+			// Keeping these literal preserves leading zeros and avoids overflow.
+			text.append(digits.data(), digits.size());
+		} else {
+			uint64_t number = 0;
+			for (const char digit : digits) {
+				number = number * 10 + static_cast<uint64_t>(digit - '0');
+			}
+			numbers.push_back(number);
+			text.push_back(kPlaceholder);
+		}
+		index = end;
+	}
+	return true;
+}
+
+void appendLevelName(std::string &out, uint8_t level) {
+	static const char *const kNames[] = {"debug", "info", "warn", "error"};
+	out += level < 4 ? kNames[level] : "unknown";
+}
+
+} // namespace
+
+LogBinaryEncoder::LogBinaryEncoder(size_t maxTags, size_t maxTemplates)
+    : _maxTags(maxTags), _maxTemplates(maxTemplates) {
+}
+
+void LogBinaryEncoder::reset() {
+	_headerWritten = false;
+	_lastMillis = 0;
+	_lastTimestamp = 0;
+	_tags.clear();
+	_templates.clear();
+}
+
+void LogBinaryEncoder::encodeEntry(
+    uint8_t level,
+    std::string_view tag,
+    uint32_t millis,
+    int64_t timestamp,
+    std::string_view message,
+    std::string_view fields,
+    std::string &out
+) {
+	if (!_headerWritten) {
+		out.append(kMagic, sizeof(kMagic));
+		out.push_back(static_cast<char>(kVersion));
+		appendVarint(out, _maxTags);
+		appendVarint(out, _maxTemplates);
+		_headerWritten = true;
+	}
+
+	uint8_t flags = kEntryMarker | (level & kLevelMask);
+
+	const std::string tagKey(tag);
+	const auto tagIt = _tags.find(tagKey);
+	if (tagIt == _tags.end()) {
+		flags |= kFlagNewTag;
+		if (_tags.size() < _maxTags) {
+			const uint32_t id = static_cast<uint32_t>(_tags.size());
+			_tags.emplace(tagKey, id);
+		}
+	}
+
+	const int64_t timestampDelta = timestamp - _lastTimestamp;
+	if (timestampDelta != 0) {
+		flags |= kFlagTimestamp;
+	}
+
+	uint32_t templateId = 0;
+	bool templated = false;
+	if (!fields.empty()) {
+		flags |= kFlagFields;
+	} else if (!extractTemplate(message, _template, _numbers)) {
+		flags |= kFlagRawMessage;
+	} else {
+		const auto templateIt = _templates.find(_template);
+		if (templateIt != _templates.end()) {
+			templateId = templateIt->second;
+			templated = true;
+		} else if (_templates.size() < _maxTemplates) {
+			flags |= kFlagNewTemplate;
+			templateId = static_cast<uint32_t>(_templates.size());
+			_templates.emplace(_template, templateId);
+			templated = true;
+		} else {
+			flags |= kFlagRawMessage;
+		}
+	}
+
+	out.push_back(static_cast<char>(flags));
+	if ((flags & kFlagNewTag) != 0) {
+		appendBytes(out, tag);
+	} else {
+		appendVarint(out, tagIt->second);
+	}
+	appendVarint(out, static_cast<uint32_t>(millis - _lastMillis));
+	if ((flags & kFlagTimestamp) != 0) {
+		appendVarint(out, zigzag(timestampDelta));
+	}
+
+	if ((flags & kFlagFields) != 0) {
+		appendBytes(out, fields);
+	} else if (!templated) {
+		appendBytes(out, message);
+	} else {
+		if ((flags & kFlagNewTemplate) != 0) {
+			appendBytes(out, _template);
+		} else {
+			appendVarint(out, templateId);
+		}
+		for (const uint64_t number : _numbers) {
+			appendVarint(out, number);
+		}
+	}
+
+	_lastMillis = millis;
+	_lastTimestamp = timestamp;
+}
+
+void LogBinaryDecoder::reset() {
+	_haveHeader = false;
+	_maxTags = 0;
+	_maxTemplates = 0;
+	_lastMillis = 0;
+	_lastTimestamp = 0;
+	_tags.clear();
+	_templates.clear();
+	_pending.clear();
+}
+
+bool LogBinaryDecoder::feed(const char *data, size_t size, std::vector<LogBinaryEntry> &out) {
+	_pending.append(data, size);
+
+	const char *cursor = _pending.data();
+	const char *end = cursor + _pending.size();
+	Step step = Step::Done;
+	while (cursor < end) {
+		LogBinaryEntry entry;
+		step = decodeOne(cursor, end, entry);
+		if (step != Step::Done) {
+			break;
+		}
+		if (entry.level != 0xFF) {
+			out.push_back(std::move(entry));
+		}
+	}
+
+	_pending.erase(0, static_cast<size_t>(cursor - _pending.data()));
+	return step != Step::Error;
+}
+
+LogBinaryDecoder::Step
+LogBinaryDecoder::decodeOne(const char *&cursor, const char *end, LogBinaryEntry &entry) {
+	ByteReader reader(cursor, end);
+	bool malformed = false;
+	const auto incomplete = [&malformed]() { return malformed ? Step::Error : Step::NeedMore; };
+
+	uint8_t flags = 0;
+	reader.byte(flags);
+	if ((flags & kEntryMarker) == 0) {
+		// Stream header: resets the dictionaries.
+		uint8_t magic[2] = {0, 0};
+		uint8_t version = 0;
+		uint64_t maxTags = 0;
+		uint64_t maxTemplates = 0;
+		if (flags != static_cast<uint8_t>(kMagic[0])) {
+			return Step::Error;
+		}
+		if (!reader.byte(magic[0]) || !reader.byte(magic[1]) || !reader.byte(version)) {
+			return Step::NeedMore;
+		}
+		if (magic[0] != static_cast<uint8_t>(kMagic[1]) ||
+		    magic[1] != static_cast<uint8_t>(kMagic[2]) || version != kVersion) {
+			return Step::Error;
+		}
+		if (!reader.varint(maxTags, malformed) || !reader.varint(maxTemplates, malformed)) {
+			return incomplete();
+		}
+		_haveHeader = true;
+		_maxTags = static_cast<size_t>(maxTags);
+		_maxTemplates = static_cast<size_t>(maxTemplates);
+		_lastMillis = 0;
+		_lastTimestamp = 0;
+		_tags.clear();
+		_templates.clear();
+		entry.level = 0xFF; // Not an entry
+		cursor = reader.position();
+		return Step::Done;
+	}
+	if (!_haveHeader) {
+		return Step::Error;
+	}
+
+	// Parse into locals first so a truncated entry leaves the decoder state untouched.
+	std::string_view tag;
+	uint64_t tagId = 0;
+	if ((flags & kFlagNewTag) != 0 ? !reader.bytes(tag, malformed)
+	                               : !reader.varint(tagId, malformed)) {
+		return incomplete();
+	}
+	if ((flags & kFlagNewTag) == 0 && tagId >= _tags.size()) {
+		return Step::Error;
+	}
+
+	uint64_t millisDelta = 0;
+	uint64_t timestampDelta = 0;
+	if (!reader.varint(millisDelta, malformed)) {
+		return incomplete();
+	}
+	if ((flags & kFlagTimestamp) != 0 && !reader.varint(timestampDelta, malformed)) {
+		return incomplete();
+	}
+
+	std::string_view payload;
+	uint64_t templateId = 0;
+	const bool templated = (flags & (kFlagFields | kFlagRawMessage)) == 0;
+	if (!templated || (flags & kFlagNewTemplate) != 0) {
+		if (!reader.bytes(payload, malformed)) {
+			return incomplete();
+		}
+	} else if (!reader.varint(templateId, malformed)) {
+		return incomplete();
+	} else if (templateId >= _templates.size()) {
+		return Step::Error;
+	} else {
+		payload = _templates[static_cast<size_t>(templateId)];
+	}
+
+	if (templated) {
+		std::string message;
+		for (const char value : payload) {
+			if (value != kPlaceholder) {
+				message.push_back(value);
+				continue;
+			}
+			uint64_t number = 0;
+			if (!reader.varint(number, malformed)) {
+				return incomplete();
+			}
+			message += std::to_string(number);
+		}
+		entry.message = std::move(message);
+	} else if ((flags & kFlagFields) != 0) {
+		entry.fields.assign(payload.data(), payload.size());
+		entry.message = logFieldsToText(entry.fields);
+	} else {
+		entry.message.assign(payload.data(), payload.size());
+	}
+
+	// The entry is complete: commit dictionary and delta state.
+	if ((flags & kFlagNewTag) != 0) {
+		entry.tag.assign(tag.data(), tag.size());
+		if (_tags.size() < _maxTags) {
+			_tags.push_back(entry.tag);
+		}
+	} else {
+		entry.tag = _tags[static_cast<size_t>(tagId)];
+	}
+	if ((flags & kFlagNewTemplate) != 0 && _templates.size() < _maxTemplates) {
+		_templates.emplace_back(payload.data(), payload.size());
+	}
+	entry.level = flags & kLevelMask;
+	_lastMillis += static_cast<uint32_t>(millisDelta);
+	_lastTimestamp += unzigzag(timestampDelta);
+	entry.millis = _lastMillis;
+	entry.timestamp = _lastTimestamp;
+	cursor = reader.position();
+	return Step::Done;
+}
+
+std::string logBinaryEntryToText(const LogBinaryEntry &entry) {
+	static const char kLetters[] = {'D', 'I', 'W', 'E'};
+	std::string out = "[";
+	out.push_back(entry.level < 4 ? kLetters[entry.level] : '?');
+	out += "] [";
+	out += entry.tag;
+	out += "] [";
+	out += std::to_string(entry.millis);
+	out += "][";
+	out += std::to_string(entry.timestamp);
+	out += "] ";
+	out += entry.message;
+	return out;
+}
+
+std::string logBinaryEntryToJson(const LogBinaryEntry &entry) {
+	std::string out = "{\"level\":\"";
+	appendLevelName(out, entry.level);
+	out += "\",\"tag\":";
+	logger_fields_detail::appendJsonString(out, entry.tag);
+	out += ",\"millis\":";
+	out += std::to_string(entry.millis);
+	out += ",\"timestamp\":";
+	out += std::to_string(entry.timestamp);
+	out += ",\"message\":";
+	logger_fields_detail::appendJsonString(out, entry.message);
+	if (!entry.fields.empty()) {
+		out += ",\"fields\":";
+		out += logFieldsToJson(entry.fields);
+	}
+	out.push_back('}');
+	return out;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Compact binary log stream. It has no Arduino or FreeRTOS dependencies so the same
+// code decodes dumps on the host.
+//
+// A stream starts with a header: "ELB", a version byte, then the tag and template
+// dictionary capacities as varints. Each entry that follows is:
+//   - a flags byte: 0x80 | level (bits 0-1) | new tag (0x04) | new template (0x08)
+//     | timestamp changed (0x10) | raw message (0x20) | structured fields (0x40)
+//   - the tag: its name (varint length + bytes) when new, else its dictionary id
+//   - the millis delta to the previous entry (varint, modulo 2^32)
+//   - the wall-clock delta (zigzag varint) when it changed
+//   - the message: encoded fields, raw text, or a template reference followed by the
+//     numbers cut out of the text as varints; new templates carry their text inline
+//
+// A template is the message with every run of decimal digits (without a leading zero)
+// replaced by a 0x01 byte, so "loop=12 temp=21.37" is stored once as "loop=\1 temp=\1.\1"
+// and later entries only carry three small varints. New tags and templates are assigned
+// the next free id on both sides until the capacities from the header are reached; after
+// that, unknown tags are sent by name each time and unknown messages as raw text.
+struct LogBinaryEntry {
+	uint8_t level = 0; // LogLevel value
+	std::string tag;
+	uint32_t millis = 0;
+	int64_t timestamp = 0;
+	std::string message;
+	std::string fields; // Encoded `Log::fields`; `message` is rendered from it when decoded
+};
+
+class LogBinaryEncoder {
+  public:
+	static constexpr size_t kDefaultMaxTags = 64;
+	static constexpr size_t kDefaultMaxTemplates = 128;
+
+	explicit LogBinaryEncoder(
+	    size_t maxTags = kDefaultMaxTags,
+	    size_t maxTemplates = kDefaultMaxTemplates
+	);
+
+	// Appends `entry` (a `Log` or `LogBinaryEntry`) to `out`. The first entry after
+	// construction or reset() is preceded by the stream header.
+	template <typename Entry> void encode(const Entry &entry, std::string &out) {
+		encodeEntry(
+		    static_cast<uint8_t>(entry.level),
+		    entry.tag,
+		    entry.millis,
+		    static_cast<int64_t>(entry.timestamp),
+		    entry.message,
+		    entry.fields,
+		    out
+		);
+	}
+
+	// Appends every entry of a drained batch (`std::vector<Log>` or `LogBatchView`).
+	template <typename Batch> void encodeBatch(const Batch &batch, std::string &out) {
+		for (const auto &entry : batch) {
+			encode(entry, out);
+		}
+	}
+
+	// Forgets the dictionaries and delta state; the next entry starts a new stream.
+	void reset();
+
+  private:
+	void encodeEntry(
+	    uint8_t level,
+	    std::string_view tag,
+	    uint32_t millis,
+	    int64_t timestamp,
+	    std::string_view message,
+	    std::string_view fields,
+	    std::string &out
+	);
+
+	size_t _maxTags;
+	size_t _maxTemplates;
+	bool _headerWritten = false;
+	uint32_t _lastMillis = 0;
+	int64_t _lastTimestamp = 0;
+	std::unordered_map<std::string, uint32_t> _tags;
+	std::unordered_map<std::string, uint32_t> _templates;
+	std::string _template;
+	std::vector<uint64_t> _numbers;
+};
+
+// Incremental decoder: feed() accepts arbitrary slices of a dump (e.g. file reads) and
+// keeps an incomplete trailing entry until the rest arrives. A new stream header resets
+// the dictionaries, so dumps of several streams can be concatenated.
+class LogBinaryDecoder {
+  public:
+	// Decodes every complete entry in `data` (plus bytes kept from earlier calls) into
+	// `out`. Returns false on malformed input; the decoder must then be reset().
+	bool feed(const char *data, size_t size, std::vector<LogBinaryEntry> &out);
+	// True when bytes of an incomplete entry are still buffered.
+	bool hasPending() const {
+		return !_pending.empty();
+	}
+	void reset();
+
+  private:
+	enum class Step { Done, NeedMore, Error };
+
+	Step decodeOne(const char *&cursor, const char *end, LogBinaryEntry &entry);
+
+	bool _haveHeader = false;
+	size_t _maxTags = 0;
+	size_t _maxTemplates = 0;
+	uint32_t _lastMillis = 0;
+	int64_t _lastTimestamp = 0;
+	std::vector<std::string> _tags;
+	std::vector<std::string> _templates;
+	std::string _pending;
+};
+
+// Renders a decoded entry as `[I] [TAG] [millis][timestamp] message`.
+std::string logBinaryEntryToText(const LogBinaryEntry &entry);
+// Renders a decoded entry as one NDJSON object (without the trailing newline). Structured
+// entries carry their fields as a nested `fields` object.
+std::string logBinaryEntryToJson(const LogBinaryEntry &entry);
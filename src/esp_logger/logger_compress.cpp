@@ -0,0 +1,371 @@
+#include "esp_logger/logger_compress.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+constexpr uint8_t kFlagStartOfStream = 0x01;
+constexpr uint8_t kFlagStored = 0x02;
+constexpr size_t kMaxHeader = 2 + 2 * 5; // Flags, parameters, two varints of up to 32 bits
+constexpr size_t kMinMatch = 2;
+constexpr size_t kMaxChunk = 8192;
+constexpr unsigned kHashBits = 10;
+constexpr unsigned kMaxChainDepth = 32;
+constexpr uint16_t kNoPosition = 0xFFFF;
+
+uint32_t hashAt(const uint8_t *data) {
+	const uint32_t key = static_cast<uint32_t>(data[0]) << 8 | data[1];
+	return (key * 2654435761u) >> (32 - kHashBits);
+}
+
+size_t putVarint(uint8_t *out, uint64_t value) {
+	size_t length = 0;
+	while (value >= 0x80) {
+		out[length++] = static_cast<uint8_t>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out[length++] = static_cast<uint8_t>(value);
+	return length;
+}
+
+// Returns 0 when the varint is incomplete, SIZE_MAX when it is malformed.
+size_t getVarint(const uint8_t *data, size_t size, uint64_t &value) {
+	value = 0;
+	for (size_t index = 0; index < size; ++index) {
+		if (index == 5) {
+			return SIZE_MAX;
+		}
+		value |= static_cast<uint64_t>(data[index] & 0x7F) << (7 * index);
+		if ((data[index] & 0x80) == 0) {
+			return index + 1;
+		}
+	}
+	return size >= 5 ? SIZE_MAX : 0;
+}
+
+// MSB-first bit packer over a fixed buffer; `overflow` is set instead of writing past it.
+class BitWriter {
+  public:
+	BitWriter(uint8_t *out, size_t capacity) : _out(out), _capacity(capacity) {
+	}
+
+	void put(uint32_t value, unsigned bits) {
+		while (bits > 0) {
+			if (_bitCount == 0) {
+				if (_size == _capacity) {
+					overflow = true;
+					return;
+				}
+				_out[_size++] = 0;
+			}
+			const unsigned room = 8 - _bitCount;
+			const unsigned take = std::min(room, bits);
+			const uint32_t chunk = (value >> (bits - take)) & ((1u << take) - 1);
+			_out[_size - 1] |= static_cast<uint8_t>(chunk << (room - take));
+			_bitCount = (_bitCount + take) & 7;
+			bits -= take;
+		}
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool overflow = false;
+
+  private:
+	uint8_t *_out;
+	size_t _capacity;
+	size_t _size = 0;
+	unsigned _bitCount = 0;
+};
+
+class BitReader {
+  public:
+	BitReader(const uint8_t *data, size_t size) : _data(data), _size(size) {
+	}
+
+	bool get(unsigned bits, uint32_t &value) {
+		value = 0;
+		while (bits > 0) {
+			if (_index == _size) {
+				return false;
+			}
+			const unsigned room = 8 - _bitCount;
+			const unsigned take = std::min(room, bits);
+			const uint32_t chunk = (_data[_index] >> (room - take)) & ((1u << take) - 1);
+			value = (value << take) | chunk;
+			_bitCount += take;
+			if (_bitCount == 8) {
+				_bitCount = 0;
+				++_index;
+			}
+			bits -= take;
+		}
+		return true;
+	}
+
+  private:
+	const uint8_t *_data;
+	size_t _size;
+	size_t _index = 0;
+	unsigned _bitCount = 0;
+};
+
+} // namespace
+
+LogCompressor::LogCompressor(
+    FrameSink sink,
+    size_t maxChunk,
+    uint8_t windowBits,
+    uint8_t lengthBits
+)
+    : _sink(std::move(sink)), _maxChunk(maxChunk), _windowBits(windowBits),
+      _lengthBits(lengthBits) {
+	if (windowBits < 8 || windowBits > 12 || lengthBits < 3 || lengthBits > 8 || maxChunk == 0 ||
+	    maxChunk > kMaxChunk) {
+		return;
+	}
+	const size_t workSize = (static_cast<size_t>(1) << windowBits) + maxChunk;
+	_work.resize(workSize);
+	_prev.resize(workSize);
+	_head.resize(static_cast<size_t>(1) << kHashBits);
+	// A stored frame is the worst case, so a frame never exceeds header + chunk.
+	_frame.resize(kMaxHeader + maxChunk);
+	_valid = true;
+}
+
+void LogCompressor::reset() {
+	_startOfStream = true;
+	_historySize = 0;
+}
+
+size_t LogCompressor::compressPayload(size_t total, uint8_t *payload, size_t capacity) {
+	const size_t window = static_cast<size_t>(1) << _windowBits;
+	const size_t maxMatch = kMinMatch + (static_cast<size_t>(1) << _lengthBits) - 1;
+	std::fill(_head.begin(), _head.end(), kNoPosition);
+
+	const uint8_t *work = _work.data();
+	const auto insert = [this, work, total](size_t position) {
+		if (position + kMinMatch <= total) {
+			const uint32_t hash = hashAt(work + position);
+			_prev[position] = _head[hash];
+			_head[hash] = static_cast<uint16_t>(position);
+		}
+	};
+	for (size_t position = 0; position < _historySize; ++position) {
+		insert(position);
+	}
+
+	BitWriter writer(payload, capacity);
+	size_t position = _historySize;
+	while (position < total && !writer.overflow) {
+		size_t bestLength = 0;
+		size_t bestDistance = 0;
+		if (position + kMinMatch <= total) {
+			const size_t limit = std::min(maxMatch, total - position);
+			uint16_t candidate = _head[hashAt(work + position)];
+			for (unsigned depth = 0; depth < kMaxChainDepth && candidate != kNoPosition; ++depth) {
+				const size_t distance = position - candidate;
+				if (distance > window) {
+					break;
+				}
+				size_t length = 0;
+				while (length < limit && work[candidate + length] == work[position + length]) {
+					++length;
+				}
+				if (length > bestLength) {
+					bestLength = length;
+					bestDistance = distance;
+					if (length == limit) {
+						break;
+					}
+				}
+				candidate = _prev[candidate];
+			}
+		}
+
+		if (bestLength >= kMinMatch) {
+			writer.put(0, 1);
+			writer.put(static_cast<uint32_t>(bestDistance - 1), _windowBits);
+			writer.put(static_cast<uint32_t>(bestLength - kMinMatch), _lengthBits);
+			for (size_t offset = 0; offset < bestLength; ++offset) {
+				insert(position + offset);
+			}
+			position += bestLength;
+		} else {
+			writer.put(1, 1);
+			writer.put(work[position], 8);
+			insert(position);
+			++position;
+		}
+	}
+	return writer.overflow ? 0 : writer.size();
+}
+
+bool LogCompressor::write(const uint8_t *data, size_t size) {
+	if (!_valid || !_sink || size > _maxChunk || (size > 0 && data == nullptr)) {
+		return false;
+	}
+	if (size == 0) {
+		return true;
+	}
+
+	std::memcpy(_work.data() + _historySize, data, size);
+	const size_t total = _historySize + size;
+
+	// Compress straight behind the largest possible header, then write the actual header
+	// right in front of the payload so the frame needs no second copy.
+	uint8_t flags = _startOfStream ? kFlagStartOfStream : 0;
+	uint8_t *payload = _frame.data() + kMaxHeader;
+	size_t payloadSize = compressPayload(total, payload, size);
+	if (payloadSize == 0) {
+		flags |= kFlagStored;
+		std::memcpy(payload, data, size);
+		payloadSize = size;
+	}
+
+	uint8_t header[kMaxHeader];
+	size_t headerSize = 0;
+	header[headerSize++] = flags;
+	header[headerSize++] = static_cast<uint8_t>(_windowBits << 4 | _lengthBits);
+	headerSize += putVarint(header + headerSize, size);
+	headerSize += putVarint(header + headerSize, payloadSize);
+	uint8_t *frame = payload - headerSize;
+	std::memcpy(frame, header, headerSize);
+
+	if (!_sink(frame, headerSize + payloadSize)) {
+		return false;
+	}
+
+	// Accepted: keep the newest window of raw bytes as history for the next frame.
+	const size_t window = static_cast<size_t>(1) << _windowBits;
+	const size_t keep = std::min(window, total);
+	std::memmove(_work.data(), _work.data() + total - keep, keep);
+	_historySize = keep;
+	_startOfStream = false;
+	_rawBytes += size;
+	_frameBytes += headerSize + payloadSize;
+	return true;
+}
+
+void LogDecompressor::reset() {
+	_history.clear();
+	_pending.clear();
+}
+
+bool LogDecompressor::feed(const uint8_t *data, size_t size, std::string &out) {
+	_pending.append(reinterpret_cast<const char *>(data), size);
+
+	size_t offset = 0;
+	bool valid = true;
+	while (offset < _pending.size()) {
+		const uint8_t *frame = reinterpret_cast<const uint8_t *>(_pending.data()) + offset;
+		const size_t available = _pending.size() - offset;
+		if (available < 2) {
+			break;
+		}
+		uint64_t rawSize = 0;
+		uint64_t payloadSize = 0;
+		const size_t rawLength = getVarint(frame + 2, available - 2, rawSize);
+		if (rawLength == SIZE_MAX) {
+			valid = false;
+			break;
+		}
+		if (rawLength == 0) {
+			break;
+		}
+		const size_t payloadLength =
+		    getVarint(frame + 2 + rawLength, available - 2 - rawLength, payloadSize);
+		if (payloadLength == SIZE_MAX || rawSize > kMaxChunk || payloadSize > kMaxChunk) {
+			valid = false;
+			break;
+		}
+		const size_t headerSize = 2 + rawLength + payloadLength;
+		if (payloadLength == 0 || available - headerSize < payloadSize) {
+			break;
+		}
+		if (!decodeFrame(
+		        frame[0],
+		        frame[1],
+		        frame + headerSize,
+		        static_cast<size_t>(payloadSize),
+		        static_cast<size_t>(rawSize),
+		        out
+		    )) {
+			valid = false;
+			break;
+		}
+		offset += headerSize + static_cast<size_t>(payloadSize);
+	}
+
+	_pending.erase(0, offset);
+	return valid;
+}
+
+bool LogDecompressor::decodeFrame(
+    uint8_t flags,
+    uint8_t parameters,
+    const uint8_t *payload,
+    size_t payloadSize,
+    size_t rawSize,
+    std::string &out
+) {
+	const unsigned windowBits = parameters >> 4;
+	const unsigned lengthBits = parameters & 0x0F;
+	if ((flags & ~(kFlagStartOfStream | kFlagStored)) != 0 || windowBits < 8 ||
+	    windowBits > 12 || lengthBits < 3 || lengthBits > 8) {
+		return false;
+	}
+	if ((flags & kFlagStartOfStream) != 0) {
+		_history.clear();
+	}
+
+	// Decode behind the history so back-references can reach into the previous frames.
+	const size_t historySize = _history.size();
+	if ((flags & kFlagStored) != 0) {
+		if (payloadSize != rawSize) {
+			return false;
+		}
+		_history.append(reinterpret_cast<const char *>(payload), payloadSize);
+	} else {
+		BitReader reader(payload, payloadSize);
+		while (_history.size() - historySize < rawSize) {
+			uint32_t literal = 0;
+			uint32_t value = 0;
+			if (!reader.get(1, literal)) {
+				return false;
+			}
+			if (literal != 0) {
+				if (!reader.get(8, value)) {
+					return false;
+				}
+				_history.push_back(static_cast<char>(value));
+				continue;
+			}
+			uint32_t length = 0;
+			if (!reader.get(windowBits, value) || !reader.get(lengthBits, length)) {
+				return false;
+			}
+			const size_t distance = static_cast<size_t>(value) + 1;
+			length += kMinMatch;
+			if (distance > _history.size() ||
+			    _history.size() - historySize + length > rawSize) {
+				return false;
+			}
+			// Byte by byte: a match may overlap the bytes it produces.
+			for (uint32_t index = 0; index < length; ++index) {
+				_history.push_back(_history[_history.size() - distance]);
+			}
+		}
+	}
+
+	out.append(_history, historySize, std::string::npos);
+	const size_t window = static_cast<size_t>(1) << windowBits;
+	if (_history.size() > window) {
+		_history.erase(0, _history.size() - window);
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Small-footprint LZSS compression for sync payloads, in the style of heatshrink: a bounded
+// history window, and a bit stream of literals (1 + 8 bits) and back-references
+// (0 + distance in `windowBits` + length in `lengthBits`). Like logger_binary.h it has no
+// Arduino or FreeRTOS dependencies so the decompressor builds on the host.
+//
+// The compressor turns each chunk passed to write() into one frame:
+//   - flags byte: 0x01 = first frame of a stream (decoder drops its history),
+//     0x02 = stored (payload is the raw chunk because compression did not pay off)
+//   - parameters byte: windowBits << 4 | lengthBits
+//   - raw length and payload length as varints, then the payload
+// Frames of one stream share the history window, so they must be decoded in order. Chunks
+// are at most `maxChunk` bytes, which makes a natural pairing with LogBatchStreamer:
+// give the streamer a `maxChunk`-sized buffer and the compressor's chunkSink().
+class LogCompressor {
+  public:
+	using FrameSink = std::function<bool(const uint8_t *data, size_t size)>;
+
+	static constexpr uint8_t kDefaultWindowBits = 10;
+	static constexpr uint8_t kDefaultLengthBits = 5;
+
+	// Allocates about 3 × (2^windowBits + maxChunk) + maxChunk + 2 KB up front, roughly 7 KB
+	// with the defaults. windowBits must be 8–12, lengthBits 3–8 and maxChunk 1–8192;
+	// otherwise isValid() is false and write() fails.
+	explicit LogCompressor(
+	    FrameSink sink,
+	    size_t maxChunk = 512,
+	    uint8_t windowBits = kDefaultWindowBits,
+	    uint8_t lengthBits = kDefaultLengthBits
+	);
+
+	bool isValid() const {
+		return _valid;
+	}
+
+	// Compresses `data` into one frame and hands it to the sink. All or nothing: when the
+	// sink refuses the frame, the history is left untouched and the same chunk can be
+	// written again later. Returns false for chunks larger than maxChunk.
+	bool write(const uint8_t *data, size_t size);
+	// A sink for LogBatchStreamer (or any chunk producer) that forwards to write().
+	std::function<bool(const uint8_t *, size_t)> chunkSink() {
+		return [this](const uint8_t *data, size_t size) { return write(data, size); };
+	}
+	// Starts a new stream: the next frame is flagged so decoders drop their history.
+	void reset();
+
+	uint64_t rawBytes() const {
+		return _rawBytes;
+	}
+	uint64_t frameBytes() const {
+		return _frameBytes;
+	}
+
+  private:
+	size_t compressPayload(size_t total, uint8_t *payload, size_t capacity);
+
+	FrameSink _sink;
+	size_t _maxChunk;
+	uint8_t _windowBits;
+	uint8_t _lengthBits;
+	bool _valid = false;
+	bool _startOfStream = true;
+	size_t _historySize = 0;
+	std::vector<uint8_t> _work;  // History window followed by the chunk being compressed
+	std::vector<uint16_t> _head; // Hash of two bytes -> latest position
+	std::vector<uint16_t> _prev; // Position -> previous position with the same hash
+	std::vector<uint8_t> _frame;
+	uint64_t _rawBytes = 0;
+	uint64_t _frameBytes = 0;
+};
+
+// Host-side counterpart: feed() accepts arbitrary slices of a frame stream, keeps an
+// incomplete trailing frame, and appends the decompressed bytes to `out`.
+class LogDecompressor {
+  public:
+	// Returns false on malformed input; the decompressor must then be reset().
+	bool feed(const uint8_t *data, size_t size, std::string &out);
+	bool hasPending() const {
+		return !_pending.empty();
+	}
+	void reset();
+
+  private:
+	bool decodeFrame(
+	    uint8_t flags,
+	    uint8_t parameters,
+	    const uint8_t *payload,
+	    size_t payloadSize,
+	    size_t rawSize,
+	    std::string &out
+	);
+
+	std::string _history;
+	std::string _pending;
+};
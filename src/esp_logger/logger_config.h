@@ -6,17 +6,60 @@
 #include <freertos/FreeRTOS.h>
 
 enum class LogLevel { Debug = 0, Info, Warn, Error };
+constexpr size_t kLogLevelCount = 4;
+
+// What storing an entry does when the buffer is full.
+enum class LogOverflowPolicy : uint8_t {
+	DropOldest,      // Evict the oldest buffered entry
+	DropNewest,      // Discard the incoming entry
+	Block,           // Wait up to `overflowBlockMS` for a sync to make room, then DropNewest
+	DropLowestLevel, // Evict the oldest entry of the lowest level over its reserve
+};
+
+// Compile-time floor as a LogLevel value (0 = Debug ... 3 = Error, 4 strips everything).
+// Calls below it through the ESPLOGGER_* macros compile to nothing.
+#ifndef ESPLOGGER_MIN_LEVEL
+#define ESPLOGGER_MIN_LEVEL 0
+#endif
 
 struct LoggerConfig {
 	static constexpr BaseType_t any = tskNO_AFFINITY; // Use any available core
 
-	uint32_t syncIntervalMS = 5000;
+	uint32_t syncIntervalMS = 5000; // Upper bound between flushes; triggers below flush sooner
 	uint32_t stackSize = 4096 * sizeof(StackType_t);
 	BaseType_t coreId = any;
 	size_t maxLogInRam = 100;
+	size_t maxLogBytes = 0; // >0 stores records inline; total arena bytes, half per region
 	UBaseType_t priority = 1;
 	LogLevel consoleLogLevel = LogLevel::Debug;
+	LogLevel captureLevel = LogLevel::Debug; // Entries below this are dropped before formatting
 	bool enableSyncTask = true;
 	bool usePrettyJson = true;
 	bool usePSRAMBuffers = false;
+	bool useLockFreeRing = false; // Producers enqueue lock-free instead of taking the mutex
+	bool deferFormatting = false; // Capture printf arguments; render on sync/query paths
+	bool deferJson = false;       // Copy JSON as MessagePack; serialize on sync/query paths
+	size_t maxTags = 64;          // Distinct tags the per-logger tag registry can intern
+	uint8_t syncWatermarkPercent = 75;            // Wake the sync task at this fill (0 = off)
+	LogLevel syncTriggerLevel = LogLevel::Error; // Entries at or above this wake the sync task
+	uint32_t shutdownTimeoutMS = 1000;           // deinit() waits this long for the sync task
+	// Drops are counted per level in LoggerStats and reported by a synthetic entry (tag
+	// ESPLogger::kDropNoticeTag) at the start of the next synced batch.
+	LogOverflowPolicy overflowPolicy = LogOverflowPolicy::DropOldest;
+	uint32_t overflowBlockMS = 10; // Block: longest a logging call waits for room
+	// Entries of each level (indexed by LogLevel) that eviction leaves alone. When any is set,
+	// DropOldest and DropLowestLevel both evict the oldest entry of the lowest level holding
+	// more than its reserve. Applies to the `maxLogInRam` buffer only.
+	size_t reservedPerLevel[kLogLevelCount] = {};
+	// Caller memory that survives a reset (RTC_NOINIT_ATTR array, mmap'd file) holding a copy
+	// of unsynced entries; see LogRetainedRing. nullptr disables it.
+	void *retainedBuffer = nullptr;
+	size_t retainedBufferSize = 0;
+	// Host/Linux builds: buffer entries in a LogRetainedRing inside this mmap'd file instead
+	// of the heap (`maxLogInRam`/`maxLogBytes` are then unused). See LogMappedFile.
+	const char *mappedLogPath = nullptr;
+	size_t mappedLogBytes = 1024 * 1024;
+	// Entries moved to the spill store (ESPLogger::setSpillStore) per overflow; 0 moves a
+	// quarter of what is buffered.
+	size_t spillBatch = 0;
 };
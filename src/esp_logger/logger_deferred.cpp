@@ -0,0 +1,456 @@
+#include "esp_logger/logger_deferred.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(ESP_PLATFORM) && defined(__has_include)
+#if __has_include(<esp_memory_utils.h>)
+#include <esp_memory_utils.h>
+#define ESPLOGGER_CAN_CHECK_DROM 1
+#elif __has_include(<soc/soc_memory_layout.h>)
+#include <soc/soc_memory_layout.h>
+#define ESPLOGGER_CAN_CHECK_DROM 1
+#endif
+#endif
+
+#ifndef ESPLOGGER_CAN_CHECK_DROM
+#define ESPLOGGER_CAN_CHECK_DROM 0
+#endif
+
+// Without a flash-address check no pointer is known to be static. Builds whose callers only
+// ever pass string literals (the host tests, for one) can opt in to deferring them anyway.
+#ifndef ESPLOGGER_TRUST_FORMAT_POINTERS
+#define ESPLOGGER_TRUST_FORMAT_POINTERS 0
+#endif
+
+namespace logger_deferred_detail {
+
+namespace {
+
+enum class ArgKind : uint8_t {
+	Int,
+	Long,
+	LongLong,
+	IntMax,
+	Size,
+	PtrDiff,
+	Double,
+	LongDouble,
+	String,
+	Pointer,
+	Unsupported
+};
+
+struct Conversion {
+	const char *begin = nullptr;
+	size_t length = 0;
+	bool widthFromArg = false;
+	bool precisionFromArg = false;
+	int precision = -1;
+	ArgKind kind = ArgKind::Unsupported;
+};
+
+constexpr size_t kMaxSpecLength = 32;
+constexpr const char *kNullString = "(null)";
+
+// Parses the conversion starting at `cursor` (which points at '%', not "%%") and returns
+// the position right after it.
+const char *parseConversion(const char *cursor, Conversion &conversion) {
+	conversion = Conversion{};
+	conversion.begin = cursor++;
+
+	while (*cursor != '\0' && std::strchr("-+ #0'", *cursor) != nullptr) {
+		++cursor;
+	}
+
+	if (*cursor == '*') {
+		conversion.widthFromArg = true;
+		++cursor;
+	} else {
+		while (*cursor >= '0' && *cursor <= '9') {
+			++cursor;
+		}
+	}
+
+	if (*cursor == '.') {
+		++cursor;
+		if (*cursor == '*') {
+			conversion.precisionFromArg = true;
+			++cursor;
+		} else {
+			int precision = 0;
+			while (*cursor >= '0' && *cursor <= '9') {
+				precision = precision * 10 + (*cursor - '0');
+				++cursor;
+			}
+			conversion.precision = precision;
+		}
+	}
+
+	ArgKind integerKind = ArgKind::Int;
+	bool wide = false;
+	bool longDouble = false;
+	switch (*cursor) {
+	case 'h':
+		++cursor;
+		if (*cursor == 'h') {
+			++cursor;
+		}
+		break;
+	case 'l':
+		++cursor;
+		integerKind = ArgKind::Long;
+		wide = true;
+		if (*cursor == 'l') {
+			++cursor;
+			integerKind = ArgKind::LongLong;
+			wide = false;
+		}
+		break;
+	case 'j':
+		++cursor;
+		integerKind = ArgKind::IntMax;
+		break;
+	case 'z':
+		++cursor;
+		integerKind = ArgKind::Size;
+		break;
+	case 't':
+		++cursor;
+		integerKind = ArgKind::PtrDiff;
+		break;
+	case 'L':
+		++cursor;
+		longDouble = true;
+		break;
+	default:
+		break;
+	}
+
+	const char conversionChar = *cursor;
+	if (conversionChar == '\0') {
+		conversion.length = static_cast<size_t>(cursor - conversion.begin);
+		return cursor;
+	}
+	++cursor;
+	conversion.length = static_cast<size_t>(cursor - conversion.begin);
+
+	switch (conversionChar) {
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'o':
+	case 'x':
+	case 'X':
+		conversion.kind = integerKind;
+		break;
+	case 'c':
+		conversion.kind = wide ? ArgKind::Unsupported : ArgKind::Int;
+		break;
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+	case 'a':
+	case 'A':
+		conversion.kind = longDouble ? ArgKind::LongDouble : ArgKind::Double;
+		break;
+	case 's':
+		conversion.kind = wide ? ArgKind::Unsupported : ArgKind::String;
+		break;
+	case 'p':
+		conversion.kind = ArgKind::Pointer;
+		break;
+	default:
+		// %n and unknown conversions cannot be replayed safely.
+		conversion.kind = ArgKind::Unsupported;
+		break;
+	}
+
+	if (conversion.length >= kMaxSpecLength) {
+		conversion.kind = ArgKind::Unsupported;
+	}
+	return cursor;
+}
+
+template <typename T> void appendRaw(std::string &out, const T &value) {
+	out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool readRaw(const char *&cursor, const char *end, T &value) {
+	if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+		return false;
+	}
+	std::memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return true;
+}
+
+template <typename... Args> void appendPrintf(std::string &out, const char *spec, Args... args) {
+	char scratch[64];
+	const int required = snprintf(scratch, sizeof(scratch), spec, args...);
+	if (required <= 0) {
+		return;
+	}
+	const size_t length = static_cast<size_t>(required);
+	if (length < sizeof(scratch)) {
+		out.append(scratch, length);
+		return;
+	}
+	const size_t offset = out.size();
+	out.resize(offset + length);
+	snprintf(&out[offset], length + 1, spec, args...);
+}
+
+template <typename T>
+void appendConversion(
+    std::string &out,
+    const char *spec,
+    const int *stars,
+    size_t starCount,
+    T value
+) {
+	switch (starCount) {
+	case 0:
+		appendPrintf(out, spec, value);
+		break;
+	case 1:
+		appendPrintf(out, spec, stars[0], value);
+		break;
+	default:
+		appendPrintf(out, spec, stars[0], stars[1], value);
+		break;
+	}
+}
+
+template <typename T>
+bool renderValue(
+    std::string &out,
+    const char *spec,
+    const int *stars,
+    size_t starCount,
+    const char *&cursor,
+    const char *end
+) {
+	T value{};
+	if (!readRaw(cursor, end, value)) {
+		return false;
+	}
+	appendConversion(out, spec, stars, starCount, value);
+	return true;
+}
+
+} // namespace
+
+bool isStaticFormat(const char *fmt) {
+#if ESPLOGGER_CAN_CHECK_DROM
+	return esp_ptr_in_drom(fmt);
+#elif ESPLOGGER_TRUST_FORMAT_POINTERS
+	return fmt != nullptr;
+#else
+	(void)fmt;
+	return false;
+#endif
+}
+
+bool packArguments(const char *fmt, va_list args, std::string &out) {
+	if (fmt == nullptr) {
+		return false;
+	}
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	bool packed = true;
+	// Set once the output is known to hold at least one character.
+	bool nonEmpty = false;
+
+	const char *cursor = fmt;
+	while (packed && *cursor != '\0') {
+		if (*cursor != '%') {
+			nonEmpty = true;
+			++cursor;
+			continue;
+		}
+		if (cursor[1] == '%') {
+			nonEmpty = true;
+			cursor += 2;
+			continue;
+		}
+
+		Conversion conversion;
+		cursor = parseConversion(cursor, conversion);
+		if (conversion.kind == ArgKind::Unsupported) {
+			packed = false;
+			break;
+		}
+
+		if (conversion.widthFromArg) {
+			appendRaw(out, va_arg(argsCopy, int));
+		}
+		int precision = conversion.precision;
+		if (conversion.precisionFromArg) {
+			precision = va_arg(argsCopy, int);
+			appendRaw(out, precision);
+		}
+		// Numbers print at least one digit unless a precision of zero is given.
+		nonEmpty = nonEmpty || (conversion.kind != ArgKind::String && precision < 0);
+
+		switch (conversion.kind) {
+		case ArgKind::Int:
+			appendRaw(out, va_arg(argsCopy, int));
+			break;
+		case ArgKind::Long:
+			appendRaw(out, va_arg(argsCopy, long));
+			break;
+		case ArgKind::LongLong:
+			appendRaw(out, va_arg(argsCopy, long long));
+			break;
+		case ArgKind::IntMax:
+			appendRaw(out, va_arg(argsCopy, intmax_t));
+			break;
+		case ArgKind::Size:
+			appendRaw(out, va_arg(argsCopy, size_t));
+			break;
+		case ArgKind::PtrDiff:
+			appendRaw(out, va_arg(argsCopy, ptrdiff_t));
+			break;
+		case ArgKind::Double:
+			appendRaw(out, va_arg(argsCopy, double));
+			break;
+		case ArgKind::LongDouble:
+			appendRaw(out, va_arg(argsCopy, long double));
+			break;
+		case ArgKind::Pointer:
+			appendRaw(out, va_arg(argsCopy, void *));
+			break;
+		case ArgKind::String: {
+			const char *text = va_arg(argsCopy, const char *);
+			if (text == nullptr) {
+				text = kNullString;
+			}
+			// A precision bounds the read, so the argument need not be NUL-terminated.
+			const size_t textLength = precision >= 0
+			                              ? strnlen(text, static_cast<size_t>(precision))
+			                              : std::strlen(text);
+			const uint32_t length = static_cast<uint32_t>(textLength);
+			appendRaw(out, length);
+			out.append(text, length);
+			out.push_back('\0');
+			nonEmpty = nonEmpty || length > 0;
+			break;
+		}
+		case ArgKind::Unsupported:
+			packed = false;
+			break;
+		}
+	}
+
+	va_end(argsCopy);
+	return packed && nonEmpty;
+}
+
+std::string renderMessage(const char *fmt, const char *packed, size_t packedSize) {
+	std::string out;
+	if (fmt == nullptr) {
+		return out;
+	}
+
+	const char *data = packed;
+	const char *end = packed + packedSize;
+	const char *cursor = fmt;
+	const char *literalStart = fmt;
+
+	while (*cursor != '\0') {
+		if (*cursor != '%') {
+			++cursor;
+			continue;
+		}
+
+		out.append(literalStart, static_cast<size_t>(cursor - literalStart));
+		if (cursor[1] == '%') {
+			out.push_back('%');
+			cursor += 2;
+			literalStart = cursor;
+			continue;
+		}
+
+		Conversion conversion;
+		cursor = parseConversion(cursor, conversion);
+		literalStart = cursor;
+		if (conversion.kind == ArgKind::Unsupported) {
+			// packArguments rejects these, so this only triggers on corrupted input.
+			break;
+		}
+
+		char spec[kMaxSpecLength];
+		std::memcpy(spec, conversion.begin, conversion.length);
+		spec[conversion.length] = '\0';
+
+		int stars[2] = {0, 0};
+		size_t starCount = 0;
+		if (conversion.widthFromArg && !readRaw(data, end, stars[starCount++])) {
+			break;
+		}
+		if (conversion.precisionFromArg && !readRaw(data, end, stars[starCount++])) {
+			break;
+		}
+
+		bool rendered = true;
+		switch (conversion.kind) {
+		case ArgKind::Int:
+			rendered = renderValue<int>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::Long:
+			rendered = renderValue<long>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::LongLong:
+			rendered = renderValue<long long>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::IntMax:
+			rendered = renderValue<intmax_t>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::Size:
+			rendered = renderValue<size_t>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::PtrDiff:
+			rendered = renderValue<ptrdiff_t>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::Double:
+			rendered = renderValue<double>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::LongDouble:
+			rendered = renderValue<long double>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::Pointer:
+			rendered = renderValue<void *>(out, spec, stars, starCount, data, end);
+			break;
+		case ArgKind::String: {
+			uint32_t length = 0;
+			if (!readRaw(data, end, length) || static_cast<size_t>(end - data) < length + 1u) {
+				rendered = false;
+				break;
+			}
+			appendConversion(out, spec, stars, starCount, data);
+			data += length + 1u;
+			break;
+		}
+		case ArgKind::Unsupported:
+			rendered = false;
+			break;
+		}
+
+		if (!rendered) {
+			break;
+		}
+	}
+
+	if (*cursor == '\0') {
+		out.append(literalStart, static_cast<size_t>(cursor - literalStart));
+	}
+	return out;
+}
+
+} // namespace logger_deferred_detail
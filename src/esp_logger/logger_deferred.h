@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <string>
+
+// Deferred printf support: the caller captures the format pointer plus the raw argument
+// bytes, and the text is rendered later on the sync/query path. Only the arguments are
+// copied on the hot path; strings passed through `%s` are copied by value because their
+// storage may not outlive the call.
+namespace logger_deferred_detail {
+
+// Returns true when `fmt` points at storage that outlives the call (string literals in
+// flash on ESP32). Deferred records keep the pointer, so anything else is formatted
+// immediately instead. Where flash cannot be checked this is false unless the build
+// defines ESPLOGGER_TRUST_FORMAT_POINTERS=1.
+bool isStaticFormat(const char *fmt);
+
+// Walks `fmt` and appends each argument's raw bytes to `out`. Returns false (leaving
+// `out` in an unspecified state) for conversions that cannot be deferred, such as `%n`
+// or wide strings, and when the message might render empty; callers then fall back to
+// immediate formatting, which drops empty messages.
+bool packArguments(const char *fmt, va_list args, std::string &out);
+
+// Renders `fmt` using the arguments captured by `packArguments`.
+std::string renderMessage(const char *fmt, const char *packed, size_t packedSize);
+
+inline std::string renderMessage(const char *fmt, const std::string &packed) {
+	return renderMessage(fmt, packed.data(), packed.size());
+}
+
+} // namespace logger_deferred_detail
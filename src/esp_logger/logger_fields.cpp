@@ -0,0 +1,322 @@
+#include "esp_logger/logger_fields.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace logger_fields_detail {
+
+const char kFieldsFormat[] = "{fields}";
+
+} // namespace logger_fields_detail
+
+namespace {
+
+using logger_fmt_detail::ArgKind;
+using logger_fmt_detail::FormatArg;
+
+constexpr size_t kMaxKeyLength = 255;
+
+void appendVarint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const char *&cursor, const char *end, uint64_t &value) {
+	value = 0;
+	for (unsigned shift = 0; cursor < end && shift < 64; shift += 7) {
+		const uint8_t byte = static_cast<uint8_t>(*cursor++);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename T> void appendRaw(std::string &out, T value) {
+	out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> bool readRaw(const char *&cursor, const char *end, T &value) {
+	if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+		return false;
+	}
+	std::memcpy(&value, cursor, sizeof(T));
+	cursor += sizeof(T);
+	return true;
+}
+
+bool needsQuotes(std::string_view text) {
+	if (text.empty()) {
+		return true;
+	}
+	for (const char value : text) {
+		if (value == ' ' || value == '"' || value == '=' || static_cast<uint8_t>(value) < 0x20) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void appendEscaped(std::string &out, std::string_view text) {
+	static const char kHex[] = "0123456789abcdef";
+	for (const char value : text) {
+		const uint8_t byte = static_cast<uint8_t>(value);
+		switch (value) {
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			if (byte < 0x20) {
+				out += "\\u00";
+				out.push_back(kHex[byte >> 4]);
+				out.push_back(kHex[byte & 0x0F]);
+			} else {
+				out.push_back(value);
+			}
+			break;
+		}
+	}
+}
+
+} // namespace
+
+namespace logger_fields_detail {
+
+// Renders a numeric field through the `{}` formatter so text, JSON and typed log calls
+// agree on number formatting.
+void appendFieldNumber(std::string &out, const LogField &field) {
+	FormatArg arg;
+	switch (field.type) {
+	case LogFieldType::Int:
+		arg.kind = ArgKind::Signed;
+		arg.signedValue = field.intValue;
+		break;
+	case LogFieldType::Uint:
+		arg.kind = ArgKind::Unsigned;
+		arg.unsignedValue = field.uintValue;
+		break;
+	case LogFieldType::Float:
+		arg.kind = ArgKind::Float;
+		arg.floatValue = field.floatValue;
+		break;
+	default:
+		arg.kind = ArgKind::Double;
+		arg.floatValue = field.floatValue;
+		break;
+	}
+	out += logger_fmt_detail::formatArgs("{}", &arg, 1);
+}
+
+void appendJsonString(std::string &out, std::string_view text) {
+	out.push_back('"');
+	appendEscaped(out, text);
+	out.push_back('"');
+}
+
+} // namespace logger_fields_detail
+
+bool LogFieldReader::next(LogField &field) {
+	if (_end - _cursor < 2) {
+		return false;
+	}
+	const uint8_t type = static_cast<uint8_t>(*_cursor++);
+	const size_t keyLength = static_cast<uint8_t>(*_cursor++);
+	if (type > static_cast<uint8_t>(LogFieldType::String) ||
+	    static_cast<size_t>(_end - _cursor) < keyLength) {
+		_cursor = _end;
+		return false;
+	}
+
+	field = LogField{};
+	field.type = static_cast<LogFieldType>(type);
+	field.key = std::string_view(_cursor, keyLength);
+	_cursor += keyLength;
+
+	bool valid = true;
+	uint64_t raw = 0;
+	switch (field.type) {
+	case LogFieldType::Int:
+		valid = readVarint(_cursor, _end, raw);
+		field.intValue = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+		break;
+	case LogFieldType::Uint:
+		valid = readVarint(_cursor, _end, field.uintValue);
+		break;
+	case LogFieldType::Float: {
+		float value = 0.0f;
+		valid = readRaw(_cursor, _end, value);
+		field.floatValue = value;
+		break;
+	}
+	case LogFieldType::Double:
+		valid = readRaw(_cursor, _end, field.floatValue);
+		break;
+	case LogFieldType::False:
+	case LogFieldType::True:
+		break;
+	case LogFieldType::String:
+		valid = readVarint(_cursor, _end, raw) && raw <= static_cast<uint64_t>(_end - _cursor);
+		if (valid) {
+			field.text = std::string_view(_cursor, static_cast<size_t>(raw));
+			_cursor += raw;
+		}
+		break;
+	}
+	if (!valid) {
+		_cursor = _end;
+	}
+	return valid;
+}
+
+std::string logFieldsToText(std::string_view fields) {
+	std::string out;
+	LogFieldReader reader(fields);
+	LogField field;
+	while (reader.next(field)) {
+		if (!out.empty()) {
+			out.push_back(' ');
+		}
+		out.append(field.key.data(), field.key.size());
+		out.push_back('=');
+		switch (field.type) {
+		case LogFieldType::False:
+		case LogFieldType::True:
+			out += field.boolValue() ? "true" : "false";
+			break;
+		case LogFieldType::String:
+			if (needsQuotes(field.text)) {
+				logger_fields_detail::appendJsonString(out, field.text);
+			} else {
+				out.append(field.text.data(), field.text.size());
+			}
+			break;
+		default:
+			logger_fields_detail::appendFieldNumber(out, field);
+			break;
+		}
+	}
+	return out;
+}
+
+std::string logFieldsToJson(std::string_view fields) {
+	std::string out = "{";
+	LogFieldReader reader(fields);
+	LogField field;
+	while (reader.next(field)) {
+		if (out.size() > 1) {
+			out.push_back(',');
+		}
+		logger_fields_detail::appendJsonString(out, field.key);
+		out.push_back(':');
+		switch (field.type) {
+		case LogFieldType::False:
+		case LogFieldType::True:
+			out += field.boolValue() ? "true" : "false";
+			break;
+		case LogFieldType::String:
+			logger_fields_detail::appendJsonString(out, field.text);
+			break;
+		case LogFieldType::Float:
+		case LogFieldType::Double:
+			if (!std::isfinite(field.floatValue)) {
+				out += "null";
+				break;
+			}
+			logger_fields_detail::appendFieldNumber(out, field);
+			break;
+		default:
+			logger_fields_detail::appendFieldNumber(out, field);
+			break;
+		}
+	}
+	out.push_back('}');
+	return out;
+}
+
+namespace logger_fields_detail {
+
+void appendField(std::string &out, const char *key, const FormatArg &value) {
+	if (key == nullptr) {
+		key = "";
+	}
+	const size_t keyLength = std::min(std::strlen(key), kMaxKeyLength);
+
+	LogFieldType type = LogFieldType::Uint;
+	switch (value.kind) {
+	case ArgKind::Bool:
+		type = value.unsignedValue != 0 ? LogFieldType::True : LogFieldType::False;
+		break;
+	case ArgKind::Signed:
+		type = LogFieldType::Int;
+		break;
+	case ArgKind::Float:
+		type = LogFieldType::Float;
+		break;
+	case ArgKind::Double:
+		type = LogFieldType::Double;
+		break;
+	case ArgKind::Char:
+	case ArgKind::String:
+		type = LogFieldType::String;
+		break;
+	default:
+		break;
+	}
+
+	out.push_back(static_cast<char>(type));
+	out.push_back(static_cast<char>(keyLength));
+	out.append(key, keyLength);
+
+	switch (value.kind) {
+	case ArgKind::Signed:
+		appendVarint(
+		    out,
+		    (static_cast<uint64_t>(value.signedValue) << 1) ^
+		        static_cast<uint64_t>(value.signedValue >> 63)
+		);
+		break;
+	case ArgKind::Unsigned:
+		appendVarint(out, value.unsignedValue);
+		break;
+	case ArgKind::Pointer:
+		appendVarint(out, reinterpret_cast<uintptr_t>(value.pointer));
+		break;
+	case ArgKind::Float:
+		appendRaw(out, static_cast<float>(value.floatValue));
+		break;
+	case ArgKind::Double:
+		appendRaw(out, value.floatValue);
+		break;
+	case ArgKind::Char: {
+		const char character = static_cast<char>(value.unsignedValue);
+		appendVarint(out, 1);
+		out.push_back(character);
+		break;
+	}
+	case ArgKind::String:
+		appendVarint(out, value.text.size);
+		out.append(value.text.data, value.text.size);
+		break;
+	default:
+		break;
+	}
+}
+
+} // namespace logger_fields_detail
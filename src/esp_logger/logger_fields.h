@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "esp_logger/logger_fmt.h"
+
+// Typed key/value fields for structured entries (`logger.info("NET").kv("rssi", -61)`).
+// The builder appends each field to the record payload in a compact binary form; the
+// text and JSON renderings are produced on the consumer side, never on the logging call.
+//
+// Encoding, per field: type byte, key length byte, key bytes, then the value: a varint
+// (zigzag for signed integers), a little-endian float or double, nothing for booleans, or
+// a varint length followed by the string bytes.
+enum class LogFieldType : uint8_t { Int, Uint, Float, Double, False, True, String };
+
+struct LogField {
+	std::string_view key;
+	LogFieldType type = LogFieldType::Int;
+	int64_t intValue = 0;
+	uint64_t uintValue = 0;
+	double floatValue = 0.0;
+	std::string_view text;
+
+	bool boolValue() const {
+		return type == LogFieldType::True;
+	}
+};
+
+// Iterates the encoded fields carried in `Log::fields`. Stops at the first malformed field.
+class LogFieldReader {
+  public:
+	explicit LogFieldReader(std::string_view fields)
+	    : _cursor(fields.data()), _end(fields.data() + fields.size()) {
+	}
+
+	bool next(LogField &field);
+
+  private:
+	const char *_cursor;
+	const char *_end;
+};
+
+// `rssi=-61 ip=10.0.0.7`; strings with spaces, quotes or `=` are quoted.
+std::string logFieldsToText(std::string_view fields);
+// `{"rssi":-61,"ip":"10.0.0.7"}`; non-finite numbers become null.
+std::string logFieldsToJson(std::string_view fields);
+
+namespace logger_fields_detail {
+
+// Format-pointer sentinel that marks a record's payload as encoded fields, so structured
+// records travel through the deque, ring and arena exactly like deferred printf records.
+extern const char kFieldsFormat[];
+
+void appendField(std::string &out, const char *key, const logger_fmt_detail::FormatArg &value);
+// Appends a numeric field as text, formatted like a `{}` placeholder.
+void appendFieldNumber(std::string &out, const LogField &field);
+// Appends `text` as a quoted, escaped JSON string.
+void appendJsonString(std::string &out, std::string_view text);
+
+} // namespace logger_fields_detail
@@ -0,0 +1,276 @@
+#include "esp_logger/logger_fmt.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "esp_logger/logger_format.h"
+
+namespace logger_fmt_detail {
+
+namespace {
+
+constexpr uint64_t kPowersOfTen[] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+};
+constexpr int kMaxPrecision = 9;
+// Fixed notation is used below this magnitude; larger values switch to scientific so the
+// integer part always fits in 64 bits.
+constexpr double kFixedLimit = 1e16;
+// `{}` on floating point values prints about as many significant digits as the type holds.
+constexpr int kFloatDigits = 7;
+constexpr int kDoubleDigits = 15;
+
+// Fills the caller's stack scratch buffer first and only spills to the heap for messages
+// longer than logger_format_detail::kScratchSize.
+class MessageWriter {
+  public:
+	void append(const char *data, size_t size) {
+		if (!_spilled && _size + size <= sizeof(_scratch)) {
+			std::memcpy(_scratch + _size, data, size);
+			_size += size;
+			return;
+		}
+		if (!_spilled) {
+			_spill.reserve(_size + size + sizeof(_scratch));
+			_spill.assign(_scratch, _size);
+			_spilled = true;
+		}
+		_spill.append(data, size);
+	}
+
+	void push(char value) {
+		append(&value, 1);
+	}
+
+	std::string take() {
+		return _spilled ? std::move(_spill) : std::string(_scratch, _size);
+	}
+
+  private:
+	char _scratch[logger_format_detail::kScratchSize];
+	size_t _size = 0;
+	bool _spilled = false;
+	std::string _spill;
+};
+
+void writeUnsigned(MessageWriter &out, uint64_t value, unsigned base, bool upper) {
+	const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char buffer[24];
+	char *end = buffer + sizeof(buffer);
+	char *cursor = end;
+	do {
+		*--cursor = digits[value % base];
+		value /= base;
+	} while (value != 0);
+	out.append(cursor, static_cast<size_t>(end - cursor));
+}
+
+void writeSigned(MessageWriter &out, int64_t value, unsigned base, bool upper) {
+	uint64_t magnitude = static_cast<uint64_t>(value);
+	if (value < 0) {
+		out.push('-');
+		magnitude = 0 - magnitude;
+	}
+	writeUnsigned(out, magnitude, base, upper);
+}
+
+// Writes `fraction` as exactly `precision` digits, or without trailing zeros when `trim`
+// is set (dropping the decimal point if nothing is left).
+void writeFraction(MessageWriter &out, uint64_t fraction, int precision, bool trim) {
+	if (precision <= 0) {
+		return;
+	}
+	char buffer[kMaxPrecision];
+	for (int index = precision - 1; index >= 0; --index) {
+		buffer[index] = static_cast<char>('0' + fraction % 10);
+		fraction /= 10;
+	}
+	size_t length = static_cast<size_t>(precision);
+	if (trim) {
+		while (length > 0 && buffer[length - 1] == '0') {
+			--length;
+		}
+	}
+	if (length > 0) {
+		out.push('.');
+		out.append(buffer, length);
+	}
+}
+
+void writeFixed(MessageWriter &out, double value, int precision, bool trim) {
+	uint64_t integer = static_cast<uint64_t>(value);
+	const uint64_t scale = kPowersOfTen[precision];
+	uint64_t fraction =
+	    static_cast<uint64_t>((value - static_cast<double>(integer)) * scale + 0.5);
+	if (fraction >= scale) {
+		++integer;
+		fraction -= scale;
+	}
+	writeUnsigned(out, integer, 10, false);
+	writeFraction(out, fraction, precision, trim);
+}
+
+void writeScientific(MessageWriter &out, double value, int precision, bool trim) {
+	int exponent = 0;
+	while (value >= 10.0) {
+		value /= 10.0;
+		++exponent;
+	}
+	while (value < 1.0) {
+		value *= 10.0;
+		--exponent;
+	}
+	const uint64_t scale = kPowersOfTen[precision];
+	uint64_t mantissa = static_cast<uint64_t>(value * scale + 0.5);
+	if (mantissa >= 10 * scale) {
+		mantissa /= 10;
+		++exponent;
+	}
+	writeUnsigned(out, mantissa / scale, 10, false);
+	writeFraction(out, mantissa % scale, precision, trim);
+	out.push('e');
+	out.push(exponent < 0 ? '-' : '+');
+	if (exponent > -10 && exponent < 10) {
+		out.push('0');
+	}
+	writeUnsigned(out, static_cast<uint64_t>(exponent < 0 ? -exponent : exponent), 10, false);
+}
+
+// `precision` < 0 selects the `{}` default: enough digits for the source type, trailing
+// zeros trimmed, scientific notation for magnitudes fixed notation cannot show.
+void writeFloat(MessageWriter &out, double value, int precision, int significantDigits) {
+	if (std::isnan(value)) {
+		out.append("nan", 3);
+		return;
+	}
+	if (std::signbit(value)) {
+		out.push('-');
+		value = -value;
+	}
+	if (std::isinf(value)) {
+		out.append("inf", 3);
+		return;
+	}
+
+	const bool trim = precision < 0;
+	if (value >= kFixedLimit || (trim && value != 0.0 && value < 1e-4)) {
+		const int digits = significantDigits - 1 < kMaxPrecision ? significantDigits - 1
+		                                                         : kMaxPrecision;
+		writeScientific(out, value, trim ? digits : precision, trim);
+		return;
+	}
+	if (trim) {
+		int integerDigits = 1;
+		for (double bound = 10.0; value >= bound && integerDigits < significantDigits;
+		     bound *= 10.0) {
+			++integerDigits;
+		}
+		precision = significantDigits - integerDigits;
+		if (precision > kMaxPrecision) {
+			precision = kMaxPrecision;
+		}
+	}
+	writeFixed(out, value, precision, trim);
+}
+
+void writeArg(MessageWriter &out, const FormatArg &arg, char spec, int precision) {
+	const bool hex = spec == 'x' || spec == 'X';
+	const unsigned base = hex ? 16 : 10;
+	switch (arg.kind) {
+	case ArgKind::Bool:
+		if (arg.unsignedValue != 0) {
+			out.append("true", 4);
+		} else {
+			out.append("false", 5);
+		}
+		break;
+	case ArgKind::Char:
+		out.push(static_cast<char>(arg.unsignedValue));
+		break;
+	case ArgKind::Signed:
+		writeSigned(out, arg.signedValue, base, spec == 'X');
+		break;
+	case ArgKind::Unsigned:
+		writeUnsigned(out, arg.unsignedValue, base, spec == 'X');
+		break;
+	case ArgKind::Float:
+		writeFloat(out, arg.floatValue, precision, kFloatDigits);
+		break;
+	case ArgKind::Double:
+		writeFloat(out, arg.floatValue, precision, kDoubleDigits);
+		break;
+	case ArgKind::String:
+		out.append(arg.text.data, arg.text.size);
+		break;
+	case ArgKind::Pointer:
+		out.append("0x", 2);
+		writeUnsigned(out, reinterpret_cast<uintptr_t>(arg.pointer), 16, false);
+		break;
+	case ArgKind::Unsupported:
+		break;
+	}
+}
+
+} // namespace
+
+std::string formatArgs(const char *fmt, const FormatArg *args, size_t count) {
+	MessageWriter out;
+	size_t argIndex = 0;
+	const char *literalStart = fmt;
+	const char *cursor = fmt;
+
+	while (*cursor != '\0') {
+		if (*cursor != '{' && *cursor != '}') {
+			++cursor;
+			continue;
+		}
+
+		out.append(literalStart, static_cast<size_t>(cursor - literalStart));
+		if (cursor[1] == *cursor) {
+			// `{{` or `}}`: keep one brace.
+			out.push(*cursor);
+			cursor += 2;
+			literalStart = cursor;
+			continue;
+		}
+
+		// validate() has already accepted the spec, so only the known shapes remain.
+		++cursor;
+		char spec = '\0';
+		int precision = -1;
+		if (*cursor == ':') {
+			++cursor;
+			if (*cursor == 'x' || *cursor == 'X') {
+				spec = *cursor++;
+			} else if (*cursor == '.') {
+				precision = cursor[1] - '0';
+				cursor += 2;
+				if (*cursor == 'f') {
+					++cursor;
+				}
+			}
+		}
+		if (*cursor == '}') {
+			++cursor;
+		}
+		literalStart = cursor;
+
+		if (argIndex < count) {
+			writeArg(out, args[argIndex++], spec, precision);
+		}
+	}
+
+	out.append(literalStart, static_cast<size_t>(cursor - literalStart));
+	return out.take();
+}
+
+} // namespace logger_fmt_detail
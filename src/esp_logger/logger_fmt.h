@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Type-safe `{}` formatting for the template logging overloads. The format string is
+// wrapped with ESPLOGGER_FMT so it is a compile-time constant: placeholder count and
+// specs are checked against the argument types when the call is compiled, and the text
+// is rendered by a dedicated writer instead of vsnprintf.
+//
+// Placeholders: `{}` for any argument, `{:x}`/`{:X}` for integers in hex, `{:.N}` (or
+// `{:.Nf}`, N = 0..9) for fixed floating-point precision. `{{` and `}}` are literal braces.
+namespace logger_fmt_detail {
+
+// Base of the types generated by ESPLOGGER_FMT; used to pick the template overloads.
+struct FormatString {};
+
+template <typename T>
+using EnableIfFormat = std::enable_if_t<std::is_base_of<FormatString, T>::value, int>;
+
+enum class ArgKind : uint8_t {
+	Bool,
+	Char,
+	Signed,
+	Unsigned,
+	Float,
+	Double,
+	String,
+	Pointer,
+	Unsupported
+};
+
+enum class FormatError : uint8_t {
+	None,
+	TooFewArguments,
+	TooManyArguments,
+	UnmatchedBrace,
+	BadSpec,
+	SpecTypeMismatch,
+	UnsupportedArgument
+};
+
+template <typename T, typename = void> struct ArgKindOf {
+	static constexpr ArgKind value = ArgKind::Unsupported;
+};
+
+template <typename T>
+struct ArgKindOf<T, std::enable_if_t<std::is_integral<T>::value>> {
+	static constexpr ArgKind value = std::is_same<T, bool>::value   ? ArgKind::Bool
+	                                 : std::is_same<T, char>::value ? ArgKind::Char
+	                                 : std::is_signed<T>::value     ? ArgKind::Signed
+	                                                                : ArgKind::Unsigned;
+};
+
+template <typename T>
+struct ArgKindOf<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+	static constexpr ArgKind value = std::is_same<T, float>::value ? ArgKind::Float
+	                                                               : ArgKind::Double;
+};
+
+template <typename T> struct ArgKindOf<T, std::enable_if_t<std::is_pointer<T>::value>> {
+	static constexpr ArgKind value =
+	    std::is_same<std::remove_cv_t<std::remove_pointer_t<T>>, char>::value ? ArgKind::String
+	                                                                          : ArgKind::Pointer;
+};
+
+template <> struct ArgKindOf<std::nullptr_t> {
+	static constexpr ArgKind value = ArgKind::Pointer;
+};
+
+template <> struct ArgKindOf<std::string> {
+	static constexpr ArgKind value = ArgKind::String;
+};
+
+template <> struct ArgKindOf<std::string_view> {
+	static constexpr ArgKind value = ArgKind::String;
+};
+
+// Arrays decay so string literals and char buffers map to ArgKind::String.
+template <typename T> constexpr ArgKind argKind() {
+	return ArgKindOf<std::decay_t<T>>::value;
+}
+
+constexpr bool isIntegerKind(ArgKind kind) {
+	return kind == ArgKind::Signed || kind == ArgKind::Unsigned;
+}
+
+constexpr bool isFloatKind(ArgKind kind) {
+	return kind == ArgKind::Float || kind == ArgKind::Double;
+}
+
+// Checks `fmt` against the argument kinds. Runs at compile time from checkFormat().
+constexpr FormatError validate(const char *fmt, const ArgKind *kinds, size_t count) {
+	for (size_t index = 0; index < count; ++index) {
+		if (kinds[index] == ArgKind::Unsupported) {
+			return FormatError::UnsupportedArgument;
+		}
+	}
+
+	size_t argIndex = 0;
+	for (const char *cursor = fmt; *cursor != '\0'; ++cursor) {
+		if (*cursor == '}') {
+			if (cursor[1] != '}') {
+				return FormatError::UnmatchedBrace;
+			}
+			++cursor;
+			continue;
+		}
+		if (*cursor != '{') {
+			continue;
+		}
+		if (cursor[1] == '{') {
+			++cursor;
+			continue;
+		}
+
+		++cursor;
+		if (argIndex >= count) {
+			return FormatError::TooManyArguments;
+		}
+		const ArgKind kind = kinds[argIndex++];
+		if (*cursor == ':') {
+			++cursor;
+			if (*cursor == 'x' || *cursor == 'X') {
+				if (!isIntegerKind(kind)) {
+					return FormatError::SpecTypeMismatch;
+				}
+				++cursor;
+			} else if (*cursor == '.') {
+				++cursor;
+				if (*cursor < '0' || *cursor > '9') {
+					return FormatError::BadSpec;
+				}
+				if (!isFloatKind(kind)) {
+					return FormatError::SpecTypeMismatch;
+				}
+				++cursor;
+				if (*cursor == 'f') {
+					++cursor;
+				}
+			}
+		}
+		if (*cursor == '\0') {
+			return FormatError::UnmatchedBrace;
+		}
+		if (*cursor != '}') {
+			return FormatError::BadSpec;
+		}
+	}
+	return argIndex == count ? FormatError::None : FormatError::TooFewArguments;
+}
+
+template <typename Format, typename... Args> constexpr void checkFormat() {
+	// The trailing entry keeps the array non-empty for calls without arguments.
+	constexpr ArgKind kinds[] = {argKind<Args>()..., ArgKind::Unsupported};
+	constexpr FormatError error = validate(Format::value(), kinds, sizeof...(Args));
+	static_assert(
+	    error != FormatError::UnsupportedArgument,
+	    "ESPLOGGER_FMT: argument type cannot be formatted"
+	);
+	static_assert(
+	    error != FormatError::TooManyArguments,
+	    "ESPLOGGER_FMT: more placeholders than arguments"
+	);
+	static_assert(
+	    error != FormatError::TooFewArguments,
+	    "ESPLOGGER_FMT: more arguments than placeholders"
+	);
+	static_assert(error != FormatError::UnmatchedBrace, "ESPLOGGER_FMT: unmatched brace");
+	static_assert(error != FormatError::BadSpec, "ESPLOGGER_FMT: unknown placeholder spec");
+	static_assert(
+	    error != FormatError::SpecTypeMismatch,
+	    "ESPLOGGER_FMT: spec does not match the argument type"
+	);
+}
+
+struct TextArg {
+	const char *data;
+	size_t size;
+};
+
+// Type-erased argument; the referenced text only has to live for the formatting call.
+struct FormatArg {
+	ArgKind kind = ArgKind::Unsupported;
+	union {
+		long long signedValue;
+		unsigned long long unsignedValue;
+		double floatValue;
+		const void *pointer;
+		TextArg text;
+	};
+};
+
+template <typename T> FormatArg makeArg(const T &value) {
+	FormatArg arg;
+	arg.kind = argKind<T>();
+	if constexpr (std::is_same<T, bool>::value || std::is_same<T, char>::value) {
+		arg.unsignedValue = static_cast<unsigned char>(value);
+	} else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+		arg.signedValue = value;
+	} else if constexpr (std::is_integral<T>::value) {
+		arg.unsignedValue = value;
+	} else if constexpr (std::is_floating_point<T>::value) {
+		arg.floatValue = static_cast<double>(value);
+	} else if constexpr (argKind<T>() == ArgKind::String) {
+		const std::string_view text = value;
+		arg.text.data = text.data();
+		arg.text.size = text.size();
+	} else if constexpr (argKind<T>() == ArgKind::Pointer) {
+		arg.pointer = value;
+	}
+	return arg;
+}
+
+inline FormatArg makeArg(const char *value) {
+	FormatArg arg;
+	arg.kind = ArgKind::String;
+	arg.text.data = value != nullptr ? value : "(null)";
+	arg.text.size = std::char_traits<char>::length(arg.text.data);
+	return arg;
+}
+
+inline FormatArg makeArg(char *value) {
+	return makeArg(static_cast<const char *>(value));
+}
+
+// Renders a validated format string. Output goes through the same stack scratch buffer
+// as the printf path and is copied into the returned string once.
+std::string formatArgs(const char *fmt, const FormatArg *args, size_t count);
+
+template <typename... Args> std::string format(const char *fmt, const Args &...args) {
+	if constexpr (sizeof...(Args) == 0) {
+		return formatArgs(fmt, nullptr, 0);
+	} else {
+		const FormatArg packed[] = {makeArg(args)...};
+		return formatArgs(fmt, packed, sizeof...(Args));
+	}
+}
+
+} // namespace logger_fmt_detail
+
+// Wraps a string literal so the template logging overloads can check it at compile time:
+// `logger.info("NET", ESPLOGGER_FMT("rssi={} ip={}"), rssi, ip.c_str())`.
+#define ESPLOGGER_FMT(text)                                                                        \
+	([] {                                                                                          \
+		struct EspLoggerFormat : logger_fmt_detail::FormatString {                                 \
+			static constexpr const char *value() {                                                 \
+				return text;                                                                       \
+			}                                                                                      \
+		};                                                                                         \
+		return EspLoggerFormat{};                                                                  \
+	}())
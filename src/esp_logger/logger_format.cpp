@@ -0,0 +1,38 @@
+#include "esp_logger/logger_format.h"
+
+#include <cstdio>
+
+namespace logger_format_detail {
+
+std::string formatMessage(const char *fmt, va_list args) {
+	if (fmt == nullptr) {
+		return {};
+	}
+
+	char scratch[kScratchSize];
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	const int required = vsnprintf(scratch, sizeof(scratch), fmt, argsCopy);
+	va_end(argsCopy);
+
+	if (required <= 0) {
+		return {};
+	}
+
+	const size_t length = static_cast<size_t>(required);
+	if (length < sizeof(scratch)) {
+		return std::string(scratch, length);
+	}
+
+	// Oversized message: the first pass already measured it, so format straight into
+	// the final string storage instead of staging through another buffer.
+	std::string message(length, '\0');
+	va_list argsCopy2;
+	va_copy(argsCopy2, args);
+	vsnprintf(&message[0], length + 1, fmt, argsCopy2);
+	va_end(argsCopy2);
+	return message;
+}
+
+} // namespace logger_format_detail
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <string>
+
+// Size of the on-stack scratch buffer used to format messages in a single pass.
+// Messages that fit (the common case) never touch the heap until they are moved
+// into the stored entry; longer ones fall back to one measured allocation.
+#ifndef ESPLOGGER_FORMAT_SCRATCH_SIZE
+#define ESPLOGGER_FORMAT_SCRATCH_SIZE 128
+#endif
+
+namespace logger_format_detail {
+
+constexpr size_t kScratchSize = ESPLOGGER_FORMAT_SCRATCH_SIZE;
+
+// Formats `fmt` with `args` into a string. `args` is consumed through copies, so the
+// caller keeps ownership of the original list.
+std::string formatMessage(const char *fmt, va_list args);
+
+} // namespace logger_format_detail
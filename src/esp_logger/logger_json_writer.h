@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ArduinoJson `Writer` adapter: serializeJson/serializeJsonPretty/serializeMsgPack accept
+// any class with these two `write` overloads. Output is appended to `out` in place, so a
+// document is serialized in one pass straight into the string that becomes the record
+// payload, and the serializer's return value is the length without a measure pass.
+class LogStringWriter {
+  public:
+	explicit LogStringWriter(std::string &out) : _out(out) {
+	}
+
+	size_t write(uint8_t value) {
+		_out.push_back(static_cast<char>(value));
+		return 1;
+	}
+
+	size_t write(const uint8_t *data, size_t size) {
+		_out.append(reinterpret_cast<const char *>(data), size);
+		return size;
+	}
+
+  private:
+	std::string &_out;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+class LockGuard {
+  public:
+	explicit LockGuard(SemaphoreHandle_t handle) : _handle(handle) {
+		if (_handle != nullptr) {
+			xSemaphoreTake(_handle, portMAX_DELAY);
+		}
+	}
+
+	~LockGuard() {
+		if (_handle != nullptr) {
+			xSemaphoreGive(_handle);
+		}
+	}
+
+	LockGuard(const LockGuard &) = delete;
+	LockGuard &operator=(const LockGuard &) = delete;
+
+  private:
+	SemaphoreHandle_t _handle;
+};
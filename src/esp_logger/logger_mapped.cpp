@@ -0,0 +1,67 @@
+#include "esp_logger/logger_mapped.h"
+
+#if ESPLOGGER_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LogMappedFile::~LogMappedFile() {
+	close();
+}
+
+bool LogMappedFile::open(const char *path, size_t size, bool readOnly) {
+	close();
+#if ESPLOGGER_HAS_MMAP
+	if (path == nullptr) {
+		return false;
+	}
+	const int descriptor = ::open(path, readOnly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+	if (descriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	if (readOnly) {
+		size = ::fstat(descriptor, &status) == 0 ? static_cast<size_t>(status.st_size) : 0;
+	} else if (::ftruncate(descriptor, static_cast<off_t>(size)) != 0) {
+		size = 0;
+	}
+	void *mapping = MAP_FAILED;
+	if (size > 0) {
+		const int protection = readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+		mapping = ::mmap(nullptr, size, protection, MAP_SHARED, descriptor, 0);
+	}
+	// The mapping keeps the file referenced; the descriptor is no longer needed.
+	::close(descriptor);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	_data = static_cast<uint8_t *>(mapping);
+	_size = size;
+	return true;
+#else
+	(void)path;
+	(void)size;
+	(void)readOnly;
+	return false;
+#endif
+}
+
+void LogMappedFile::close() {
+#if ESPLOGGER_HAS_MMAP
+	if (_data != nullptr) {
+		::munmap(_data, _size);
+	}
+#endif
+	_data = nullptr;
+	_size = 0;
+}
+
+bool LogMappedFile::flush() {
+#if ESPLOGGER_HAS_MMAP
+	return _data != nullptr && ::msync(_data, _size, MS_SYNC) == 0;
+#else
+	return false;
+#endif
+}
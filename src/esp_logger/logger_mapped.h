@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// mmap() is only available on host/Linux builds; on target open() always fails.
+#ifndef ESPLOGGER_HAS_MMAP
+#if defined(__linux__) || defined(__APPLE__)
+#define ESPLOGGER_HAS_MMAP 1
+#else
+#define ESPLOGGER_HAS_MMAP 0
+#endif
+#endif
+
+// A file mapped shared into memory, sized on open. Used by the logger's mapped storage
+// mode (`LoggerConfig::mappedLogPath`) to hold a LogRetainedRing: records then persist
+// without any write calls, the kernel writes dirty pages back, and other processes can
+// map the same file read-only and tail it with LogRetainedRing::follow().
+class LogMappedFile {
+  public:
+	LogMappedFile() = default;
+	~LogMappedFile();
+
+	LogMappedFile(const LogMappedFile &) = delete;
+	LogMappedFile &operator=(const LogMappedFile &) = delete;
+
+	// Creates `path` if needed and grows or shrinks it to `size` bytes unless `readOnly`,
+	// in which case the existing file is mapped as it is. Returns false on any failure.
+	bool open(const char *path, size_t size, bool readOnly = false);
+	void close();
+	// msync(): blocks until dirty pages are on disk. Not needed for other readers, which
+	// share the page cache, only for surviving a host crash.
+	bool flush();
+
+	bool isOpen() const {
+		return _data != nullptr;
+	}
+	uint8_t *data() const {
+		return _data;
+	}
+	size_t size() const {
+		return _size;
+	}
+
+  private:
+	uint8_t *_data = nullptr;
+	size_t _size = 0;
+};
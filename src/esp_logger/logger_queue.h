@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+#include "esp_logger/logger_allocator.h"
+
+// Buffered records kept in one FIFO per level, each stamped with its arrival sequence.
+// Dropping the oldest record of a given level is a pop_front() on that level's FIFO, so
+// the lowest-level overflow policy never searches or erases from the middle of a buffer.
+// Arrival order is recovered by merging the FIFO heads, of which there are only `Levels`.
+// `T` needs a `level` member convertible to an index below `Levels`.
+template <typename T, size_t Levels> class LogLevelQueue {
+  public:
+	using Allocator = LoggerAllocator<T>;
+
+	LogLevelQueue() = default;
+	explicit LogLevelQueue(const Allocator &allocator) {
+		for (Fifo &fifo : _levels) {
+			fifo = Fifo(FifoAllocator(allocator));
+		}
+	}
+
+	size_t size() const {
+		return _size;
+	}
+	bool empty() const {
+		return _size == 0;
+	}
+	size_t count(size_t level) const {
+		return _levels[level].size();
+	}
+
+	void push_back(T record) {
+		Fifo &fifo = _levels[static_cast<size_t>(record.level)];
+		fifo.push_back(Entry{_nextSequence++, std::move(record)});
+		++_size;
+	}
+
+	// Oldest record overall. Only valid when not empty.
+	T &front() {
+		return _levels[oldestLevel()].front().record;
+	}
+	void pop_front() {
+		pop_front(oldestLevel());
+	}
+
+	// Oldest record of `level`. Only valid when count(level) > 0.
+	T &front(size_t level) {
+		return _levels[level].front().record;
+	}
+	void pop_front(size_t level) {
+		_levels[level].pop_front();
+		--_size;
+	}
+
+	// Visits every record in arrival order.
+	template <typename Fn> void forEach(Fn &&fn) {
+		visit(*this, fn);
+	}
+	template <typename Fn> void forEach(Fn &&fn) const {
+		visit(*this, fn);
+	}
+
+	void clear() {
+		for (Fifo &fifo : _levels) {
+			fifo.clear();
+		}
+		_size = 0;
+	}
+
+	void swap(LogLevelQueue &other) {
+		for (size_t level = 0; level < Levels; ++level) {
+			_levels[level].swap(other._levels[level]);
+		}
+		std::swap(_size, other._size);
+		std::swap(_nextSequence, other._nextSequence);
+	}
+
+  private:
+	struct Entry {
+		uint32_t sequence;
+		T record;
+	};
+	using FifoAllocator = LoggerAllocator<Entry>;
+	using Fifo = std::deque<Entry, FifoAllocator>;
+
+	// Wrap-safe: live sequences always span far less than half the 32-bit range.
+	static bool before(uint32_t a, uint32_t b) {
+		return static_cast<int32_t>(a - b) < 0;
+	}
+
+	size_t oldestLevel() const {
+		size_t oldest = Levels;
+		for (size_t level = 0; level < Levels; ++level) {
+			if (!_levels[level].empty() &&
+			    (oldest == Levels ||
+			     before(_levels[level].front().sequence, _levels[oldest].front().sequence))) {
+				oldest = level;
+			}
+		}
+		return oldest;
+	}
+
+	template <typename Self, typename Fn> static void visit(Self &self, Fn &fn) {
+		size_t next[Levels] = {};
+		for (size_t remaining = self._size; remaining > 0; --remaining) {
+			size_t oldest = Levels;
+			for (size_t level = 0; level < Levels; ++level) {
+				if (next[level] < self._levels[level].size() &&
+				    (oldest == Levels || before(self._levels[level][next[level]].sequence,
+				                                self._levels[oldest][next[oldest]].sequence))) {
+					oldest = level;
+				}
+			}
+			fn(self._levels[oldest][next[oldest]++].record);
+		}
+	}
+
+	Fifo _levels[Levels];
+	size_t _size = 0;
+	uint32_t _nextSequence = 0;
+};
@@ -0,0 +1,417 @@
+#include "esp_logger/logger_retained.h"
+
+#include "esp_logger/logger_store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x52504C45; // "ELPR"
+constexpr uint16_t kVersion = 1;
+constexpr size_t kIdentitySize = 16; // Header bytes covered by the CRC
+constexpr uint8_t kPrintedFlag = 0x40; // Unrendered record already written to the console
+constexpr uint8_t kPadFlags = 0xFF;    // Rest of the region is unused; continue at offset 0
+constexpr size_t kMaxTagLength = 255;
+constexpr size_t kMaxFieldLength = 0xFFFF;
+constexpr int kSnapshotAttempts = 64; // Then a writer that died mid-append is assumed
+constexpr int kCopyAttempts = 4;
+
+constexpr size_t align4(size_t value) {
+	return (value + 3) & ~static_cast<size_t>(3);
+}
+
+// Laid out field by field rather than as a packed struct so every member stays aligned.
+struct RecordHeader {
+	uint16_t length; // Whole record including this header, a multiple of 4
+	uint8_t flags;   // kPrintedFlag | kind << 2 | level, or kPadFlags
+	uint8_t tagLength;
+	uint32_t millis;
+	uint32_t timestamp;
+	uint16_t formatLength; // Without the NUL that follows non-empty format text
+	uint16_t payloadLength;
+};
+static_assert(sizeof(RecordHeader) == LogRetainedRing::kRecordHeaderSize, "record header size");
+
+// Orders filling bytes in before publishing them, for readers on other cores or in other
+// processes; the published fields are aligned 32-bit words, which a reset cannot tear.
+void publishFence() {
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void observeFence() {
+	std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+bool isPadding(const uint8_t *bytes, size_t available) {
+	return available < LogRetainedRing::kRecordHeaderSize || bytes[2] == kPadFlags;
+}
+
+// Decodes the record at `bytes`; false when its lengths do not fit in `available`.
+bool decodeRecord(
+    const uint8_t *bytes,
+    size_t available,
+    RetainedRecordView &view,
+    size_t &length
+) {
+	RecordHeader record;
+	std::memcpy(&record, bytes, sizeof(record));
+	const size_t format = record.formatLength > 0 ? record.formatLength + size_t{1} : 0;
+	const size_t contents =
+	    sizeof(record) + record.tagLength + format + record.payloadLength;
+	const uint8_t kind = (record.flags & ~kPrintedFlag) >> 2;
+	if (record.length % 4 != 0 || record.length < contents || record.length > available ||
+	    kind > static_cast<uint8_t>(RetainedKind::Printf)) {
+		return false;
+	}
+
+	const char *text = reinterpret_cast<const char *>(bytes + sizeof(record));
+	view.level = static_cast<LogLevel>(record.flags & 0x03);
+	view.kind = static_cast<RetainedKind>(kind);
+	view.printed = (record.flags & kPrintedFlag) != 0;
+	view.millis = record.millis;
+	view.timestamp = static_cast<std::time_t>(record.timestamp);
+	view.tag = std::string_view(text, record.tagLength);
+	view.format = std::string_view(text + record.tagLength, record.formatLength);
+	view.payload = std::string_view(text + record.tagLength + format, record.payloadLength);
+	length = record.length;
+	return true;
+}
+
+} // namespace
+
+struct LogRetainedRing::Header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t headerSize;
+	uint32_t capacity;
+	uint32_t generation;
+	uint32_t crc; // Over the fields above
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t laps;     // Times the head wrapped to offset 0
+	volatile uint32_t sequence; // Odd while append() is updating head, tail and laps
+	uint32_t reserved;
+};
+
+LogRetainedRing::LogRetainedRing(void *memory, size_t size) : _memory(nullptr), _capacity(0) {
+	if (memory == nullptr) {
+		return;
+	}
+	// RTC_NOINIT arrays are word aligned in practice, but nothing guarantees it for uint8_t.
+	const uintptr_t address = reinterpret_cast<uintptr_t>(memory);
+	const size_t skip = align4(address) - address;
+	if (size < skip + kHeaderSize) {
+		return;
+	}
+	_memory = static_cast<uint8_t *>(memory) + skip;
+	// Offsets are stored as uint32_t, so cap the ring well below that.
+	const size_t available = std::min<size_t>(size - skip - kHeaderSize, 0x7FFFFFFC);
+	_capacity = available & ~static_cast<size_t>(3);
+}
+
+LogRetainedRing::Header *LogRetainedRing::header() const {
+	static_assert(sizeof(Header) == kHeaderSize, "header size");
+	return reinterpret_cast<Header *>(_memory);
+}
+
+uint8_t *LogRetainedRing::data() const {
+	return _memory + kHeaderSize;
+}
+
+bool LogRetainedRing::recover(const Visitor &visitor) {
+	_count = 0;
+	if (!valid()) {
+		return false;
+	}
+	const Header *state = header();
+	if (state->magic != kMagic || state->version != kVersion || state->headerSize != kHeaderSize ||
+	    state->capacity != _capacity ||
+	    state->crc != logger_store_detail::crc32(state, kIdentitySize)) {
+		return false;
+	}
+	const size_t head = state->head;
+	size_t offset = state->tail;
+	if (head >= _capacity || offset >= _capacity || head % 4 != 0 || offset % 4 != 0) {
+		return false;
+	}
+
+	// Walks at most one lap; a record whose lengths do not add up ends the walk, keeping the
+	// survivors before it.
+	size_t walked = 0;
+	while (offset != head && walked < _capacity) {
+		const uint8_t *bytes = data() + offset;
+		if (isPadding(bytes, _capacity - offset)) {
+			if (bytes[2] != kPadFlags) {
+				break;
+			}
+			walked += _capacity - offset;
+			offset = 0;
+			continue;
+		}
+		RetainedRecordView view;
+		size_t length = 0;
+		if (!decodeRecord(bytes, _capacity - offset, view, length)) {
+			break;
+		}
+		if (visitor) {
+			visitor(view);
+		}
+		++_count;
+		walked += length;
+		offset += length;
+		if (offset == _capacity) {
+			offset = 0;
+		}
+	}
+	return true;
+}
+
+uint32_t LogRetainedRing::storedGeneration() const {
+	return valid() ? header()->generation : 0;
+}
+
+void LogRetainedRing::reset(uint32_t generation) {
+	_count = 0;
+	if (!valid()) {
+		return;
+	}
+	Header *state = header();
+	// Invalidate first so a reset in the middle of formatting is not mistaken for a ring.
+	state->magic = 0;
+	publishFence();
+	state->version = kVersion;
+	state->headerSize = kHeaderSize;
+	state->capacity = static_cast<uint32_t>(_capacity);
+	state->generation = generation;
+	state->head = 0;
+	state->tail = 0;
+	state->laps = 0;
+	state->sequence = 0;
+	state->reserved = 0;
+	uint8_t identity[kIdentitySize];
+	std::memcpy(identity, state, sizeof(identity));
+	const uint32_t magic = kMagic;
+	std::memcpy(identity, &magic, sizeof(magic));
+	state->crc = logger_store_detail::crc32(identity, sizeof(identity));
+	publishFence();
+	state->magic = kMagic;
+}
+
+void LogRetainedRing::clear() {
+	_count = 0;
+	if (!valid()) {
+		return;
+	}
+	// A single store, so the ring is either untouched or empty.
+	header()->tail = header()->head;
+}
+
+LogRetainedRing::Snapshot LogRetainedRing::snapshot() const {
+	const Header *state = header();
+	uint32_t head = 0;
+	uint32_t tail = 0;
+	uint32_t laps = 0;
+	for (int attempt = 0; attempt < kSnapshotAttempts; ++attempt) {
+		const uint32_t before = state->sequence;
+		observeFence();
+		head = state->head;
+		tail = state->tail;
+		laps = state->laps;
+		observeFence();
+		if (before % 2 == 0 && state->sequence == before) {
+			break;
+		}
+	}
+
+	Snapshot snapshot;
+	const size_t used = (head + _capacity - tail) % _capacity;
+	snapshot.headCursor = static_cast<uint64_t>(laps) * _capacity + head;
+	snapshot.tailCursor = snapshot.headCursor - used;
+	return snapshot;
+}
+
+uint64_t LogRetainedRing::headCursor() const {
+	return valid() ? snapshot().headCursor : 0;
+}
+
+uint64_t LogRetainedRing::tailCursor() const {
+	return valid() ? snapshot().tailCursor : 0;
+}
+
+bool LogRetainedRing::copySince(uint64_t &cursor, std::string &out) const {
+	if (!valid()) {
+		return true;
+	}
+	const size_t start = out.size();
+	bool complete = true;
+	for (int attempt = 0; attempt < kCopyAttempts; ++attempt) {
+		const Snapshot before = snapshot();
+		// A cursor past the head belongs to a ring that has since been reset.
+		if (cursor < before.tailCursor || cursor > before.headCursor) {
+			cursor = before.tailCursor;
+			complete = false;
+		}
+
+		uint64_t position = cursor;
+		while (position < before.headCursor) {
+			const size_t offset = static_cast<size_t>(position % _capacity);
+			const uint8_t *bytes = data() + offset;
+			if (isPadding(bytes, _capacity - offset)) {
+				position += _capacity - offset;
+				continue;
+			}
+			RetainedRecordView view;
+			size_t length = 0;
+			if (!decodeRecord(bytes, _capacity - offset, view, length)) {
+				break;
+			}
+			out.append(reinterpret_cast<const char *>(bytes), length);
+			position += length;
+		}
+
+		// The writer moves the tail before reusing bytes, so a tail that did not pass
+		// `cursor` means nothing copied was overwritten meanwhile.
+		observeFence();
+		const Snapshot after = snapshot();
+		if (after.tailCursor <= cursor) {
+			cursor = before.headCursor;
+			return complete;
+		}
+		out.resize(start);
+		cursor = after.tailCursor;
+		complete = false;
+	}
+	return false;
+}
+
+void LogRetainedRing::forEachRecord(std::string_view records, const Visitor &visitor) {
+	const auto *bytes = reinterpret_cast<const uint8_t *>(records.data());
+	size_t offset = 0;
+	while (records.size() - offset >= kRecordHeaderSize) {
+		RetainedRecordView view;
+		size_t length = 0;
+		if (!decodeRecord(bytes + offset, records.size() - offset, view, length)) {
+			return;
+		}
+		if (visitor) {
+			visitor(view);
+		}
+		offset += length;
+	}
+}
+
+bool LogRetainedRing::follow(uint64_t &cursor, const Visitor &visitor) const {
+	std::string records;
+	const bool complete = copySince(cursor, records);
+	forEachRecord(records, visitor);
+	return complete;
+}
+
+void LogRetainedRing::evictOldest() {
+	Header *state = header();
+	const uint8_t *bytes = data() + state->tail;
+	size_t next = state->tail;
+	if (isPadding(bytes, _capacity - next)) {
+		next = 0;
+	} else {
+		RecordHeader record;
+		std::memcpy(&record, bytes, sizeof(record));
+		next += record.length;
+		if (next == _capacity) {
+			next = 0;
+		}
+		_count -= _count > 0 ? 1 : 0;
+	}
+	state->tail = static_cast<uint32_t>(next);
+}
+
+void LogRetainedRing::append(
+    LogLevel level,
+    RetainedKind kind,
+    uint32_t millis,
+    std::time_t timestamp,
+    std::string_view tag,
+    std::string_view format,
+    std::string_view payload,
+    bool printed
+) {
+	if (!valid()) {
+		return;
+	}
+	const size_t maxRecord = std::min<size_t>(_capacity / 4, 0xFFFC);
+	tag = tag.substr(0, kMaxTagLength);
+	size_t contents = kRecordHeaderSize + tag.size() + (format.empty() ? 0 : format.size() + 1);
+	if (format.size() > kMaxFieldLength || contents > maxRecord) {
+		return;
+	}
+	if (contents + payload.size() > maxRecord) {
+		if (kind != RetainedKind::Text) {
+			return;
+		}
+		payload = payload.substr(0, maxRecord - contents);
+	}
+	contents += payload.size();
+	const size_t length = align4(contents);
+
+	Header *state = header();
+	// Starting from an odd value also repairs a sequence left odd by a writer that died.
+	const uint32_t sequence = state->sequence | 1;
+	state->sequence = sequence;
+	publishFence();
+
+	size_t head = state->head;
+	// Records never wrap: when the space before the end is too short, it becomes padding.
+	const size_t padding = _capacity - head < length ? _capacity - head : 0;
+	// One word stays free so that head == tail always means empty.
+	const auto freeBytes = [this, state, head]() {
+		return (state->tail + _capacity - head - 1) % _capacity + 1;
+	};
+	// A record is at most a quarter of the ring, so an empty ring always has room.
+	while (state->tail != head && freeBytes() <= padding + length) {
+		evictOldest();
+	}
+	publishFence();
+
+	if (padding > 0) {
+		data()[head + 2] = kPadFlags;
+		head = 0;
+	}
+
+	RecordHeader record;
+	record.length = static_cast<uint16_t>(length);
+	record.flags = static_cast<uint8_t>((printed ? kPrintedFlag : 0) |
+	                                    static_cast<uint8_t>(kind) << 2 |
+	                                    (static_cast<uint8_t>(level) & 0x03));
+	record.tagLength = static_cast<uint8_t>(tag.size());
+	record.millis = millis;
+	record.timestamp = static_cast<uint32_t>(timestamp);
+	record.formatLength = static_cast<uint16_t>(format.size());
+	record.payloadLength = static_cast<uint16_t>(payload.size());
+	uint8_t *out = data() + head;
+	std::memcpy(out, &record, sizeof(record));
+	out += sizeof(record);
+	if (!tag.empty()) {
+		std::memcpy(out, tag.data(), tag.size());
+		out += tag.size();
+	}
+	if (!format.empty()) {
+		std::memcpy(out, format.data(), format.size());
+		out += format.size();
+		*out++ = '\0';
+	}
+	if (!payload.empty()) {
+		std::memcpy(out, payload.data(), payload.size());
+	}
+	publishFence();
+
+	head += length;
+	if (padding > 0 || head == _capacity) {
+		state->laps = state->laps + 1;
+	}
+	state->head = static_cast<uint32_t>(head == _capacity ? 0 : head);
+	++_count;
+	publishFence();
+	state->sequence = sequence + 1;
+}
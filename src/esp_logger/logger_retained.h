@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "esp_logger/logger_config.h"
+
+// How a retained record's payload has to be rendered after the reboot.
+enum class RetainedKind : uint8_t {
+	Text,    // Payload is the message
+	Fields,  // Payload is encoded `kv()` fields
+	MsgPack, // Payload is deferred JSON as MessagePack
+	Printf,  // `format` holds the format text, payload the packed deferred arguments
+};
+
+struct RetainedRecordView {
+	LogLevel level = LogLevel::Debug;
+	RetainedKind kind = RetainedKind::Text;
+	uint32_t millis = 0;
+	std::time_t timestamp = 0;
+	std::string_view tag;
+	std::string_view format; // NUL-terminated in memory, so format.data() is a C string
+	std::string_view payload;
+	bool printed = false; // Written to the console when it was logged
+};
+
+// Byte ring laid over caller-owned memory: an `RTC_NOINIT_ATTR` (or `.noinit`) array that
+// survives a reset on target, an mmap'd file on host (see LogMappedFile). The ring never
+// allocates or frees it.
+//
+// The region starts with a 40-byte header: magic, version, capacity, generation and a
+// CRC-32 over those, followed by the head and tail offsets of the live data, the number
+// of times the head wrapped, and a sequence number that is odd while an append is under
+// way. Records are 4-byte aligned and never wrap; the space left at the end of the
+// region is covered by a padding record instead. A record is a 16-byte header (length,
+// level/kind, tag length, millis, timestamp, format and payload lengths) followed by the
+// tag, the format text and its NUL (when there is one), and the payload bytes.
+//
+// append() evicts from the tail, memcpys the record into place and only then publishes
+// the new head, so a reset in the middle of a write loses at most that record.
+// Nothing on the write path computes a checksum; recover() instead validates the header
+// CRC and walks the records, stopping at the first one whose lengths do not add up.
+//
+// Readers that follow the ring while it is written (the logger's sync path, or another
+// process sharing the mapping) address records by cursor: bytes published since the ring
+// was formatted, i.e. wraps × capacity + head.
+class LogRetainedRing {
+  public:
+	static constexpr size_t kHeaderSize = 40;
+	static constexpr size_t kRecordHeaderSize = 16;
+
+	using Visitor = std::function<void(const RetainedRecordView &)>;
+
+	LogRetainedRing(void *memory, size_t size);
+
+	// False when the region is too small to hold a header and a few records.
+	bool valid() const {
+		return _capacity >= 4 * kRecordHeaderSize;
+	}
+
+	// Validates the region and visits the surviving records, oldest first. Returns false,
+	// visiting nothing, when the region does not hold an intact ring (e.g. after power loss).
+	bool recover(const Visitor &visitor);
+	// Generation stored in the header; only meaningful after a successful recover().
+	uint32_t storedGeneration() const;
+	// Formats the region as an empty ring for `generation`.
+	void reset(uint32_t generation);
+	// Drops the records but keeps the current generation.
+	void clear();
+
+	// Copies one record in; records larger than a quarter of the ring are truncated (text)
+	// or skipped (other kinds, whose payload cannot be cut).
+	void append(
+	    LogLevel level,
+	    RetainedKind kind,
+	    uint32_t millis,
+	    std::time_t timestamp,
+	    std::string_view tag,
+	    std::string_view format,
+	    std::string_view payload,
+	    bool printed = false
+	);
+
+	// Records in the ring as seen by this instance, which counts them in recover() and
+	// append(); another process writing the region is not reflected.
+	size_t count() const {
+		return _count;
+	}
+	size_t capacityBytes() const {
+		return _capacity;
+	}
+	// Cursors just past the newest record and at the oldest one still in the ring.
+	uint64_t headCursor() const;
+	uint64_t tailCursor() const;
+
+	// Appends the records published after `cursor` to `out` as raw record bytes (padding
+	// dropped) and moves `cursor` to the head. Returns false when some of them were
+	// overwritten first; the copy then starts at the oldest record that survived. Safe
+	// against a writer in another process.
+	bool copySince(uint64_t &cursor, std::string &out) const;
+	// Visits the records in a buffer filled by copySince().
+	static void forEachRecord(std::string_view records, const Visitor &visitor);
+	// copySince() into a scratch buffer, then forEachRecord(): one poll of a tailing reader.
+	bool follow(uint64_t &cursor, const Visitor &visitor) const;
+
+  private:
+	struct Header;
+	struct Snapshot {
+		uint64_t headCursor = 0;
+		uint64_t tailCursor = 0;
+	};
+
+	Header *header() const;
+	uint8_t *data() const;
+	Snapshot snapshot() const;
+	void evictOldest();
+
+	uint8_t *_memory;
+	size_t _capacity; // Data bytes after the header, a multiple of 4
+	size_t _count = 0;
+};
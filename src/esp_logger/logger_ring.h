@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "esp_logger/logger_allocator.h"
+
+// Bounded lock-free queue (Vyukov-style sequence ring). Any number of producers may
+// push concurrently; pops are also safe from several threads, which lets producers
+// evict the oldest entry themselves when the ring is full instead of waiting for the
+// consumer. Capacity is rounded up to a power of two.
+template <typename T> class LogRing {
+  public:
+	LogRing(size_t minCapacity, bool usePSRAMBuffers)
+	    : _allocator(usePSRAMBuffers), _capacity(roundUpCapacity(minCapacity)),
+	      _mask(_capacity - 1) {
+		_cells = _allocator.allocate(_capacity);
+		for (size_t index = 0; index < _capacity; ++index) {
+			new (&_cells[index]) Cell();
+			_cells[index].sequence.store(index, std::memory_order_relaxed);
+		}
+	}
+
+	~LogRing() {
+		T discarded;
+		while (tryPop(discarded)) {
+		}
+		for (size_t index = 0; index < _capacity; ++index) {
+			_cells[index].~Cell();
+		}
+		_allocator.deallocate(_cells, _capacity);
+	}
+
+	LogRing(const LogRing &) = delete;
+	LogRing &operator=(const LogRing &) = delete;
+
+	// Moves `value` into the ring. Returns false (leaving `value` untouched) when full.
+	bool tryPush(T &value) {
+		Cell *cell = nullptr;
+		size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &_cells[position & _mask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (diff == 0) {
+				if (_enqueuePosition.compare_exchange_weak(
+				        position,
+				        position + 1,
+				        std::memory_order_relaxed
+				    )) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				position = _enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		new (&cell->bytes) T(std::move(value));
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Moves the oldest committed entry into `out`. Returns false when empty.
+	bool tryPop(T &out) {
+		Cell *cell = nullptr;
+		size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &_cells[position & _mask];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff =
+			    static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+			if (diff == 0) {
+				if (_dequeuePosition.compare_exchange_weak(
+				        position,
+				        position + 1,
+				        std::memory_order_relaxed
+				    )) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				position = _dequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		T *stored = cell->storage();
+		out = std::move(*stored);
+		stored->~T();
+		cell->sequence.store(position + _capacity, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const {
+		return _capacity;
+	}
+
+	// Racy by nature; good enough for diagnostics and fill heuristics.
+	size_t sizeApprox() const {
+		const size_t enqueued = _enqueuePosition.load(std::memory_order_relaxed);
+		const size_t dequeued = _dequeuePosition.load(std::memory_order_relaxed);
+		return enqueued >= dequeued ? enqueued - dequeued : 0;
+	}
+
+  private:
+	struct Cell {
+		std::atomic<size_t> sequence{0};
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes;
+
+		T *storage() {
+			return std::launder(reinterpret_cast<T *>(&bytes));
+		}
+	};
+
+	static size_t roundUpCapacity(size_t minCapacity) {
+		size_t capacity = 2;
+		while (capacity < minCapacity) {
+			capacity <<= 1;
+		}
+		return capacity;
+	}
+
+	LoggerAllocator<Cell> _allocator;
+	size_t _capacity;
+	size_t _mask;
+	Cell *_cells = nullptr;
+	std::atomic<size_t> _enqueuePosition{0};
+	std::atomic<size_t> _dequeuePosition{0};
+};
@@ -0,0 +1,83 @@
+#include "esp_logger/logger_spill.h"
+
+#include "esp_logger/logger_lock.h"
+
+#include <string>
+
+LogMemorySpill::LogMemorySpill(size_t capacityBytes, bool usePSRAMBuffers)
+    : _arena(capacityBytes, usePSRAMBuffers), _mutex(xSemaphoreCreateMutex()) {
+}
+
+LogMemorySpill::~LogMemorySpill() {
+	if (_mutex != nullptr) {
+		vSemaphoreDelete(_mutex);
+	}
+}
+
+LogSpillStore LogMemorySpill::store() {
+	LogSpillStore spill;
+	spill.write = [this](LogBatchView batch) { return write(batch); };
+	spill.read = [this](size_t maxCount, std::vector<Log> &out) { return read(maxCount, out); };
+	return spill;
+}
+
+size_t LogMemorySpill::write(LogBatchView batch) {
+	if (!valid()) {
+		return 0;
+	}
+
+	LockGuard guard(_mutex);
+	size_t kept = 0;
+	for (const Log &entry : batch) {
+		// Structured entries keep only their fields; the text is rendered again on read.
+		const bool hasFields = !entry.fields.empty();
+		const std::string &payload = hasFields ? entry.fields : entry.message;
+		ArenaRecordView view;
+		view.level = entry.level;
+		view.millis = entry.millis;
+		view.timestamp = entry.timestamp;
+		view.format = hasFields ? logger_fields_detail::kFieldsFormat : nullptr;
+		view.tag = entry.tag.data();
+		view.tagLength = entry.tag.size();
+		view.payload = payload.data();
+		view.payloadLength = payload.size();
+		if (!_arena.fits(view)) {
+			break;
+		}
+		_arena.append(view);
+		++kept;
+	}
+	return kept;
+}
+
+size_t LogMemorySpill::read(size_t maxCount, std::vector<Log> &out) {
+	if (!valid()) {
+		return 0;
+	}
+
+	LockGuard guard(_mutex);
+	size_t read = 0;
+	ArenaRecordView view;
+	while (read < maxCount && _arena.front(view)) {
+		Log entry{view.level, {}, view.millis, view.timestamp, {}, {}, false};
+		entry.tag.assign(view.tag, view.tagLength);
+		if (view.format == logger_fields_detail::kFieldsFormat) {
+			entry.fields.assign(view.payload, view.payloadLength);
+			entry.message = logFieldsToText(entry.fields);
+		} else {
+			entry.message.assign(view.payload, view.payloadLength);
+		}
+		out.push_back(std::move(entry));
+		_arena.popFront();
+		++read;
+	}
+	return read;
+}
+
+size_t LogMemorySpill::count() const {
+	if (_mutex == nullptr) {
+		return 0;
+	}
+	LockGuard guard(_mutex);
+	return _arena.count();
+}
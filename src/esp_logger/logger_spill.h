@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "esp_logger/logger.h"
+
+// Spill store for boards without a filesystem: overflowed entries are kept rendered in a
+// byte-budgeted LogArena, in PSRAM when available, until the sync path reads them back.
+// When the arena is full the store keeps the part of a batch that fits and the logger
+// drops the rest, so the entries that do come back stay in order.
+class LogMemorySpill {
+  public:
+	explicit LogMemorySpill(size_t capacityBytes, bool usePSRAMBuffers = true);
+	~LogMemorySpill();
+
+	LogMemorySpill(const LogMemorySpill &) = delete;
+	LogMemorySpill &operator=(const LogMemorySpill &) = delete;
+
+	bool valid() const {
+		return _mutex != nullptr && _arena.valid();
+	}
+
+	// The store to pass to ESPLogger::setSpillStore; it must outlive the logger's use of it.
+	LogSpillStore store();
+
+	size_t write(LogBatchView batch);
+	size_t read(size_t maxCount, std::vector<Log> &out);
+	size_t count() const;
+
+  private:
+	LogArena _arena;
+	SemaphoreHandle_t _mutex = nullptr;
+};
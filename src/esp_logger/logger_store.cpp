@@ -0,0 +1,554 @@
+#include "esp_logger/logger_store.h"
+
+#include "esp_logger/logger_lock.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kRecordPrefix = 8; // Payload size + CRC
+constexpr size_t kMinRecordPayload = 8 + 8 + 1 + 4 + 1 + 1 + 1;
+constexpr size_t kMaxRecordPayload = 1024 * 1024; // Anything larger is corruption
+constexpr size_t kIndexEntrySize = 8 + 8 + 4 + 4;
+constexpr size_t kMaxTagLength = 255;
+
+template <typename T> void appendLE(std::string &out, T value) {
+	for (size_t index = 0; index < sizeof(T); ++index) {
+		out.push_back(static_cast<char>(static_cast<uint64_t>(value) >> (8 * index)));
+	}
+}
+
+template <typename T> T readLE(const char *data) {
+	uint64_t value = 0;
+	for (size_t index = 0; index < sizeof(T); ++index) {
+		value |= static_cast<uint64_t>(static_cast<uint8_t>(data[index])) << (8 * index);
+	}
+	return static_cast<T>(value);
+}
+
+void appendVarint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const char *&cursor, const char *end, uint64_t &value) {
+	value = 0;
+	for (unsigned shift = 0; cursor < end && shift < 64; shift += 7) {
+		const uint8_t byte = static_cast<uint8_t>(*cursor++);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool readBytes(const char *&cursor, const char *end, std::string &out) {
+	uint64_t length = 0;
+	if (!readVarint(cursor, end, length) || length > static_cast<uint64_t>(end - cursor)) {
+		return false;
+	}
+	out.assign(cursor, static_cast<size_t>(length));
+	cursor += length;
+	return true;
+}
+
+void appendRecord(std::string &out, uint64_t seq, const Log &entry) {
+	const size_t start = out.size();
+	out.append(kRecordPrefix, '\0');
+	appendLE<uint64_t>(out, seq);
+	appendLE<int64_t>(out, static_cast<int64_t>(entry.timestamp));
+	out.push_back(static_cast<char>(entry.level));
+	appendLE<uint32_t>(out, entry.millis);
+	const size_t tagLength = std::min(entry.tag.size(), kMaxTagLength);
+	out.push_back(static_cast<char>(tagLength));
+	out.append(entry.tag.data(), tagLength);
+	appendVarint(out, entry.message.size());
+	out += entry.message;
+	appendVarint(out, entry.fields.size());
+	out += entry.fields;
+
+	const size_t payloadSize = out.size() - start - kRecordPrefix;
+	const char *payload = out.data() + start + kRecordPrefix;
+	const uint32_t crc = logger_store_detail::crc32(payload, payloadSize);
+	std::string prefix;
+	appendLE<uint32_t>(prefix, static_cast<uint32_t>(payloadSize));
+	appendLE<uint32_t>(prefix, crc);
+	out.replace(start, kRecordPrefix, prefix);
+}
+
+void appendIndexEntry(std::string &out, uint64_t seq, int64_t timestamp, uint32_t offset) {
+	const size_t start = out.size();
+	appendLE<uint64_t>(out, seq);
+	appendLE<int64_t>(out, timestamp);
+	appendLE<uint32_t>(out, offset);
+	appendLE<uint32_t>(out, logger_store_detail::crc32(out.data() + start, out.size() - start));
+}
+
+// Reads the record at the current file position. Returns false at the end of the segment,
+// which includes a torn or corrupted record.
+bool readRecord(std::FILE *file, std::string &buffer, StoredLog &record) {
+	char prefix[kRecordPrefix];
+	if (std::fread(prefix, 1, sizeof(prefix), file) != sizeof(prefix)) {
+		return false;
+	}
+	const uint32_t payloadSize = readLE<uint32_t>(prefix);
+	if (payloadSize < kMinRecordPayload || payloadSize > kMaxRecordPayload) {
+		return false;
+	}
+	buffer.resize(payloadSize);
+	if (std::fread(&buffer[0], 1, payloadSize, file) != payloadSize ||
+	    logger_store_detail::crc32(buffer.data(), payloadSize) != readLE<uint32_t>(prefix + 4)) {
+		return false;
+	}
+
+	const char *cursor = buffer.data();
+	const char *end = cursor + payloadSize;
+	record.seq = readLE<uint64_t>(cursor);
+	record.log.timestamp = static_cast<std::time_t>(readLE<int64_t>(cursor + 8));
+	record.log.level = static_cast<LogLevel>(static_cast<uint8_t>(cursor[16]) & 0x03);
+	record.log.millis = readLE<uint32_t>(cursor + 17);
+	const size_t tagLength = static_cast<uint8_t>(cursor[21]);
+	cursor += 22;
+	if (static_cast<size_t>(end - cursor) < tagLength) {
+		return false;
+	}
+	record.log.tag.assign(cursor, tagLength);
+	cursor += tagLength;
+	return readBytes(cursor, end, record.log.message) && readBytes(cursor, end, record.log.fields);
+}
+
+} // namespace
+
+namespace logger_store_detail {
+
+uint32_t crc32(const void *data, size_t size, uint32_t crc) {
+	// Nibble-wise table: 64 bytes of flash instead of the usual 1 KB.
+	static const uint32_t kTable[16] = {
+	    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+	    0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+	};
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	crc = ~crc;
+	for (size_t index = 0; index < size; ++index) {
+		crc = kTable[(crc ^ bytes[index]) & 0x0F] ^ (crc >> 4);
+		crc = kTable[(crc ^ (bytes[index] >> 4)) & 0x0F] ^ (crc >> 4);
+	}
+	return ~crc;
+}
+
+} // namespace logger_store_detail
+
+LogFileStore::~LogFileStore() {
+	close();
+}
+
+bool LogFileStore::open(const LogStoreConfig &config) {
+	close();
+	if (config.directory.empty() || config.prefix.empty() || config.maxSegmentBytes == 0 ||
+	    config.maxSegments == 0) {
+		return false;
+	}
+
+	_mutex = xSemaphoreCreateMutex();
+	if (_mutex == nullptr) {
+		return false;
+	}
+	_config = config;
+	_config.indexInterval = std::max<size_t>(_config.indexInterval, 1);
+	// Fails harmlessly when the directory exists or the filesystem (SPIFFS) has none.
+	::mkdir(_config.directory.c_str(), 0755);
+
+	if (!discoverSegments()) {
+		close();
+		return false;
+	}
+	recoverNextSeq();
+	// The first append starts a new segment, so open/close cycles without appends leave no
+	// empty segments behind to count against maxSegments.
+	_rotatePending = true;
+	return true;
+}
+
+void LogFileStore::close() {
+	if (_file != nullptr) {
+		std::fclose(_file);
+		_file = nullptr;
+	}
+	if (_indexFile != nullptr) {
+		std::fclose(_indexFile);
+		_indexFile = nullptr;
+	}
+	if (_mutex != nullptr) {
+		vSemaphoreDelete(_mutex);
+		_mutex = nullptr;
+	}
+	_segments.clear();
+	_segmentBytes = 0;
+	_segmentRecords = 0;
+	_nextSeq = 0;
+	_rotatePending = false;
+	_staging.clear();
+	_indexStaging.clear();
+}
+
+std::string LogFileStore::segmentPath(uint32_t id, const char *extension) const {
+	char name[16];
+	std::snprintf(name, sizeof(name), "-%08u.", static_cast<unsigned>(id));
+	return _config.directory + "/" + _config.prefix + name + extension;
+}
+
+bool LogFileStore::discoverSegments() {
+	DIR *directory = ::opendir(_config.directory.c_str());
+	if (directory == nullptr) {
+		return false;
+	}
+	const std::string lead = _config.prefix + "-";
+	while (const dirent *item = ::readdir(directory)) {
+		const std::string name = item->d_name;
+		if (name.size() != lead.size() + 12 || name.compare(0, lead.size(), lead) != 0 ||
+		    name.compare(name.size() - 4, 4, ".log") != 0) {
+			continue;
+		}
+		const std::string digits = name.substr(lead.size(), 8);
+		if (digits.find_first_not_of("0123456789") != std::string::npos) {
+			continue;
+		}
+		Segment segment;
+		segment.id = static_cast<uint32_t>(std::strtoul(digits.c_str(), nullptr, 10));
+		_segments.push_back(segment);
+	}
+	::closedir(directory);
+	std::sort(_segments.begin(), _segments.end(), [](const Segment &a, const Segment &b) {
+		return a.id < b.id;
+	});
+
+	// Only the first record of each segment is read here; that is all a seek needs.
+	std::string buffer;
+	for (Segment &segment : _segments) {
+		std::FILE *file = std::fopen(segmentPath(segment.id, "log").c_str(), "rb");
+		if (file == nullptr) {
+			continue;
+		}
+		StoredLog record;
+		if (readRecord(file, buffer, record)) {
+			segment.firstSeq = record.seq;
+			segment.firstTimestamp = static_cast<int64_t>(record.log.timestamp);
+			segment.empty = false;
+		}
+		std::fclose(file);
+	}
+	// Segments without a readable first record hold nothing; drop them so they do not take
+	// a retention slot from segments with data.
+	for (auto it = _segments.begin(); it != _segments.end();) {
+		if (!it->empty) {
+			++it;
+			continue;
+		}
+		std::remove(segmentPath(it->id, "log").c_str());
+		std::remove(segmentPath(it->id, "idx").c_str());
+		it = _segments.erase(it);
+	}
+	return true;
+}
+
+bool LogFileStore::readIndex(uint32_t id, std::vector<IndexEntry> &entries) const {
+	entries.clear();
+	std::FILE *file = std::fopen(segmentPath(id, "idx").c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	char raw[kIndexEntrySize];
+	while (std::fread(raw, 1, sizeof(raw), file) == sizeof(raw)) {
+		if (logger_store_detail::crc32(raw, kIndexEntrySize - 4) !=
+		    readLE<uint32_t>(raw + kIndexEntrySize - 4)) {
+			break;
+		}
+		IndexEntry entry;
+		entry.seq = readLE<uint64_t>(raw);
+		entry.timestamp = readLE<int64_t>(raw + 8);
+		entry.offset = readLE<uint32_t>(raw + 16);
+		entries.push_back(entry);
+	}
+	std::fclose(file);
+	return true;
+}
+
+void LogFileStore::recoverNextSeq() {
+	_nextSeq = 0;
+	for (auto it = _segments.rbegin(); it != _segments.rend(); ++it) {
+		if (it->empty) {
+			continue;
+		}
+		// Jump to the last indexed record, then walk the few records after it.
+		std::vector<IndexEntry> entries;
+		readIndex(it->id, entries);
+		std::FILE *file = std::fopen(segmentPath(it->id, "log").c_str(), "rb");
+		if (file == nullptr) {
+			continue;
+		}
+		if (!entries.empty() && std::fseek(file, entries.back().offset, SEEK_SET) != 0) {
+			std::fseek(file, 0, SEEK_SET);
+		}
+		std::string buffer;
+		StoredLog record;
+		uint64_t last = it->firstSeq;
+		while (readRecord(file, buffer, record)) {
+			last = record.seq;
+		}
+		std::fclose(file);
+		_nextSeq = last + 1;
+		return;
+	}
+}
+
+bool LogFileStore::startSegment() {
+	if (_file != nullptr) {
+		std::fclose(_file);
+		_file = nullptr;
+	}
+	if (_indexFile != nullptr) {
+		std::fclose(_indexFile);
+		_indexFile = nullptr;
+	}
+
+	Segment segment;
+	segment.id = _segments.empty() ? 0 : _segments.back().id + 1;
+	_file = std::fopen(segmentPath(segment.id, "log").c_str(), "wb");
+	_indexFile = std::fopen(segmentPath(segment.id, "idx").c_str(), "wb");
+	if (_file == nullptr || _indexFile == nullptr) {
+		if (_file != nullptr) {
+			std::fclose(_file);
+			_file = nullptr;
+		}
+		if (_indexFile != nullptr) {
+			std::fclose(_indexFile);
+			_indexFile = nullptr;
+		}
+		return false;
+	}
+	_segments.push_back(segment);
+	_segmentBytes = 0;
+	_segmentRecords = 0;
+	_rotatePending = false;
+	dropOldSegments();
+	return true;
+}
+
+void LogFileStore::dropOldSegments() {
+	while (_segments.size() > _config.maxSegments) {
+		std::remove(segmentPath(_segments.front().id, "log").c_str());
+		std::remove(segmentPath(_segments.front().id, "idx").c_str());
+		_segments.erase(_segments.begin());
+	}
+}
+
+bool LogFileStore::commit(bool fsync) {
+	bool written = true;
+	if (!_staging.empty()) {
+		written = std::fwrite(_staging.data(), 1, _staging.size(), _file) == _staging.size() &&
+		          std::fflush(_file) == 0;
+		// The index only accelerates seeks, so it follows the data it points at.
+		if (written && !_indexStaging.empty()) {
+			std::fwrite(_indexStaging.data(), 1, _indexStaging.size(), _indexFile);
+			std::fflush(_indexFile);
+		}
+		if (written && fsync) {
+			written = ::fsync(fileno(_file)) == 0;
+			::fsync(fileno(_indexFile));
+		}
+	}
+	_staging.clear();
+	_indexStaging.clear();
+	if (!written) {
+		_rotatePending = true;
+	}
+	return written;
+}
+
+bool LogFileStore::append(LogBatchView batch) {
+	return append(batch, _config.fsyncOnCommit);
+}
+
+bool LogFileStore::append(LogBatchView batch, bool fsync) {
+	LockGuard guard(_mutex);
+	if (_mutex == nullptr) {
+		return false;
+	}
+	if (_rotatePending && !startSegment()) {
+		return false;
+	}
+
+	bool written = true;
+	for (const Log &entry : batch) {
+		const bool full =
+		    _segmentBytes >= _config.maxSegmentBytes ||
+		    (_config.maxSegmentRecords != 0 && _segmentRecords >= _config.maxSegmentRecords);
+		if (full && _segmentRecords > 0) {
+			written = commit(fsync) && written;
+			if (!startSegment()) {
+				return false;
+			}
+		}
+
+		Segment &segment = _segments.back();
+		const int64_t timestamp = static_cast<int64_t>(entry.timestamp);
+		if (segment.empty) {
+			segment.firstSeq = _nextSeq;
+			segment.firstTimestamp = timestamp;
+			segment.empty = false;
+		}
+		if (_segmentRecords % _config.indexInterval == 0) {
+			const uint32_t offset = static_cast<uint32_t>(_segmentBytes);
+			appendIndexEntry(_indexStaging, _nextSeq, timestamp, offset);
+		}
+		const size_t before = _staging.size();
+		appendRecord(_staging, _nextSeq, entry);
+		_segmentBytes += _staging.size() - before;
+		++_segmentRecords;
+		++_nextSeq;
+	}
+	return commit(fsync) && written;
+}
+
+SyncViewCallback LogFileStore::syncCallback() {
+	return [this](LogBatchView batch) { append(batch); };
+}
+
+LogSpillStore LogFileStore::spillStore() {
+	// Only the sync path reads, so the shared cursor needs no lock of its own.
+	auto cursor = std::make_shared<uint64_t>(nextSeq());
+	LogSpillStore spill;
+	// Spill writes run on the logging thread under the logger mutex, so they stop at fflush()
+	// and never wait for fsync(); a crash may lose entries that were still only spilled.
+	spill.write = [this](LogBatchView batch) { return append(batch, false) ? batch.size() : 0; };
+	spill.read = [this, cursor](size_t maxCount, std::vector<Log> &out) {
+		size_t read = 0;
+		readFromSeq(*cursor, [&](const StoredLog &stored) {
+			if (read == maxCount) {
+				return false;
+			}
+			out.push_back(stored.log);
+			*cursor = stored.seq + 1;
+			++read;
+			return true;
+		});
+		return read;
+	};
+	return spill;
+}
+
+void LogFileStore::read(
+    SeekKey key,
+    int64_t from,
+    const std::function<bool(const StoredLog &)> &visitor
+) {
+	LockGuard guard(_mutex);
+	if (_segments.empty() || !visitor) {
+		return;
+	}
+	// Timestamps are compared strictly so entries sharing `from` at the end of the previous
+	// segment or index stride are not skipped.
+	const auto before = [key, from](uint64_t seq, int64_t timestamp) {
+		return key == SeekKey::Seq ? seq <= static_cast<uint64_t>(from) : timestamp < from;
+	};
+
+	size_t first = 0;
+	for (size_t index = 0; index < _segments.size(); ++index) {
+		const Segment &segment = _segments[index];
+		if (!segment.empty && before(segment.firstSeq, segment.firstTimestamp)) {
+			first = index;
+		}
+	}
+
+	uint32_t offset = 0;
+	std::vector<IndexEntry> entries;
+	if (readIndex(_segments[first].id, entries)) {
+		for (const IndexEntry &entry : entries) {
+			if (!before(entry.seq, entry.timestamp)) {
+				break;
+			}
+			offset = entry.offset;
+		}
+	}
+
+	std::string buffer;
+	StoredLog record;
+	for (size_t index = first; index < _segments.size(); ++index, offset = 0) {
+		if (_segments[index].empty) {
+			continue;
+		}
+		std::FILE *file = std::fopen(segmentPath(_segments[index].id, "log").c_str(), "rb");
+		if (file == nullptr) {
+			continue;
+		}
+		bool keepGoing = std::fseek(file, offset, SEEK_SET) == 0;
+		while (keepGoing && readRecord(file, buffer, record)) {
+			const bool wanted = key == SeekKey::Seq
+			                        ? record.seq >= static_cast<uint64_t>(from)
+			                        : static_cast<int64_t>(record.log.timestamp) >= from;
+			if (wanted && !visitor(record)) {
+				std::fclose(file);
+				return;
+			}
+		}
+		std::fclose(file);
+	}
+}
+
+void LogFileStore::readFromSeq(
+    uint64_t fromSeq,
+    const std::function<bool(const StoredLog &)> &visitor
+) {
+	read(SeekKey::Seq, static_cast<int64_t>(fromSeq), visitor);
+}
+
+void LogFileStore::readSince(
+    std::time_t since,
+    const std::function<bool(const StoredLog &)> &visitor
+) {
+	read(SeekKey::Time, static_cast<int64_t>(since), visitor);
+}
+
+std::vector<StoredLog> LogFileStore::readFromSeq(uint64_t fromSeq, size_t maxCount) {
+	std::vector<StoredLog> records;
+	if (maxCount == 0) {
+		return records;
+	}
+	readFromSeq(fromSeq, [&records, maxCount](const StoredLog &record) {
+		records.push_back(record);
+		return records.size() < maxCount;
+	});
+	return records;
+}
+
+std::vector<StoredLog> LogFileStore::readSince(std::time_t since, size_t maxCount) {
+	std::vector<StoredLog> records;
+	if (maxCount == 0) {
+		return records;
+	}
+	readSince(since, [&records, maxCount](const StoredLog &record) {
+		records.push_back(record);
+		return records.size() < maxCount;
+	});
+	return records;
+}
+
+uint64_t LogFileStore::nextSeq() const {
+	LockGuard guard(_mutex);
+	return _nextSeq;
+}
+
+size_t LogFileStore::segmentCount() const {
+	LockGuard guard(_mutex);
+	return _segments.size();
+}
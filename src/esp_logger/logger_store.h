@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "esp_logger/logger.h"
+
+struct LogStoreConfig {
+	std::string directory;          // e.g. "/littlefs/logs" on device, "/tmp/logs" on host
+	std::string prefix = "log";     // Segment files are <prefix>-<8-digit id>.log / .idx
+	size_t maxSegmentBytes = 65536; // Rotate once a segment reaches this size
+	size_t maxSegmentRecords = 0;   // Rotate after this many records (0 = size only)
+	size_t maxSegments = 8;         // Oldest segments are deleted beyond this count
+	size_t indexInterval = 32;      // Records between index entries within a segment
+	bool fsyncOnCommit = true;      // fsync() after each group commit, not only fflush()
+};
+
+struct StoredLog {
+	uint64_t seq = 0; // Store-wide sequence number, increasing across segments and reboots
+	Log log;
+};
+
+namespace logger_store_detail {
+
+// CRC-32 (IEEE 802.3, as used by zlib); pass the previous result to continue a running CRC.
+uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+} // namespace logger_store_detail
+
+// Append-only persistent store on the stdio/VFS file API, so it runs on LittleFS/SPIFFS
+// mounts and on host paths alike. Records go into numbered segment files:
+//   record: payload size (u32), CRC-32 (u32) of everything after it, seq (u64),
+//           timestamp (i64), then level (u8), millis (u32), tag (u8 length + bytes),
+//           message and fields (varint length + bytes each); integers little-endian
+// A torn or corrupted record ends its segment for readers. Each segment has a small
+// `.idx` companion holding (seq, timestamp, offset, CRC) for its first record and every
+// `indexInterval` records after, so readers seek to a sequence number or a point in time
+// by picking a segment and an offset from the indexes instead of scanning all files.
+//
+// append() is a group commit: the whole batch is serialized and written with one fwrite()
+// per segment touched, then flushed (and fsync'd) once. The first append after open()
+// starts a new segment so appends never land behind a torn tail left by a crash.
+class LogFileStore {
+  public:
+	LogFileStore() = default;
+	~LogFileStore();
+
+	LogFileStore(const LogFileStore &) = delete;
+	LogFileStore &operator=(const LogFileStore &) = delete;
+
+	// Creates the directory if needed, discovers existing segments and recovers the next
+	// sequence number. Returns false when the store cannot be used.
+	bool open(const LogStoreConfig &config);
+	void close();
+	bool isOpen() const {
+		return _mutex != nullptr;
+	}
+
+	bool append(LogBatchView batch);
+	bool append(const std::vector<Log> &batch) {
+		return append(LogBatchView(batch.data(), batch.size()));
+	}
+	// An onSync handler that appends every batch. The store must outlive the logger's use
+	// of the callback.
+	SyncViewCallback syncCallback();
+	// A spill store for ESPLogger::setSpillStore that appends overflowed entries and reads
+	// them back from the sequence number current when it was created. Use a store opened for
+	// spilling only; replayed entries stay in the segments until retention removes them.
+	// Spilling writes the file from the logging call that overflowed, under the logger
+	// mutex, so every logging thread waits for that fwrite()/fflush(). fsyncOnCommit is
+	// ignored for these writes.
+	LogSpillStore spillStore();
+
+	// Visits stored entries in order, starting at the first one with `seq >= fromSeq` or
+	// `timestamp >= since`. The visitor returns false to stop early.
+	void readFromSeq(uint64_t fromSeq, const std::function<bool(const StoredLog &)> &visitor);
+	void readSince(std::time_t since, const std::function<bool(const StoredLog &)> &visitor);
+	// Convenience wrappers collecting up to `maxCount` entries.
+	std::vector<StoredLog> readFromSeq(uint64_t fromSeq, size_t maxCount = SIZE_MAX);
+	std::vector<StoredLog> readSince(std::time_t since, size_t maxCount = SIZE_MAX);
+
+	uint64_t nextSeq() const;
+	size_t segmentCount() const;
+
+  private:
+	struct Segment {
+		uint32_t id = 0;
+		uint64_t firstSeq = 0;
+		int64_t firstTimestamp = 0;
+		bool empty = true;
+	};
+	struct IndexEntry {
+		uint64_t seq = 0;
+		int64_t timestamp = 0;
+		uint32_t offset = 0;
+	};
+	enum class SeekKey { Seq, Time };
+
+	std::string segmentPath(uint32_t id, const char *extension) const;
+	bool discoverSegments();
+	bool startSegment();
+	bool append(LogBatchView batch, bool fsync);
+	bool commit(bool fsync);
+	void dropOldSegments();
+	bool readIndex(uint32_t id, std::vector<IndexEntry> &entries) const;
+	void recoverNextSeq();
+	void read(SeekKey key, int64_t from, const std::function<bool(const StoredLog &)> &visitor);
+
+	LogStoreConfig _config;
+	SemaphoreHandle_t _mutex = nullptr;
+	std::FILE *_file = nullptr;
+	std::FILE *_indexFile = nullptr;
+	std::vector<Segment> _segments; // Oldest first; the last one is being written
+	size_t _segmentBytes = 0;
+	size_t _segmentRecords = 0;
+	uint64_t _nextSeq = 0;
+	bool _rotatePending = false; // A failed commit may have left a torn tail behind
+	std::string _staging;        // Serialized batch for the current group commit
+	std::string _indexStaging;
+};
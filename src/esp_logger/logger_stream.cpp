@@ -0,0 +1,328 @@
+#include "esp_logger/logger_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace {
+
+constexpr uint8_t kCborUnsigned = 0;
+constexpr uint8_t kCborNegative = 1;
+constexpr uint8_t kCborText = 3;
+constexpr uint8_t kCborMap = 5;
+constexpr uint8_t kCborFalse = 0xF4;
+constexpr uint8_t kCborTrue = 0xF5;
+constexpr uint8_t kCborNull = 0xF6;
+constexpr uint8_t kCborFloat32 = 0xFA;
+constexpr uint8_t kCborFloat64 = 0xFB;
+
+std::string_view levelName(LogLevel level) {
+	switch (level) {
+	case LogLevel::Debug:
+		return "debug";
+	case LogLevel::Info:
+		return "info";
+	case LogLevel::Warn:
+		return "warn";
+	case LogLevel::Error:
+		return "error";
+	}
+	return "unknown";
+}
+
+size_t countFields(std::string_view fields) {
+	size_t count = 0;
+	LogFieldReader reader(fields);
+	LogField field;
+	while (reader.next(field)) {
+		++count;
+	}
+	return count;
+}
+
+} // namespace
+
+LogBatchStreamer::LogBatchStreamer(
+    LogStreamFormat format,
+    uint8_t *buffer,
+    size_t capacity,
+    ChunkSink sink
+)
+    : _format(format), _buffer(buffer), _capacity(buffer != nullptr ? capacity : 0),
+      _sink(std::move(sink)) {
+}
+
+bool LogBatchStreamer::write(LogBatchView batch) {
+	if (_capacity == 0 || !_sink) {
+		return false;
+	}
+	if (_entryIndex > batch.size()) {
+		// Resumed with a different batch than the interrupted one; start it over.
+		_entryIndex = 0;
+		_entryOffset = 0;
+	}
+
+	for (; _entryIndex < batch.size(); ++_entryIndex) {
+		_skip = _entryOffset;
+		_produced = 0;
+		_stalled = false;
+		if (_format == LogStreamFormat::Cbor) {
+			encodeCbor(batch[_entryIndex]);
+		} else {
+			encodeNdjson(batch[_entryIndex]);
+		}
+		if (_stalled) {
+			_entryOffset = _produced;
+			return false;
+		}
+		_entryOffset = 0;
+	}
+	_entryIndex = 0;
+	return true;
+}
+
+bool LogBatchStreamer::flush() {
+	return _used == 0 || emitChunk();
+}
+
+void LogBatchStreamer::reset() {
+	_used = 0;
+	_entryIndex = 0;
+	_entryOffset = 0;
+}
+
+bool LogBatchStreamer::emitChunk() {
+	if (!_sink(_buffer, _used)) {
+		return false;
+	}
+	_used = 0;
+	return true;
+}
+
+void LogBatchStreamer::putSlow(const char *data, size_t size) {
+	while (size > 0 && !_stalled) {
+		if (_skip > 0) {
+			const size_t skipped = std::min(_skip, size);
+			_skip -= skipped;
+			_produced += skipped;
+			data += skipped;
+			size -= skipped;
+			continue;
+		}
+		// Full buffers are emitted lazily so the last chunk of a batch can still be topped
+		// up by the next one.
+		if (_used == _capacity && !emitChunk()) {
+			_stalled = true;
+			return;
+		}
+		const size_t copied = std::min(size, _capacity - _used);
+		std::memcpy(_buffer + _used, data, copied);
+		_used += copied;
+		_produced += copied;
+		data += copied;
+		size -= copied;
+	}
+}
+
+void LogBatchStreamer::putJsonString(std::string_view text) {
+	static const char kHex[] = "0123456789abcdef";
+	putByte('"');
+	size_t runStart = 0;
+	for (size_t index = 0; index < text.size(); ++index) {
+		const uint8_t value = static_cast<uint8_t>(text[index]);
+		const char *escape = nullptr;
+		char control[] = {'\\', 'u', '0', '0', kHex[value >> 4], kHex[value & 0x0F]};
+		size_t escapeLength = 2;
+		switch (value) {
+		case '"':
+			escape = "\\\"";
+			break;
+		case '\\':
+			escape = "\\\\";
+			break;
+		case '\n':
+			escape = "\\n";
+			break;
+		case '\r':
+			escape = "\\r";
+			break;
+		case '\t':
+			escape = "\\t";
+			break;
+		default:
+			if (value < 0x20) {
+				escape = control;
+				escapeLength = sizeof(control);
+			}
+			break;
+		}
+		if (escape == nullptr) {
+			continue;
+		}
+		put(text.data() + runStart, index - runStart);
+		put(escape, escapeLength);
+		runStart = index + 1;
+	}
+	put(text.data() + runStart, text.size() - runStart);
+	putByte('"');
+}
+
+void LogBatchStreamer::encodeNdjson(const Log &entry) {
+	put("{\"level\":\"");
+	put(levelName(entry.level));
+	put("\",\"tag\":");
+	putJsonString(entry.tag);
+	put(",\"millis\":");
+	put(std::to_string(entry.millis));
+	put(",\"timestamp\":");
+	put(std::to_string(static_cast<long long>(entry.timestamp)));
+	put(",\"message\":");
+	putJsonString(entry.message);
+
+	if (!entry.fields.empty()) {
+		put(",\"fields\":{");
+		LogFieldReader reader(entry.fields);
+		LogField field;
+		bool first = true;
+		std::string number;
+		while (reader.next(field)) {
+			if (!first) {
+				putByte(',');
+			}
+			first = false;
+			putJsonString(field.key);
+			putByte(':');
+			switch (field.type) {
+			case LogFieldType::False:
+			case LogFieldType::True:
+				put(field.boolValue() ? "true" : "false");
+				break;
+			case LogFieldType::String:
+				putJsonString(field.text);
+				break;
+			case LogFieldType::Float:
+			case LogFieldType::Double:
+				if (!std::isfinite(field.floatValue)) {
+					put("null");
+					break;
+				}
+				[[fallthrough]];
+			default:
+				number.clear();
+				logger_fields_detail::appendFieldNumber(number, field);
+				put(number);
+				break;
+			}
+		}
+		putByte('}');
+	}
+	put("}\n");
+}
+
+void LogBatchStreamer::putCborHead(uint8_t major, uint64_t value) {
+	uint8_t head[9];
+	size_t length = 1;
+	const uint8_t type = static_cast<uint8_t>(major << 5);
+	if (value < 24) {
+		head[0] = static_cast<uint8_t>(type | value);
+	} else {
+		size_t width = 8;
+		uint8_t info = 27;
+		if (value <= 0xFF) {
+			width = 1;
+			info = 24;
+		} else if (value <= 0xFFFF) {
+			width = 2;
+			info = 25;
+		} else if (value <= 0xFFFFFFFFu) {
+			width = 4;
+			info = 26;
+		}
+		head[0] = static_cast<uint8_t>(type | info);
+		for (size_t index = 0; index < width; ++index) {
+			head[width - index] = static_cast<uint8_t>(value >> (8 * index));
+		}
+		length += width;
+	}
+	put(reinterpret_cast<const char *>(head), length);
+}
+
+void LogBatchStreamer::putCborInt(int64_t value) {
+	if (value >= 0) {
+		putCborHead(kCborUnsigned, static_cast<uint64_t>(value));
+	} else {
+		putCborHead(kCborNegative, ~static_cast<uint64_t>(value));
+	}
+}
+
+void LogBatchStreamer::putCborText(std::string_view text) {
+	putCborHead(kCborText, text.size());
+	put(text);
+}
+
+void LogBatchStreamer::encodeCbor(const Log &entry) {
+	const bool hasFields = !entry.fields.empty();
+	putCborHead(kCborMap, hasFields ? 6 : 5);
+	putCborText("level");
+	putCborText(levelName(entry.level));
+	putCborText("tag");
+	putCborText(entry.tag);
+	putCborText("millis");
+	putCborHead(kCborUnsigned, entry.millis);
+	putCborText("timestamp");
+	putCborInt(static_cast<int64_t>(entry.timestamp));
+	putCborText("message");
+	putCborText(entry.message);
+	if (!hasFields) {
+		return;
+	}
+
+	putCborText("fields");
+	putCborHead(kCborMap, countFields(entry.fields));
+	LogFieldReader reader(entry.fields);
+	LogField field;
+	while (reader.next(field)) {
+		putCborText(field.key);
+		switch (field.type) {
+		case LogFieldType::Int:
+			putCborInt(field.intValue);
+			break;
+		case LogFieldType::Uint:
+			putCborHead(kCborUnsigned, field.uintValue);
+			break;
+		case LogFieldType::Float: {
+			const float value = static_cast<float>(field.floatValue);
+			uint32_t bits = 0;
+			std::memcpy(&bits, &value, sizeof(bits));
+			putByte(kCborFloat32);
+			for (int shift = 24; shift >= 0; shift -= 8) {
+				putByte(static_cast<uint8_t>(bits >> shift));
+			}
+			break;
+		}
+		case LogFieldType::Double: {
+			uint64_t bits = 0;
+			std::memcpy(&bits, &field.floatValue, sizeof(bits));
+			putByte(kCborFloat64);
+			for (int shift = 56; shift >= 0; shift -= 8) {
+				putByte(static_cast<uint8_t>(bits >> shift));
+			}
+			break;
+		}
+		case LogFieldType::False:
+			putByte(kCborFalse);
+			break;
+		case LogFieldType::True:
+			putByte(kCborTrue);
+			break;
+		case LogFieldType::String:
+			putCborText(field.text);
+			break;
+		default:
+			putByte(kCborNull);
+			break;
+		}
+	}
+}
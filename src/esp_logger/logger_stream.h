@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "esp_logger/logger.h"
+
+enum class LogStreamFormat : uint8_t {
+	// One JSON object per line: {"level","tag","millis","timestamp","message"[,"fields"]}.
+	Ndjson,
+	// A CBOR sequence (RFC 8742): one map per entry with the same keys as the NDJSON form.
+	Cbor,
+};
+
+// Serializes drained batches into a fixed caller-provided buffer and hands every full
+// buffer to `sink`, so exporting a batch of any size needs `capacity` bytes and no
+// per-batch string. Every chunk except the one emitted by flush() is exactly `capacity`
+// bytes, which lines chunks up with flash pages or MTU-sized packets. A partially filled
+// buffer is carried over into the next batch.
+//
+// A sink returns false when it cannot take the chunk right now (socket busy, flash write
+// failed). write() then returns false and remembers the entry and byte it stopped at;
+// calling it again with the same batch retries the chunk and continues from there.
+class LogBatchStreamer {
+  public:
+	using ChunkSink = std::function<bool(const uint8_t *data, size_t size)>;
+
+	LogBatchStreamer(LogStreamFormat format, uint8_t *buffer, size_t capacity, ChunkSink sink);
+
+	// Serializes `batch`, emitting full chunks. Returns false when the sink refused a chunk.
+	bool write(LogBatchView batch);
+	bool write(const std::vector<Log> &batch) {
+		return write(LogBatchView(batch.data(), batch.size()));
+	}
+	// Emits the partially filled buffer, if any, as a shorter final chunk.
+	bool flush();
+	// Drops the buffered bytes and the resume position.
+	void reset();
+
+	// True when a write() stopped inside a batch and must be called again to finish it.
+	bool interrupted() const {
+		return _entryIndex != 0 || _entryOffset != 0;
+	}
+	size_t buffered() const {
+		return _used;
+	}
+
+  private:
+	void encodeNdjson(const Log &entry);
+	void encodeCbor(const Log &entry);
+	void putJsonString(std::string_view text);
+	void putCborHead(uint8_t major, uint64_t value);
+	void putCborInt(int64_t value);
+	void putCborText(std::string_view text);
+	void put(const char *data, size_t size) {
+		if (_skip == 0 && size <= _capacity - _used) {
+			std::memcpy(_buffer + _used, data, size);
+			_used += size;
+			_produced += size;
+			return;
+		}
+		putSlow(data, size);
+	}
+	void putSlow(const char *data, size_t size);
+	void put(std::string_view text) {
+		put(text.data(), text.size());
+	}
+	void putByte(uint8_t value) {
+		put(reinterpret_cast<const char *>(&value), 1);
+	}
+	bool emitChunk();
+
+	LogStreamFormat _format;
+	uint8_t *_buffer;
+	size_t _capacity;
+	ChunkSink _sink;
+	size_t _used = 0;
+	// Resume position: the entry being written and how many of its bytes already went out.
+	size_t _entryIndex = 0;
+	size_t _entryOffset = 0;
+	// Per-entry pass state. An interrupted entry is re-encoded from its start on resume,
+	// skipping the bytes it had already produced, so no encoder state has to be saved.
+	size_t _skip = 0;
+	size_t _produced = 0;
+	bool _stalled = false;
+};
@@ -0,0 +1,156 @@
+#include "esp_logger/logger_tags.h"
+
+#include <cstring>
+#include <new>
+
+#include "esp_logger/logger_lock.h"
+
+namespace {
+
+constexpr uint16_t kEmptySlot = 0xFFFF;
+
+size_t roundUpPowerOfTwo(size_t value) {
+	size_t result = 1;
+	while (result < value) {
+		result <<= 1;
+	}
+	return result;
+}
+
+} // namespace
+
+LogTagRegistry::LogTagRegistry(size_t capacity)
+    : _capacity(capacity == 0 ? 1 : (capacity >= kOverflowId ? kOverflowId - 1 : capacity)) {
+	_names = new (std::nothrow) std::string[_capacity];
+	_nameHashes = new (std::nothrow) uint32_t[_capacity];
+	_hashSlotCount = roundUpPowerOfTwo(_capacity * 2);
+	_hashSlots = new (std::nothrow) uint16_t[_hashSlotCount];
+	// Several call sites may use distinct pointers for the same tag text, so give the
+	// pointer cache more room than the name table.
+	_pointerSlotCount = roundUpPowerOfTwo(_capacity * 4);
+	_pointerSlots = new (std::nothrow) PointerSlot[_pointerSlotCount];
+
+	if (_nameHashes == nullptr || _hashSlots == nullptr || _pointerSlots == nullptr) {
+		delete[] _names;
+		_names = nullptr;
+		return;
+	}
+	for (size_t index = 0; index < _hashSlotCount; ++index) {
+		_hashSlots[index] = kEmptySlot;
+	}
+	_mutex = xSemaphoreCreateMutex();
+}
+
+LogTagRegistry::~LogTagRegistry() {
+	if (_mutex != nullptr) {
+		vSemaphoreDelete(_mutex);
+	}
+	delete[] _pointerSlots;
+	delete[] _hashSlots;
+	delete[] _nameHashes;
+	delete[] _names;
+}
+
+uint32_t LogTagRegistry::hashText(const char *text) {
+	uint32_t hash = 2166136261u;
+	for (const char *cursor = text; *cursor != '\0'; ++cursor) {
+		hash ^= static_cast<uint8_t>(*cursor);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+size_t LogTagRegistry::hashPointer(const char *pointer) {
+	const uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+	return static_cast<size_t>((value >> 3) ^ (value >> 11));
+}
+
+uint16_t LogTagRegistry::intern(const char *tag) {
+	if (tag == nullptr) {
+		tag = "";
+	}
+
+	const size_t mask = _pointerSlotCount - 1;
+	size_t index = hashPointer(tag) & mask;
+	for (size_t probe = 0; probe < _pointerSlotCount; ++probe) {
+		const char *key = _pointerSlots[index].key.load(std::memory_order_acquire);
+		if (key == tag) {
+			// Confirm the text too: a reused buffer can hand us the same pointer with
+			// different contents.
+			const uint16_t id = _pointerSlots[index].id.load(std::memory_order_relaxed);
+			if (id < _capacity && std::strcmp(_names[id].c_str(), tag) == 0) {
+				return id;
+			}
+			break;
+		}
+		if (key == nullptr) {
+			break;
+		}
+		index = (index + 1) & mask;
+	}
+
+	LockGuard guard(_mutex);
+	const uint32_t hash = hashText(tag);
+	uint16_t id = findByNameLocked(tag, hash);
+	if (id == kOverflowId) {
+		const size_t count = _count.load(std::memory_order_relaxed);
+		if (count < _capacity) {
+			id = static_cast<uint16_t>(count);
+			_names[id] = tag;
+			_nameHashes[id] = hash;
+			size_t slot = hash & (_hashSlotCount - 1);
+			while (_hashSlots[slot] != kEmptySlot) {
+				slot = (slot + 1) & (_hashSlotCount - 1);
+			}
+			_hashSlots[slot] = id;
+			_count.store(count + 1, std::memory_order_release);
+		}
+	}
+	cachePointerLocked(tag, id);
+	return id;
+}
+
+uint16_t LogTagRegistry::find(const char *tag) const {
+	if (tag == nullptr) {
+		tag = "";
+	}
+	LockGuard guard(_mutex);
+	return findByNameLocked(tag, hashText(tag));
+}
+
+const std::string &LogTagRegistry::name(uint16_t id) const {
+	if (id >= _count.load(std::memory_order_acquire)) {
+		return _overflowName;
+	}
+	return _names[id];
+}
+
+uint16_t LogTagRegistry::findByNameLocked(const char *tag, uint32_t hash) const {
+	const size_t mask = _hashSlotCount - 1;
+	for (size_t slot = hash & mask; _hashSlots[slot] != kEmptySlot; slot = (slot + 1) & mask) {
+		const uint16_t id = _hashSlots[slot];
+		if (_nameHashes[id] == hash && std::strcmp(_names[id].c_str(), tag) == 0) {
+			return id;
+		}
+	}
+	return kOverflowId;
+}
+
+void LogTagRegistry::cachePointerLocked(const char *tag, uint16_t id) {
+	const size_t mask = _pointerSlotCount - 1;
+	size_t index = hashPointer(tag) & mask;
+	for (size_t probe = 0; probe < _pointerSlotCount; ++probe) {
+		const char *key = _pointerSlots[index].key.load(std::memory_order_relaxed);
+		if (key == tag) {
+			return;
+		}
+		if (key == nullptr) {
+			// Publish the id before the key so lock-free readers never see a stale id.
+			_pointerSlots[index].id.store(id, std::memory_order_relaxed);
+			_pointerSlots[index].key.store(tag, std::memory_order_release);
+			return;
+		}
+		index = (index + 1) & mask;
+	}
+	// Cache full: this pointer keeps taking the hashed slow path, which is still correct.
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Per-logger tag interning table. Buffered records store a 16-bit id instead of the tag
+// text; the name is resolved only when a record is handed to a callback.
+//
+// Lookups first probe an insert-only table keyed by the tag pointer, which is lock-free
+// and hits for every call site after its first log line (the cached name is compared
+// against the text to stay correct for reused buffers). Unknown pointers fall back to a
+// content hash under the registry's own mutex (never the logger mutex).
+class LogTagRegistry {
+  public:
+	// Returned once `capacity` distinct tags are registered; resolves to kOverflowName.
+	static constexpr uint16_t kOverflowId = 0xFFFF;
+	static constexpr const char *kOverflowName = "~";
+
+	explicit LogTagRegistry(size_t capacity);
+	~LogTagRegistry();
+
+	LogTagRegistry(const LogTagRegistry &) = delete;
+	LogTagRegistry &operator=(const LogTagRegistry &) = delete;
+
+	bool valid() const {
+		return _mutex != nullptr && _names != nullptr;
+	}
+
+	uint16_t intern(const char *tag);
+	// Looks up an existing tag without registering it. Returns kOverflowId if unknown.
+	uint16_t find(const char *tag) const;
+	const std::string &name(uint16_t id) const;
+
+	size_t size() const {
+		return _count.load(std::memory_order_acquire);
+	}
+	size_t capacity() const {
+		return _capacity;
+	}
+
+  private:
+	struct PointerSlot {
+		std::atomic<const char *> key{nullptr};
+		std::atomic<uint16_t> id{0};
+	};
+
+	static uint32_t hashText(const char *text);
+	static size_t hashPointer(const char *pointer);
+	uint16_t findByNameLocked(const char *tag, uint32_t hash) const;
+	void cachePointerLocked(const char *tag, uint16_t id);
+
+	size_t _capacity;
+	std::string *_names = nullptr;
+	uint32_t *_nameHashes = nullptr;
+	uint16_t *_hashSlots = nullptr;
+	size_t _hashSlotCount = 0;
+	PointerSlot *_pointerSlots = nullptr;
+	size_t _pointerSlotCount = 0;
+	std::atomic<size_t> _count{0};
+	SemaphoreHandle_t _mutex = nullptr;
+	std::string _overflowName{kOverflowName};
+};
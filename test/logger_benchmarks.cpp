@@ -0,0 +1,555 @@
+#include "esp_logger/logger.h"
+#include "esp_logger/logger_compress.h"
+#include "esp_logger/logger_format.h"
+#include "esp_logger/logger_store.h"
+#include "esp_logger/logger_stream.h"
+#include "test_support.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char *kShortFormat = "loop=%u temp=%d.%02d state=%s";
+constexpr const char *kLongFormat = "seq=%u payload=%s";
+constexpr const char *kMixedFormat = "loop=%u temp=%.2f rssi=%d state=%s";
+constexpr const char *kTypedFormat = "loop={} temp={:.2} rssi={} state={}";
+
+size_t g_iterations = 200000;
+volatile size_t g_sink = 0;
+
+double toNs(Clock::duration duration) {
+	return static_cast<double>(
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+	);
+}
+
+template <typename Fn> double measureNsPerOp(size_t iterations, Fn &&fn) {
+	const auto start = Clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		fn(i);
+	}
+	return toNs(Clock::now() - start) / static_cast<double>(iterations);
+}
+
+void report(const char *name, double nsPerOp) {
+	std::printf("%-48s %10.1f ns/op\n", name, nsPerOp);
+}
+
+void reportComparison(const char *name, double baselineNs, double candidateNs) {
+	report(name, candidateNs);
+	std::printf("%-48s %10.2fx\n", "  speedup vs baseline", baselineNs / candidateNs);
+}
+
+// Reference copy of the original two-pass formatter: measure, allocate a staging
+// vector, format again, then copy into the returned string.
+std::string legacyFormatMessage(const char *fmt, va_list args) {
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	const int required = vsnprintf(nullptr, 0, fmt, argsCopy);
+	va_end(argsCopy);
+	if (required <= 0) {
+		return {};
+	}
+
+	InternalCharVector buffer(static_cast<size_t>(required) + 1, '\0', LoggerAllocator<char>());
+	va_list argsCopy2;
+	va_copy(argsCopy2, args);
+	vsnprintf(buffer.data(), buffer.size(), fmt, argsCopy2);
+	va_end(argsCopy2);
+	return std::string(buffer.data(), static_cast<size_t>(required));
+}
+
+std::string callLegacy(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	std::string result = legacyFormatMessage(fmt, args);
+	va_end(args);
+	return result;
+}
+
+std::string callScratch(const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	std::string result = logger_format_detail::formatMessage(fmt, args);
+	va_end(args);
+	return result;
+}
+
+void benchmarkFormatting() {
+	std::printf("\n== Message formatting ==\n");
+
+	const double legacyShort = measureNsPerOp(g_iterations, [](size_t i) {
+		g_sink += callLegacy(kShortFormat, static_cast<unsigned>(i), 21, 37, "ok").size();
+	});
+	const double scratchShort = measureNsPerOp(g_iterations, [](size_t i) {
+		g_sink += callScratch(kShortFormat, static_cast<unsigned>(i), 21, 37, "ok").size();
+	});
+	report("short message, two-pass (legacy)", legacyShort);
+	reportComparison("short message, single-pass scratch", legacyShort, scratchShort);
+
+	const std::string payload(400, 'x');
+	const double legacyLong = measureNsPerOp(g_iterations / 4, [&payload](size_t i) {
+		g_sink += callLegacy(kLongFormat, static_cast<unsigned>(i), payload.c_str()).size();
+	});
+	const double scratchLong = measureNsPerOp(g_iterations / 4, [&payload](size_t i) {
+		g_sink += callScratch(kLongFormat, static_cast<unsigned>(i), payload.c_str()).size();
+	});
+	report("oversized message, two-pass (legacy)", legacyLong);
+	reportComparison("oversized message, measured fallback", legacyLong, scratchLong);
+
+	const double printfMixed = measureNsPerOp(g_iterations, [](size_t i) {
+		g_sink += callScratch(kMixedFormat, static_cast<unsigned>(i), 21.37, -61, "ok").size();
+	});
+	const double typedMixed = measureNsPerOp(g_iterations, [](size_t i) {
+		const unsigned loop = static_cast<unsigned>(i);
+		g_sink += logger_fmt_detail::format(kTypedFormat, loop, 21.37, -61, "ok").size();
+	});
+	report("int/float/string, vsnprintf scratch", printfMixed);
+	reportComparison("int/float/string, typed {} formatter", printfMixed, typedMixed);
+}
+
+void benchmarkLoggerInfo() {
+	std::printf("\n== ESPLogger::info end-to-end ==\n");
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 256;
+	config.consoleLogLevel = LogLevel::Error;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+
+	const double infoNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		logger.info("BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+	});
+	report("info() into RAM buffer", infoNs);
+	const double typedNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		logger.info("BENCH", ESPLOGGER_FMT("loop={} temp={}.{}"), static_cast<unsigned>(i), 21, 37);
+	});
+	reportComparison("info() with ESPLOGGER_FMT", infoNs, typedNs);
+	const double fieldsNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		logger.info("BENCH").kv("loop", static_cast<unsigned>(i)).kv("temp", 21.37f).emit();
+	});
+	reportComparison("info(tag).kv().emit() structured", infoNs, fieldsNs);
+	logger.deinit();
+
+	config.deferFormatting = true;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+	const double deferredNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		logger.info("BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+	});
+	reportComparison("info() with deferFormatting", infoNs, deferredNs);
+
+	const double renderNs = measureNsPerOp(g_iterations / 256, [&logger](size_t) {
+		for (int i = 0; i < 256; ++i) {
+			logger.info("BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+		}
+		g_sink += logger.getAllLogs().size();
+	});
+	report("deferred render of 256 entries (getAllLogs)", renderNs);
+	logger.deinit();
+
+	config.deferFormatting = false;
+	config.captureLevel = LogLevel::Info;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+	const double gatedNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		logger.debug("BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+	});
+	reportComparison("debug() below captureLevel", infoNs, gatedNs);
+	const double macroNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		ESPLOGGER_DEBUG(logger, "BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+	});
+	reportComparison("ESPLOGGER_DEBUG below captureLevel", infoNs, macroNs);
+
+	logger.setTagLevel("TRACE", LogLevel::Debug);
+	const double tagGatedNs = measureNsPerOp(g_iterations, [&logger](size_t i) {
+		ESPLOGGER_DEBUG(logger, "BENCH", "loop=%u temp=%d.%02d", static_cast<unsigned>(i), 21, 37);
+	});
+	reportComparison("ESPLOGGER_DEBUG with a tag override table", infoNs, tagGatedNs);
+	logger.deinit();
+}
+
+struct ContentionResult {
+	double nsPerOp = 0.0;
+	double worstCallUs = 0.0;
+};
+
+ContentionResult runContention(bool useLockFreeRing, int producers, size_t perProducer) {
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 1024;
+	config.consoleLogLevel = LogLevel::Error;
+	config.useLockFreeRing = useLockFreeRing;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return {};
+	}
+
+	size_t synced = 0;
+	logger.onSync([&synced](const std::vector<Log> &logs) { synced += logs.size(); });
+
+	std::atomic<bool> producing{true};
+	std::thread syncer([&logger, &producing]() {
+		while (producing.load(std::memory_order_relaxed)) {
+			logger.sync();
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	});
+
+	std::vector<Clock::duration> worstPerProducer(static_cast<size_t>(producers));
+	const auto start = Clock::now();
+	std::vector<std::thread> threads;
+	for (int producer = 0; producer < producers; ++producer) {
+		threads.emplace_back([&logger, &worstPerProducer, producer, perProducer]() {
+			Clock::duration worst{};
+			for (size_t i = 0; i < perProducer; ++i) {
+				const auto callStart = Clock::now();
+				logger.info("BENCH", "seq=%u", static_cast<unsigned>(i));
+				const auto callTime = Clock::now() - callStart;
+				if (callTime > worst) {
+					worst = callTime;
+				}
+			}
+			worstPerProducer[static_cast<size_t>(producer)] = worst;
+		});
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	const auto elapsed = Clock::now() - start;
+
+	producing.store(false, std::memory_order_relaxed);
+	syncer.join();
+	logger.deinit();
+	g_sink += synced;
+
+	ContentionResult result;
+	const double totalOps = static_cast<double>(perProducer) * static_cast<double>(producers);
+	result.nsPerOp = toNs(elapsed) / totalOps;
+	for (const auto &worst : worstPerProducer) {
+		const double worstUs = toNs(worst) / 1000.0;
+		if (worstUs > result.worstCallUs) {
+			result.worstCallUs = worstUs;
+		}
+	}
+	return result;
+}
+
+double measureSyncOfThousand(ESPLogger &logger) {
+	constexpr int kEntries = 1000;
+	return measureNsPerOp(g_iterations / kEntries + 1, [&logger](size_t) {
+		for (int i = 0; i < kEntries; ++i) {
+			logger.info("BENCH", "sync entry %d with a payload past the SSO limit", i);
+		}
+		logger.sync();
+	});
+}
+
+void benchmarkSyncHandoff() {
+	std::printf("\n== sync handoff of 1000 entries (fill + sync) ==\n");
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 1000;
+	config.consoleLogLevel = LogLevel::Error;
+	config.usePSRAMBuffers = true;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+
+	logger.onSync([](const std::vector<Log> &logs) { g_sink += logs.size(); });
+	const double vectorNs = measureSyncOfThousand(logger);
+	report("onSync(std::vector<Log>)", vectorNs);
+
+	logger.onSync([](LogBatchView logs) { g_sink += logs.size(); });
+	const double viewNs = measureSyncOfThousand(logger);
+	reportComparison("onSync(LogBatchView)", vectorNs, viewNs);
+	logger.deinit();
+}
+
+void benchmarkSyncLockHold() {
+	std::printf("\n== producer stall during sync (logger mutex hold) ==\n");
+
+	for (size_t entries : {100u, 1000u, 10000u}) {
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.maxLogInRam = entries;
+		config.consoleLogLevel = LogLevel::Error;
+		if (!logger.init(config)) {
+			std::printf("logger init failed\n");
+			return;
+		}
+		logger.onSync([](LogBatchView logs) { g_sink += logs.size(); });
+
+		for (int round = 0; round < 5; ++round) {
+			for (size_t i = 0; i < entries; ++i) {
+				logger.info("BENCH", "entry %u", static_cast<unsigned>(i));
+			}
+			logger.sync();
+		}
+		const LoggerStats stats = logger.getStats();
+		std::printf(
+		    "%6zu entries: max lock hold %4u us over %u syncs\n",
+		    entries,
+		    static_cast<unsigned>(stats.maxSyncLockHoldMicros),
+		    static_cast<unsigned>(stats.syncCount)
+		);
+		logger.deinit();
+	}
+}
+
+void benchmarkBatchExport() {
+	std::printf("\n== NDJSON export of a 1000-entry batch ==\n");
+
+	std::vector<Log> batch(1000);
+	for (size_t i = 0; i < batch.size(); ++i) {
+		batch[i].level = LogLevel::Info;
+		batch[i].tag = "BENCH";
+		batch[i].millis = static_cast<uint32_t>(i);
+		batch[i].timestamp = 1700000000;
+		batch[i].message = "loop=" + std::to_string(i) + " temp=21.37 state=\"idle\"";
+	}
+
+	// Typical hand-written consumer: build the whole batch in one string, then write it.
+	size_t wholeBatchBytes = 0;
+	const size_t rounds = g_iterations / 1000 + 1;
+	const double concatNs = measureNsPerOp(rounds, [&batch, &wholeBatchBytes](size_t) {
+		std::string out;
+		for (const Log &entry : batch) {
+			out += "{\"level\":\"info\",\"tag\":\"" + entry.tag + "\",\"millis\":";
+			out += std::to_string(entry.millis) + ",\"timestamp\":";
+			out += std::to_string(entry.timestamp) + ",\"message\":\"";
+			for (const char value : entry.message) {
+				if (value == '"' || value == '\\') {
+					out.push_back('\\');
+				}
+				out.push_back(value);
+			}
+			out += "\"}\n";
+		}
+		wholeBatchBytes = out.capacity();
+		g_sink += out.size();
+	});
+	report("concatenate batch, then write", concatNs);
+
+	uint8_t chunk[512];
+	LogBatchStreamer streamer(
+	    LogStreamFormat::Ndjson,
+	    chunk,
+	    sizeof(chunk),
+	    [](const uint8_t *, size_t size) {
+		    g_sink += size;
+		    return true;
+	    }
+	);
+	const double streamNs = measureNsPerOp(rounds, [&streamer, &batch](size_t) {
+		streamer.write(batch);
+		streamer.flush();
+	});
+	reportComparison("LogBatchStreamer, 512-byte chunks", concatNs, streamNs);
+	std::printf(
+	    "%-48s %10zu vs %zu bytes\n",
+	    "  export buffer (concatenated vs streamed)",
+	    wholeBatchBytes,
+	    sizeof(chunk)
+	);
+}
+
+void benchmarkBatchCompression() {
+	std::printf("\n== LZSS-compressed NDJSON export of a 1000-entry batch ==\n");
+
+	static const char *const kStates[] = {"idle", "connecting", "connected", "sleeping"};
+	std::vector<Log> batch(1000);
+	for (size_t i = 0; i < batch.size(); ++i) {
+		batch[i].level = i % 10 == 0 ? LogLevel::Warn : LogLevel::Info;
+		batch[i].tag = i % 3 == 0 ? "WIFI" : "SENSOR";
+		batch[i].millis = 120000 + static_cast<uint32_t>(i) * 53;
+		batch[i].timestamp = 1700000000 + static_cast<std::time_t>(i / 20);
+		batch[i].message = "loop=" + std::to_string(i) + " temp=" + std::to_string(20 + i % 7) +
+		                   "." + std::to_string(i % 10) + " state=" + kStates[i % 4];
+	}
+
+	uint8_t chunk[512];
+	LogCompressor compressor(
+	    [](const uint8_t *, size_t size) {
+		    g_sink += size;
+		    return true;
+	    },
+	    sizeof(chunk)
+	);
+	LogBatchStreamer streamer(
+	    LogStreamFormat::Ndjson,
+	    chunk,
+	    sizeof(chunk),
+	    compressor.chunkSink()
+	);
+	const size_t rounds = g_iterations / 1000 + 1;
+	const double compressNs = measureNsPerOp(rounds, [&streamer, &batch](size_t) {
+		streamer.write(batch);
+		streamer.flush();
+	});
+	report("stream + compress batch (512-byte chunks)", compressNs);
+	std::printf(
+	    "%-48s %10.2fx (%llu -> %llu bytes)\n",
+	    "  compression ratio",
+	    static_cast<double>(compressor.rawBytes()) / static_cast<double>(compressor.frameBytes()),
+	    static_cast<unsigned long long>(compressor.rawBytes()),
+	    static_cast<unsigned long long>(compressor.frameBytes())
+	);
+}
+
+void benchmarkFileStore() {
+	std::printf("\n== LogFileStore, 1000 entries with fsync (per entry) ==\n");
+
+	const std::string directory =
+	    (std::filesystem::temp_directory_path() / "esplogger_store_bench").string();
+	std::vector<Log> batch(1000);
+	for (size_t i = 0; i < batch.size(); ++i) {
+		batch[i].level = LogLevel::Info;
+		batch[i].tag = "BENCH";
+		batch[i].millis = static_cast<uint32_t>(i);
+		batch[i].timestamp = 1700000000 + static_cast<std::time_t>(i);
+		batch[i].message = "stored entry " + std::to_string(i);
+	}
+
+	LogStoreConfig storeConfig;
+	storeConfig.directory = directory;
+	storeConfig.maxSegmentBytes = 256 * 1024;
+	double perRecordNs = 0.0;
+	for (const bool grouped : {false, true}) {
+		std::filesystem::remove_all(directory);
+		LogFileStore store;
+		if (!store.open(storeConfig)) {
+			std::printf("store open failed\n");
+			return;
+		}
+		const double batchNs = measureNsPerOp(1, [&store, &batch, grouped](size_t) {
+			if (grouped) {
+				g_sink += store.append(batch) ? batch.size() : 0;
+				return;
+			}
+			for (const Log &entry : batch) {
+				g_sink += store.append(LogBatchView(&entry, 1)) ? 1 : 0;
+			}
+		});
+		const double nsPerEntry = batchNs / static_cast<double>(batch.size());
+		if (!grouped) {
+			perRecordNs = nsPerEntry;
+			report("append, one commit per entry", nsPerEntry);
+		} else {
+			reportComparison("append, one group commit per batch", perRecordNs, nsPerEntry);
+		}
+	}
+	std::filesystem::remove_all(directory);
+}
+
+void benchmarkMappedStorage() {
+	std::printf("\n== buffered storage, log + sync every 1000 entries ==\n");
+
+	const std::string path =
+	    (std::filesystem::temp_directory_path() / "esplogger_mapped_bench.bin").string();
+	double dequeNs = 0.0;
+	for (const bool mapped : {false, true}) {
+		std::filesystem::remove(path);
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.consoleLogLevel = LogLevel::Error;
+		config.maxLogInRam = 1000;
+		config.syncWatermarkPercent = 0;
+		if (mapped) {
+			config.mappedLogPath = path.c_str();
+			config.mappedLogBytes = 1024 * 1024;
+		}
+		if (!logger.init(config)) {
+			std::printf("logger init failed\n");
+			return;
+		}
+		logger.onSync([](LogBatchView logs) { g_sink += logs.size(); });
+
+		const double nsPerEntry = measureNsPerOp(g_iterations, [&logger](size_t i) {
+			logger.info("BENCH", kShortFormat, static_cast<unsigned>(i), 21, 5, "idle");
+			if (i % 1000 == 999) {
+				logger.sync();
+			}
+		});
+		if (!mapped) {
+			dequeNs = nsPerEntry;
+			report("std::deque (maxLogInRam)", nsPerEntry);
+		} else {
+			reportComparison("mmap'd file ring (mappedLogPath)", dequeNs, nsPerEntry);
+		}
+		logger.deinit();
+	}
+	std::filesystem::remove(path);
+}
+
+void benchmarkContention() {
+	std::printf("\n== Multi-producer contention (concurrent sync) ==\n");
+	std::printf("(hardware threads: %u)\n", std::thread::hardware_concurrency());
+
+	const size_t perProducer = g_iterations / 4;
+	for (int producers : {1, 2, 4, 8}) {
+		for (bool useLockFreeRing : {false, true}) {
+			const ContentionResult result = runContention(useLockFreeRing, producers, perProducer);
+			char label[64];
+			std::snprintf(
+			    label,
+			    sizeof(label),
+			    "%d producer(s), %s",
+			    producers,
+			    useLockFreeRing ? "lock-free ring" : "mutex deque"
+			);
+			report(label, result.nsPerOp);
+			std::printf("%-48s %10.1f us\n", "  worst single call", result.worstCallUs);
+		}
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc > 1) {
+		const long requested = std::strtol(argv[1], nullptr, 10);
+		if (requested > 0) {
+			g_iterations = static_cast<size_t>(requested);
+		}
+	}
+
+	test_support::resetMillis();
+	std::printf("ESPLogger host benchmarks (%zu iterations)\n", g_iterations);
+
+	benchmarkFormatting();
+	benchmarkLoggerInfo();
+	benchmarkSyncHandoff();
+	benchmarkSyncLockHold();
+	benchmarkBatchExport();
+	benchmarkBatchCompression();
+	benchmarkFileStore();
+	benchmarkMappedStorage();
+	benchmarkContention();
+
+	return g_sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+#include "esp_logger/logger.h"
+#include "esp_logger/logger_json_writer.h"
+#include "test_support.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if !ESPLOGGER_HAS_ARDUINOJSON_V7
+#error "JSON benchmarks require ArduinoJson v7 support"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+size_t g_iterations = 200000;
+volatile size_t g_sink = 0;
+
+double toNs(Clock::duration duration) {
+	return static_cast<double>(
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+	);
+}
+
+template <typename Fn> double measureNsPerOp(size_t iterations, Fn &&fn) {
+	const auto start = Clock::now();
+	for (size_t i = 0; i < iterations; ++i) {
+		fn(i);
+	}
+	return toNs(Clock::now() - start) / static_cast<double>(iterations);
+}
+
+void report(const char *name, double nsPerOp) {
+	std::printf("%-48s %10.1f ns/op\n", name, nsPerOp);
+}
+
+void reportComparison(const char *name, double baselineNs, double candidateNs) {
+	report(name, candidateNs);
+	std::printf("%-48s %10.2fx\n", "  speedup vs baseline", baselineNs / candidateNs);
+}
+
+// Reference copy of the original serializer: measure, allocate a staging vector,
+// serialize into it, then copy into the returned string.
+std::string legacySerialize(ArduinoJson::JsonVariantConst json, bool pretty) {
+	const size_t required =
+	    pretty ? ArduinoJson::measureJsonPretty(json) : ArduinoJson::measureJson(json);
+	if (required == 0) {
+		return {};
+	}
+
+	InternalCharVector buffer(required + 1, '\0', LoggerAllocator<char>());
+	char *data = buffer.data();
+	const size_t written = pretty ? ArduinoJson::serializeJsonPretty(json, data, buffer.size())
+	                              : ArduinoJson::serializeJson(json, data, buffer.size());
+	if (written == 0) {
+		return {};
+	}
+	return std::string(buffer.data(), written);
+}
+
+std::string singlePassSerialize(ArduinoJson::JsonVariantConst json, bool pretty) {
+	std::string message;
+	LogStringWriter writer(message);
+	const size_t written = pretty ? ArduinoJson::serializeJsonPretty(json, writer)
+	                              : ArduinoJson::serializeJson(json, writer);
+	return written == 0 ? std::string() : message;
+}
+
+void fillDocument(ArduinoJson::JsonDocument &doc, int members) {
+	static const char *const kKeys[] = {
+	    "sensor", "rssi", "uptime", "state", "channel", "heap", "temp", "ok",
+	};
+	for (int index = 0; index < members; ++index) {
+		std::string key = kKeys[index % 8];
+		key += std::to_string(index);
+		if (index % 3 == 0) {
+			doc[key.c_str()] = "value-with-some-text";
+		} else if (index % 3 == 1) {
+			doc[key.c_str()] = index * 37;
+		} else {
+			doc[key.c_str()] = index % 2 == 0;
+		}
+	}
+}
+
+void benchmarkSerializer(const char *label, int members, size_t iterations) {
+	ArduinoJson::JsonDocument doc;
+	fillDocument(doc, members);
+	const ArduinoJson::JsonVariantConst json = doc.as<ArduinoJson::JsonVariantConst>();
+
+	std::printf("\n== %s (%zu bytes compact) ==\n", label, ArduinoJson::measureJson(json));
+	for (const bool pretty : {false, true}) {
+		const double legacyNs = measureNsPerOp(iterations, [&json, pretty](size_t) {
+			g_sink += legacySerialize(json, pretty).size();
+		});
+		const double singlePassNs = measureNsPerOp(iterations, [&json, pretty](size_t) {
+			g_sink += singlePassSerialize(json, pretty).size();
+		});
+		report(
+		    pretty ? "pretty, measure + stage + copy" : "compact, measure + stage + copy",
+		    legacyNs
+		);
+		reportComparison(
+		    pretty ? "pretty, single pass into string" : "compact, single pass into string",
+		    legacyNs,
+		    singlePassNs
+		);
+	}
+}
+
+void benchmarkLoggerJson() {
+	std::printf("\n== ESPLogger::info(JsonDocument) end-to-end ==\n");
+
+	ArduinoJson::JsonDocument doc;
+	fillDocument(doc, 16);
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 256;
+	config.consoleLogLevel = LogLevel::Error;
+	config.usePrettyJson = false;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+	const double immediateNs = measureNsPerOp(g_iterations, [&logger, &doc](size_t) {
+		logger.info("JSON", doc);
+	});
+	report("info(doc), serialized on the caller", immediateNs);
+	logger.deinit();
+
+	config.deferJson = true;
+	if (!logger.init(config)) {
+		std::printf("logger init failed\n");
+		return;
+	}
+	const double deferredNs = measureNsPerOp(g_iterations, [&logger, &doc](size_t) {
+		logger.info("JSON", doc);
+	});
+	reportComparison("info(doc) with deferJson", immediateNs, deferredNs);
+	logger.deinit();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc > 1) {
+		const long requested = std::strtol(argv[1], nullptr, 10);
+		if (requested > 0) {
+			g_iterations = static_cast<size_t>(requested);
+		}
+	}
+
+	test_support::resetMillis();
+	std::printf("ESPLogger JSON host benchmarks (%zu iterations)\n", g_iterations);
+
+	benchmarkSerializer("small document", 4, g_iterations);
+	benchmarkSerializer("large document", 64, g_iterations / 4);
+	benchmarkLoggerJson();
+
+	return g_sink == 0 ? 1 : 0;
+}
@@ -236,6 +236,52 @@ void test_printf_logging_still_works_in_json_build() {
 	logger.deinit();
 }
 
+void test_deferred_json_serializes_on_the_sync_path() {
+	test_support::resetMillis();
+
+	for (const size_t maxLogBytes : {static_cast<size_t>(0), static_cast<size_t>(1024)}) {
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.consoleLogLevel = LogLevel::Error;
+		config.usePrettyJson = false;
+		config.deferJson = true;
+		config.maxLogBytes = maxLogBytes;
+
+		if (!logger.init(config)) {
+			fail("Logger failed to initialize");
+		}
+
+		ArduinoJson::JsonDocument doc;
+		doc["hello"] = "world";
+		doc["answer"] = 7;
+		logger.info("JSON", doc);
+		doc["answer"] = 8;
+
+		expect_equal(
+		    logger.getAllLogs().front().message,
+		    std::string("{\"hello\":\"world\",\"answer\":7}"),
+		    "Deferred JSON should render the document as it was logged"
+		);
+
+		config.usePrettyJson = true;
+		if (!logger.reconfigure(config)) {
+			fail("reconfigure should accept usePrettyJson");
+		}
+		std::vector<Log> syncedLogs;
+		logger.onSync([&syncedLogs](const std::vector<Log> &logs) { syncedLogs = logs; });
+		logger.sync();
+		expect_equal(syncedLogs.size(), static_cast<size_t>(1), "Deferred JSON should sync");
+		expect_equal(
+		    syncedLogs.front().message,
+		    std::string("{\n  \"hello\": \"world\",\n  \"answer\": 7\n}"),
+		    "Pretty printing should follow the setting at render time"
+		);
+
+		logger.deinit();
+	}
+}
+
 } // namespace
 
 int main() {
@@ -249,6 +295,7 @@ int main() {
 		test_live_callback_receives_json_message();
 		test_sync_callback_receives_json_message();
 		test_printf_logging_still_works_in_json_build();
+		test_deferred_json_serializes_on_the_sync_path();
 	} catch (const std::exception &ex) {
 		std::cerr << "Test failure: " << ex.what() << '\n';
 		return 1;
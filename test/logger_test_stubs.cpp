@@ -4,16 +4,64 @@
 #include "test_support.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <new>
+#include <thread>
 
 namespace {
 struct FakeSemaphore {
+	bool binary = false;
 	std::mutex mutex;
+	std::mutex stateMutex;
+	std::condition_variable changed;
+	bool available = false;
+};
+
+// Tasks only run on real threads when a test opts in; otherwise creation just hands out
+// a handle and notifications accumulate in a global counter.
+struct FakeTask {
+	std::mutex mutex;
+	std::condition_variable notified;
+	uint32_t notifications = 0;
 };
 
 std::atomic<unsigned long> g_fakeMillis{0};
 std::atomic<TickType_t> g_fakeTicks{0};
+std::atomic<uint32_t> g_fakeNotifications{0};
+std::atomic<bool> g_runTasks{false};
+std::atomic<int> g_liveTasks{0};
+std::atomic<int> g_failTaskCreates{0};
+std::mutex g_tasksMutex;
+std::list<std::unique_ptr<FakeTask>> g_tasks;
+thread_local FakeTask *t_currentTask = nullptr;
+
+FakeTask *findTask(TaskHandle_t handle) {
+	std::lock_guard<std::mutex> guard(g_tasksMutex);
+	for (const auto &task : g_tasks) {
+		if (task.get() == handle) {
+			return task.get();
+		}
+	}
+	return nullptr;
+}
+
+template <typename Predicate>
+bool waitFor(
+    std::condition_variable &cv,
+    std::unique_lock<std::mutex> &lock,
+    TickType_t ticks,
+    Predicate ready
+) {
+	if (ticks == portMAX_DELAY) {
+		cv.wait(lock, ready);
+		return true;
+	}
+	return cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
 
 } // namespace
 
@@ -21,16 +69,47 @@ extern "C" unsigned long millis(void) {
 	return g_fakeMillis.fetch_add(1) + 1;
 }
 
+extern "C" unsigned long micros(void) {
+	// Real elapsed time so lock-hold statistics and benchmarks measure actual work.
+	static const auto start = std::chrono::steady_clock::now();
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<unsigned long>(
+	    std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+	);
+}
+
 extern "C" SemaphoreHandle_t xSemaphoreCreateMutex(void) {
 	return reinterpret_cast<SemaphoreHandle_t>(new (std::nothrow) FakeSemaphore{});
 }
 
-extern "C" BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t /*ticks*/) {
+extern "C" SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+	auto *sem = new (std::nothrow) FakeSemaphore{};
+	if (sem != nullptr) {
+		sem->binary = true;
+	}
+	return reinterpret_cast<SemaphoreHandle_t>(sem);
+}
+
+extern "C" BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks) {
 	if (handle == nullptr) {
 		return pdFAIL;
 	}
 	auto *sem = reinterpret_cast<FakeSemaphore *>(handle);
-	sem->mutex.lock();
+	if (!sem->binary) {
+		sem->mutex.lock();
+		return pdPASS;
+	}
+
+	std::unique_lock<std::mutex> lock(sem->stateMutex);
+	if (!sem->available && g_liveTasks.load() == 0) {
+		// No running task could ever give it: simulate the timeout instead of sleeping.
+		g_fakeTicks.fetch_add(ticks);
+		return pdFAIL;
+	}
+	if (!waitFor(sem->changed, lock, ticks, [sem] { return sem->available; })) {
+		return pdFAIL;
+	}
+	sem->available = false;
 	return pdPASS;
 }
 
@@ -39,7 +118,15 @@ extern "C" BaseType_t xSemaphoreGive(SemaphoreHandle_t handle) {
 		return pdFAIL;
 	}
 	auto *sem = reinterpret_cast<FakeSemaphore *>(handle);
-	sem->mutex.unlock();
+	if (!sem->binary) {
+		sem->mutex.unlock();
+		return pdPASS;
+	}
+
+	// Notify while holding the lock: the taker may delete the semaphore right after waking.
+	std::lock_guard<std::mutex> guard(sem->stateMutex);
+	sem->available = true;
+	sem->changed.notify_all();
 	return pdPASS;
 }
 
@@ -52,14 +139,37 @@ extern "C" BaseType_t xTaskCreatePinnedToCore(
     TaskFunction_t task,
     const char * /*name*/,
     uint32_t /*stackDepth*/,
-    void * /*parameters*/,
+    void *parameters,
     UBaseType_t /*priority*/,
     TaskHandle_t *createdTask,
     BaseType_t /*coreId*/
 ) {
+	if (g_failTaskCreates.load() > 0) {
+		g_failTaskCreates.fetch_sub(1);
+		return pdFAIL;
+	}
+	if (!g_runTasks.load()) {
+		if (createdTask != nullptr) {
+			*createdTask = reinterpret_cast<TaskHandle_t>(task);
+		}
+		return pdPASS;
+	}
+
+	FakeTask *fake = nullptr;
+	{
+		std::lock_guard<std::mutex> guard(g_tasksMutex);
+		g_tasks.emplace_back(new FakeTask{});
+		fake = g_tasks.back().get();
+	}
 	if (createdTask != nullptr) {
-		*createdTask = reinterpret_cast<TaskHandle_t>(task);
+		*createdTask = reinterpret_cast<TaskHandle_t>(fake);
 	}
+	g_liveTasks.fetch_add(1);
+	std::thread([task, parameters, fake] {
+		t_currentTask = fake;
+		task(parameters);
+		g_liveTasks.fetch_sub(1);
+	}).detach();
 	return pdPASS;
 }
 
@@ -70,15 +180,71 @@ extern "C" void vTaskDelay(TickType_t ticks) {
 	g_fakeTicks.fetch_add(ticks);
 }
 
+extern "C" void vTaskPrioritySet(TaskHandle_t /*task*/, UBaseType_t /*priority*/) {
+}
+
 extern "C" TickType_t xTaskGetTickCount(void) {
 	return g_fakeTicks.load();
 }
 
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	return reinterpret_cast<TaskHandle_t>(t_currentTask);
+}
+
+extern "C" BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+	FakeTask *fake = findTask(task);
+	if (fake == nullptr) {
+		g_fakeNotifications.fetch_add(1);
+		return pdPASS;
+	}
+	{
+		std::lock_guard<std::mutex> guard(fake->mutex);
+		++fake->notifications;
+	}
+	fake->notified.notify_all();
+	return pdPASS;
+}
+
+extern "C" uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+	if (t_currentTask != nullptr) {
+		FakeTask *fake = t_currentTask;
+		std::unique_lock<std::mutex> lock(fake->mutex);
+		waitFor(fake->notified, lock, ticksToWait, [fake] { return fake->notifications > 0; });
+		const uint32_t pending = fake->notifications;
+		fake->notifications = clearCountOnExit == pdTRUE ? 0 : pending;
+		return pending;
+	}
+
+	const uint32_t pending = clearCountOnExit == pdTRUE ? g_fakeNotifications.exchange(0)
+	                                                    : g_fakeNotifications.load();
+	if (pending == 0) {
+		g_fakeTicks.fetch_add(ticksToWait);
+	}
+	return pending;
+}
+
 namespace test_support {
 
 void resetMillis(unsigned long start) {
 	g_fakeMillis.store(start);
 	g_fakeTicks.store(static_cast<TickType_t>(start));
+	g_fakeNotifications.store(0);
+}
+
+uint32_t pendingNotifications() {
+	return g_fakeNotifications.load();
+}
+
+void setRunTasks(bool runTasks) {
+	g_runTasks.store(runTasks);
+}
+
+int liveTasks() {
+	return g_liveTasks.load();
+}
+
+void failTaskCreates(int count) {
+	g_failTaskCreates.store(count);
 }
 
 } // namespace test_support
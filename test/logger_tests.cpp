@@ -1,12 +1,28 @@
 #include "esp_logger/logger.h"
+#include "esp_logger/logger_compress.h"
+#include "esp_logger/logger_format.h"
+#include "esp_logger/logger_spill.h"
+#include "esp_logger/logger_store.h"
+#include "esp_logger/logger_stream.h"
+#include "esp_logger/logger_tags.h"
 #include "test_support.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdarg>
+#include <cstdio>
 #include <deque>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 namespace {
@@ -508,10 +524,10 @@ void test_get_logs_by_level() {
 
 void test_static_helpers_on_snapshot() {
 	std::vector<Log> snapshot = {
-	    {LogLevel::Debug, "TAG", 1, 1, "a"},
-	    {LogLevel::Info, "TAG", 2, 2, "b"},
-	    {LogLevel::Warn, "TAG", 3, 3, "c"},
-	    {LogLevel::Info, "TAG", 4, 4, "d"},
+	    {LogLevel::Debug, "TAG", 1, 1, "a", {}, false},
+	    {LogLevel::Info, "TAG", 2, 2, "b", {}, false},
+	    {LogLevel::Warn, "TAG", 3, 3, "c", {}, false},
+	    {LogLevel::Info, "TAG", 4, 4, "d", {}, false},
 	};
 
 	expect_equal(
@@ -565,6 +581,2098 @@ void test_destructor_calls_deinit_and_flushes_pending_logs() {
 	);
 }
 
+void test_formats_short_and_oversized_messages() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 4;
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize");
+	}
+
+	const std::string boundary(logger_format_detail::kScratchSize - 1, 'b');
+	const std::string oversized(logger_format_detail::kScratchSize * 3, 'o');
+
+	logger.info("FMT", "value=%d", 42);
+	logger.info("FMT", "%s", boundary.c_str());
+	logger.info("FMT", "%s|%d", oversized.c_str(), 7);
+
+	const auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(3), "All formatted messages should be stored");
+	expect_equal(logs[0].message, std::string("value=42"), "Short message mismatch");
+	expect_equal(logs[1].message, boundary, "Message filling the scratch buffer mismatch");
+	expect_equal(
+	    logs[2].message,
+	    oversized + "|7",
+	    "Oversized message should fall back to a measured allocation"
+	);
+
+	logger.deinit();
+}
+
+void test_lock_free_ring_keeps_newest_entries() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 3;
+	config.consoleLogLevel = LogLevel::Error;
+	config.useLockFreeRing = true;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with the lock-free ring");
+	}
+
+	for (int index = 0; index < 6; ++index) {
+		logger.info("RING", "entry %d", index);
+	}
+
+	const auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(3), "Ring mode should honor maxLogInRam");
+	expect_equal(logs.front().message, std::string("entry 3"), "Ring mode should drop oldest");
+	expect_equal(logs.back().message, std::string("entry 5"), "Ring mode newest entry mismatch");
+
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &batch) { synced = batch; });
+	logger.warn("RING", "after query");
+	logger.sync();
+
+	// Two entries evicted in the ring and two in the buffer are announced first.
+	expect_equal(synced.size(), static_cast<size_t>(4), "Ring sync should drain RAM buffer");
+	expect_equal(synced.front().tag, std::string(ESPLogger::kDropNoticeTag), "Drop notice");
+	expect_equal(synced.front().message, std::string("4 entries dropped (info 4)"), "Drops");
+	expect_equal(synced.back().message, std::string("after query"), "Ring sync order mismatch");
+	expect_true(logger.getAllLogs().empty(), "Ring sync should leave the buffer empty");
+
+	logger.deinit();
+}
+
+void test_lock_free_ring_accepts_concurrent_producers() {
+	test_support::resetMillis();
+
+	constexpr int kProducers = 4;
+	constexpr int kPerProducer = 250;
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = kProducers * kPerProducer;
+	config.consoleLogLevel = LogLevel::Error;
+	config.useLockFreeRing = true;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with the lock-free ring");
+	}
+
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &batch) {
+		synced.insert(synced.end(), batch.begin(), batch.end());
+	});
+
+	std::vector<std::thread> producers;
+	for (int producer = 0; producer < kProducers; ++producer) {
+		producers.emplace_back([&logger, producer]() {
+			for (int index = 0; index < kPerProducer; ++index) {
+				logger.info("MPSC", "%d:%d", producer, index);
+			}
+		});
+	}
+	for (int round = 0; round < 20; ++round) {
+		logger.sync();
+	}
+	for (auto &thread : producers) {
+		thread.join();
+	}
+	logger.sync();
+
+	expect_equal(
+	    synced.size(),
+	    static_cast<size_t>(kProducers * kPerProducer),
+	    "Every concurrently produced entry should be synced exactly once"
+	);
+
+	std::vector<int> nextExpected(kProducers, 0);
+	for (const auto &entry : synced) {
+		int producer = -1;
+		int index = -1;
+		std::istringstream stream(entry.message);
+		char separator = 0;
+		stream >> producer >> separator >> index;
+		expect_true(producer >= 0 && producer < kProducers, "Unexpected producer id in message");
+		expect_equal(index, nextExpected[producer], "Per-producer order should be preserved");
+		++nextExpected[producer];
+	}
+
+	logger.deinit();
+}
+
+std::string formatDirect(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+std::string formatDirect(const char *fmt, ...) {
+	char buffer[256];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+	return buffer;
+}
+
+void test_deferred_formatting_matches_immediate_output() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 16;
+	config.consoleLogLevel = LogLevel::Error;
+	config.deferFormatting = true;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with deferred formatting");
+	}
+
+	char transient[16] = "volatile";
+	const long long big = -1234567890123LL;
+	const size_t size = 42;
+	const char partial[3] = {'a', 'b', 'c'};
+	// Read through a volatile so the compiler cannot see the null at the call site; the
+	// deferred packer substitutes "(null)" without handing the pointer to printf.
+	const char *volatile missing = nullptr;
+
+	logger.info("DEFER", "int=%d hex=%#06x char=%c pct=%%", -17, 0xbeef, 'z');
+	logger.info("DEFER", "ll=%lld zu=%zu f=%.3f e=%g", big, size, 3.14159, 1e-7);
+	logger.info("DEFER", "str=%s width=[%*d] prec=[%.*s]", transient, 6, 99, 2, partial);
+	logger.info("DEFER", "null=%s tail", missing);
+	std::snprintf(transient, sizeof(transient), "%s", "clobbered");
+
+	const std::vector<std::string> expected = {
+	    formatDirect("int=%d hex=%#06x char=%c pct=%%", -17, 0xbeef, 'z'),
+	    formatDirect("ll=%lld zu=%zu f=%.3f e=%g", big, size, 3.14159, 1e-7),
+	    formatDirect("str=%s width=[%*d] prec=[%.*s]", "volatile", 6, 99, 2, partial),
+	    std::string("null=(null) tail"),
+	};
+
+	const auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), expected.size(), "Deferred records should be buffered");
+	for (size_t index = 0; index < expected.size(); ++index) {
+		expect_equal(logs[index].message, expected[index], "Deferred rendering mismatch");
+		expect_equal(logs[index].tag, std::string("DEFER"), "Deferred tag mismatch");
+	}
+
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &batch) { synced = batch; });
+	logger.sync();
+	expect_equal(synced.size(), expected.size(), "Deferred records should be synced");
+	expect_equal(synced[2].message, expected[2], "Sync should render deferred records");
+
+	logger.deinit();
+}
+
+void test_deferred_formatting_renders_for_live_callback() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 4;
+	config.consoleLogLevel = LogLevel::Error;
+	config.deferFormatting = true;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with deferred formatting");
+	}
+
+	std::vector<Log> live;
+	logger.attach([&live](const Log &entry) { live.push_back(entry); });
+	logger.warn("LIVE", "reading=%d unit=%s", 512, "mV");
+	logger.warn("LIVE", "wide=%ls", L"skipped");
+
+	expect_equal(live.size(), static_cast<size_t>(2), "Live callback should see deferred logs");
+	expect_equal(
+	    live.front().message,
+	    std::string("reading=512 unit=mV"),
+	    "Live callback should receive rendered text"
+	);
+	expect_equal(
+	    logger.getAllLogs().back().message,
+	    formatDirect("wide=%ls", L"skipped"),
+	    "Unsupported conversions should fall back to immediate formatting"
+	);
+
+	logger.deinit();
+}
+
+void test_level_queue_keeps_arrival_order_across_levels() {
+	using Queue = LogLevelQueue<LogRecord, kLogLevelCount>;
+	const auto messages = [](const Queue &queue) {
+		std::string joined;
+		queue.forEach([&joined](const LogRecord &record) { joined += record.payload; });
+		return joined;
+	};
+
+	Queue queue{LoggerAllocator<LogRecord>(false)};
+	const LogLevel levels[] = {LogLevel::Info, LogLevel::Debug, LogLevel::Error,
+	                           LogLevel::Debug, LogLevel::Info, LogLevel::Warn};
+	for (size_t index = 0; index < 6; ++index) {
+		LogRecord record;
+		record.level = levels[index];
+		record.payload = std::string(1, static_cast<char>('a' + index));
+		queue.push_back(std::move(record));
+	}
+	expect_equal(queue.size(), static_cast<size_t>(6), "Every record is counted");
+	expect_equal(queue.count(0), static_cast<size_t>(2), "Records are counted per level");
+	expect_equal(messages(queue), std::string("abcdef"), "forEach merges levels by arrival");
+
+	expect_equal(queue.front(0).payload, std::string("b"), "Oldest record of one level");
+	queue.pop_front(0);
+	queue.pop_front(1);
+	expect_equal(messages(queue), std::string("cdef"), "Per-level pops keep the rest in order");
+	expect_equal(queue.front().payload, std::string("c"), "Oldest record overall");
+	queue.pop_front();
+	expect_equal(messages(queue), std::string("def"), "Oldest pop follows arrival order");
+
+	Queue other{LoggerAllocator<LogRecord>(false)};
+	queue.swap(other);
+	expect_true(queue.empty(), "Swapped-out queue is empty");
+	expect_equal(messages(other), std::string("def"), "Swap moves every level");
+	other.clear();
+	expect_equal(other.size(), static_cast<size_t>(0), "Clear empties every level");
+}
+
+void test_arena_keeps_a_contiguous_newest_suffix() {
+	LogArena arena(512, false);
+	expect_true(arena.valid(), "Arena should allocate its region");
+
+	std::vector<std::string> pushed;
+	unsigned seed = 12345;
+	for (int index = 0; index < 500; ++index) {
+		seed = seed * 1103515245u + 12345u;
+		const size_t length = (seed >> 16) % 90;
+		std::string payload = std::to_string(index) + ":" + std::string(length, 'p');
+		pushed.push_back(payload);
+
+		ArenaRecordView record;
+		record.level = static_cast<LogLevel>(index % 4);
+		record.millis = static_cast<uint32_t>(index);
+		record.tag = "ARENA";
+		record.tagLength = 5;
+		record.payload = payload.data();
+		record.payloadLength = payload.size();
+		expect_true(arena.append(record) >= 0, "Record smaller than the arena should fit");
+		expect_true(arena.usedBytes() <= arena.capacityBytes(), "Arena must stay within budget");
+
+		std::vector<std::string> stored;
+		arena.forEach([&stored](const ArenaRecordView &view) {
+			stored.emplace_back(view.payload, view.payloadLength);
+		});
+		expect_equal(stored.size(), arena.count(), "forEach should visit every record");
+		expect_true(!stored.empty(), "Newest record should always be retained");
+		const size_t firstIndex = pushed.size() - stored.size();
+		for (size_t offset = 0; offset < stored.size(); ++offset) {
+			expect_equal(
+			    stored[offset],
+			    pushed[firstIndex + offset],
+			    "Arena should hold the newest records in order"
+			);
+		}
+	}
+}
+
+void test_byte_budget_storage_evicts_oldest_by_bytes() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogBytes = 960; // Two regions of 480 bytes
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with a byte budget");
+	}
+
+	for (int index = 0; index < 8; ++index) {
+		logger.info("BYTES", "short %d", index);
+	}
+	const size_t shortCount = logger.getAllLogs().size();
+	expect_true(shortCount > 1, "Several short records should share the arena");
+
+	const std::string wide(120, 'w');
+	logger.warn("BYTES", "%s", wide.c_str());
+	logger.warn("BYTES", "%s", wide.c_str());
+
+	const auto logs = logger.getAllLogs();
+	expect_true(logs.size() < shortCount, "Long records should evict more of the oldest entries");
+	expect_equal(logs.back().message, wide, "Newest long record should be retained intact");
+	expect_equal(logger.getLogCount(LogLevel::Warn), 2, "Both long records should fit the budget");
+
+	const std::string huge(1024, 'h');
+	logger.error("BYTES", "%s", huge.c_str());
+	const auto last = logger.getLastLogs(1);
+	expect_equal(last.size(), static_cast<size_t>(1), "Oversized record should still be kept");
+	expect_true(
+	    last.front().message.size() < huge.size() && last.front().message.size() > 0,
+	    "Oversized record should be truncated to the arena size"
+	);
+
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &batch) { synced = batch; });
+	logger.sync();
+	// The evictions are announced ahead of the surviving record.
+	expect_equal(synced.size(), static_cast<size_t>(2), "Sync should drain the arena");
+	expect_equal(synced.front().tag, std::string(ESPLogger::kDropNoticeTag), "Drop notice");
+	expect_equal(
+	    synced.back().tag,
+	    std::string("BYTES"),
+	    "Arena records should resolve their interned tag"
+	);
+	expect_true(logger.getAllLogs().empty(), "Arena should be empty after sync");
+
+	logger.deinit();
+}
+
+
+void test_tag_registry_interns_by_pointer_and_content() {
+	LogTagRegistry registry(3);
+	expect_true(registry.valid(), "Tag registry should allocate its tables");
+
+	const uint16_t wifi = registry.intern("WIFI");
+	expect_equal(registry.intern("WIFI"), wifi, "Same tag should intern to the same id");
+
+	char buffer[8] = "WIFI";
+	expect_equal(registry.intern(buffer), wifi, "Equal text at another address should match");
+	std::snprintf(buffer, sizeof(buffer), "MQTT");
+	const uint16_t mqtt = registry.intern(buffer);
+	expect_true(mqtt != wifi, "A reused buffer with new text must not hit the pointer cache");
+	expect_equal(registry.name(mqtt), std::string("MQTT"), "Name should resolve from the id");
+	expect_equal(registry.find("MQTT"), mqtt, "find should locate registered tags");
+	expect_equal(registry.find("HTTP"), LogTagRegistry::kOverflowId, "find must not register");
+
+	registry.intern("");
+	expect_equal(registry.size(), static_cast<size_t>(3), "Registry should count distinct tags");
+	const uint16_t overflow = registry.intern("HTTP");
+	expect_equal(overflow, LogTagRegistry::kOverflowId, "Tags past capacity should overflow");
+	expect_equal(
+	    registry.name(overflow),
+	    std::string(LogTagRegistry::kOverflowName),
+	    "Overflow id should resolve to the overflow name"
+	);
+}
+
+void test_interned_tags_survive_every_storage_mode() {
+	test_support::resetMillis();
+
+	for (int mode = 0; mode < 3; ++mode) {
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.consoleLogLevel = LogLevel::Error;
+		config.maxTags = 2;
+		config.useLockFreeRing = mode == 1;
+		config.maxLogBytes = mode == 2 ? 1024 : 0;
+
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize for the tag test");
+		}
+
+		std::string dynamicTag = "NET";
+		logger.info("WIFI", "up");
+		logger.info(dynamicTag.c_str(), "connected");
+		logger.info("OTHER", "past the tag budget");
+		logger.info("MORE", "also past the tag budget");
+
+		const auto logs = logger.getAllLogs();
+		expect_equal(logs.size(), static_cast<size_t>(4), "All entries should be stored");
+		expect_equal(logs[0].tag, std::string("WIFI"), "Tag should resolve from its id");
+		expect_equal(logs[1].tag, std::string("NET"), "Heap tags should be interned by text");
+		expect_equal(logs[2].tag, std::string("OTHER"), "Tags past maxTags should be kept inline");
+		expect_equal(logs[3].tag, std::string("MORE"), "Each overflowing tag keeps its own text");
+
+		logger.deinit();
+	}
+}
+
+void test_sync_view_callback_receives_drained_batch() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 1000;
+	config.usePSRAMBuffers = true;
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the view callback test");
+	}
+
+	bool legacyCalled = false;
+	logger.onSync([&legacyCalled](const std::vector<Log> &) { legacyCalled = true; });
+
+	size_t batchSize = 0;
+	int warnCount = 0;
+	bool ordered = true;
+	logger.onSync([&](LogBatchView logs) {
+		batchSize = logs.size();
+		warnCount = ESPLogger::getLogCount(logs, LogLevel::Warn);
+		for (size_t index = 0; index < logs.size(); ++index) {
+			ordered = ordered && logs[index].message == "entry " + std::to_string(index);
+		}
+	});
+
+	for (int index = 0; index < 1000; ++index) {
+		if (index % 10 == 0) {
+			logger.warn("VIEW", "entry %d", index);
+		} else {
+			logger.info("VIEW", "entry %d", index);
+		}
+	}
+	logger.sync();
+
+	expect_true(!legacyCalled, "Registering a view callback should replace the vector callback");
+	expect_equal(batchSize, static_cast<size_t>(1000), "View should cover the whole batch");
+	expect_equal(warnCount, 100, "Static helpers should work on the view");
+	expect_true(ordered, "View should expose entries in arrival order");
+	expect_true(logger.getAllLogs().empty(), "Buffer should be empty after the view sync");
+
+	logger.deinit();
+}
+
+void test_sync_retires_buffer_and_reports_stats() {
+	test_support::resetMillis();
+
+	for (int mode = 0; mode < 2; ++mode) {
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.maxLogInRam = 500;
+		config.maxLogBytes = mode == 1 ? 64 * 1024 : 0;
+		config.consoleLogLevel = LogLevel::Error;
+
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize for the stats test");
+		}
+		expect_equal(logger.getStats().syncCount, 0u, "No sync should be counted after init");
+
+		std::vector<std::string> batches;
+		logger.onSync([&logger, &batches](const std::vector<Log> &logs) {
+			batches.push_back(logs.empty() ? std::string() : logs.front().message);
+			// Producers can log while the retired batch is being processed.
+			logger.info("STATS", "logged during sync");
+		});
+
+		for (int index = 0; index < 300; ++index) {
+			logger.info("STATS", "entry %d", index);
+		}
+		logger.sync();
+
+		LoggerStats stats = logger.getStats();
+		expect_equal(stats.syncCount, 1u, "Sync should be counted");
+		expect_equal(stats.lastSyncBatchSize, 300u, "Batch size should cover the drained entries");
+		expect_true(
+		    stats.maxSyncLockHoldMicros >= stats.lastSyncLockHoldMicros,
+		    "Max lock hold should track the largest flush"
+		);
+		expect_equal(logger.getLogCount(LogLevel::Info), 1, "Entry logged during sync is kept");
+
+		logger.sync();
+		stats = logger.getStats();
+		expect_equal(stats.syncCount, 2u, "Second sync should be counted");
+		expect_equal(stats.lastSyncBatchSize, 1u, "Second batch holds the entry from the callback");
+		expect_equal(batches.size(), static_cast<size_t>(2), "Both flushes should reach onSync");
+		expect_equal(batches[1], std::string("logged during sync"), "Batches stay in order");
+
+		logger.deinit();
+		expect_equal(logger.getStats().syncCount, 0u, "deinit should reset the stats");
+	}
+}
+
+void test_watermark_and_severity_wake_the_sync_task() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.maxLogInRam = 10;
+	config.syncWatermarkPercent = 50;
+	config.syncTriggerLevel = LogLevel::Error;
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the trigger test");
+	}
+
+	for (int index = 0; index < 4; ++index) {
+		logger.info("WAKE", "below watermark %d", index);
+	}
+	expect_equal(logger.getStats().syncTriggerCount, 0u, "Below the watermark nothing wakes");
+	expect_equal(test_support::pendingNotifications(), 0u, "No notification should be sent");
+
+	logger.info("WAKE", "at watermark");
+	expect_equal(logger.getStats().syncTriggerCount, 1u, "Crossing the watermark should wake");
+	expect_equal(test_support::pendingNotifications(), 1u, "Sync task should be notified");
+
+	logger.info("WAKE", "still pending");
+	logger.error("WAKE", "error while a wake-up is pending");
+	expect_equal(logger.getStats().syncTriggerCount, 1u, "Pending wake-ups are not repeated");
+
+	logger.sync();
+	logger.error("WAKE", "error after sync");
+	expect_equal(logger.getStats().syncTriggerCount, 2u, "Severity trigger should re-arm");
+	logger.deinit();
+
+	config.syncWatermarkPercent = 0;
+	config.enableSyncTask = false;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to reinitialize without a sync task");
+	}
+	for (int index = 0; index < 20; ++index) {
+		logger.error("WAKE", "no task %d", index);
+	}
+	expect_equal(logger.getStats().syncTriggerCount, 0u, "Without a sync task nothing wakes");
+	logger.deinit();
+}
+
+void test_running_sync_task_flushes_on_trigger_and_stops_promptly() {
+	test_support::resetMillis();
+	test_support::setRunTasks(true);
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.syncIntervalMS = 60000;
+	config.shutdownTimeoutMS = 5000;
+	config.consoleLogLevel = LogLevel::Error;
+	config.syncTriggerLevel = LogLevel::Error;
+
+	for (int cycle = 0; cycle < 3; ++cycle) {
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize with a running sync task");
+		}
+
+		std::atomic<int> synced{0};
+		logger.onSync([&synced](const std::vector<Log> &logs) {
+			synced.fetch_add(static_cast<int>(logs.size()));
+		});
+
+		logger.info("TASK", "buffered until a trigger");
+		logger.error("TASK", "wakes the sync task");
+		const auto waitStart = std::chrono::steady_clock::now();
+		while (synced.load() < 2 &&
+		       std::chrono::steady_clock::now() - waitStart < std::chrono::seconds(5)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		expect_equal(synced.load(), 2, "Error entry should flush without waiting for the interval");
+
+		logger.info("TASK", "flushed by deinit");
+		const auto stopStart = std::chrono::steady_clock::now();
+		logger.deinit();
+		const auto stopElapsed = std::chrono::steady_clock::now() - stopStart;
+		expect_true(
+		    stopElapsed < std::chrono::seconds(1),
+		    "deinit should wake the idle sync task instead of waiting out the interval"
+		);
+		expect_equal(synced.load(), 3, "deinit should flush the remaining entry");
+	}
+
+	test_support::setRunTasks(false);
+}
+
+void test_deinit_abandons_a_task_blocked_in_on_sync() {
+	test_support::resetMillis();
+	test_support::setRunTasks(true);
+
+	// The logger has to outlive the abandoned task, which finishes its flush later.
+	std::atomic<bool> entered{false};
+	std::atomic<bool> release{false};
+	std::atomic<int> synced{0};
+	ESPLogger logger;
+	LoggerConfig config;
+	config.syncIntervalMS = 60000;
+	config.shutdownTimeoutMS = 20;
+	config.consoleLogLevel = LogLevel::Error;
+	config.syncTriggerLevel = LogLevel::Error;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with a running sync task");
+	}
+	logger.onSync([&](const std::vector<Log> &logs) {
+		synced.fetch_add(static_cast<int>(logs.size()));
+		entered.store(true);
+		while (!release.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	logger.error("TASK", "blocks the handler");
+	const auto waitStart = std::chrono::steady_clock::now();
+	while (!entered.load() &&
+	       std::chrono::steady_clock::now() - waitStart < std::chrono::seconds(5)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	expect_true(entered.load(), "The sync task should be inside the handler");
+
+	logger.info("TASK", "dropped at shutdown");
+	const auto stopStart = std::chrono::steady_clock::now();
+	logger.deinit();
+	expect_true(
+	    std::chrono::steady_clock::now() - stopStart < std::chrono::seconds(2),
+	    "deinit should return after the deadline instead of hanging"
+	);
+	expect_true(!logger.isInitialized(), "deinit should complete");
+
+	// A new task starts even though the old one still holds its (leaked) sync mutex.
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to re-initialize after abandoning a task");
+	}
+	std::atomic<int> resynced{0};
+	logger.onSync([&resynced](const std::vector<Log> &logs) {
+		resynced.fetch_add(static_cast<int>(logs.size()));
+	});
+	release.store(true);
+	logger.error("TASK", "new task flushes");
+	const auto resyncStart = std::chrono::steady_clock::now();
+	while (resynced.load() < 1 &&
+	       std::chrono::steady_clock::now() - resyncStart < std::chrono::seconds(5)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	expect_equal(resynced.load(), 1, "The new sync task should flush");
+	expect_equal(synced.load(), 1, "The abandoned flush delivered only its own batch");
+	logger.deinit();
+	const auto exitStart = std::chrono::steady_clock::now();
+	while (test_support::liveTasks() > 0 &&
+	       std::chrono::steady_clock::now() - exitStart < std::chrono::seconds(5)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	expect_equal(test_support::liveTasks(), 0, "The abandoned task should exit on its own");
+	test_support::setRunTasks(false);
+}
+
+void test_abandoned_task_never_touches_a_destroyed_logger() {
+	test_support::setRunTasks(true);
+	alignas(4) static uint8_t retained[2048];
+	uint8_t snapshot[sizeof(retained)];
+
+	// Where the first handler call blocks: the buffered batch, the previous boot's replay or
+	// the first spilled batch.
+	for (int point = 0; point < 3; ++point) {
+		test_support::resetMillis();
+		LoggerConfig config;
+		config.syncIntervalMS = 60000;
+		config.shutdownTimeoutMS = 20;
+		config.consoleLogLevel = LogLevel::Error;
+		config.syncTriggerLevel = LogLevel::Warn;
+		config.maxLogInRam = 4;
+		if (point == 1) {
+			// Leave one unsynced entry behind, as a reset would.
+			std::memset(retained, 0xA5, sizeof(retained));
+			config.retainedBuffer = retained;
+			config.retainedBufferSize = sizeof(retained);
+			config.enableSyncTask = false;
+			{
+				ESPLogger previous;
+				if (!previous.init(config)) {
+					fail("ESPLogger failed to initialize the previous boot");
+				}
+				previous.info("BOOT", "left behind");
+				std::memcpy(snapshot, retained, sizeof(retained));
+			}
+			std::memcpy(retained, snapshot, sizeof(retained));
+			config.enableSyncTask = true;
+		}
+
+		LogMemorySpill spill(4096, false);
+		std::atomic<bool> entered{false};
+		std::atomic<bool> release{false};
+		std::atomic<int> calls{0};
+		std::unique_ptr<ESPLogger> logger(new ESPLogger());
+		if (!logger->init(config)) {
+			fail("ESPLogger failed to initialize with a running sync task");
+		}
+		if (point == 2) {
+			logger->setSpillStore(spill.store());
+		}
+		logger->onSync([&](const std::vector<Log> &) {
+			calls.fetch_add(1);
+			entered.store(true);
+			while (!release.load()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		});
+		for (int index = 0; index < (point == 2 ? 12 : 1); ++index) {
+			logger->info("TASK", "line %d", index);
+		}
+		logger->warn("TASK", "triggers a sync");
+		const auto waitStart = std::chrono::steady_clock::now();
+		while (!entered.load() &&
+		       std::chrono::steady_clock::now() - waitStart < std::chrono::seconds(5)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		expect_true(entered.load(), "The sync task should be inside the handler");
+
+		// Destroying the logger abandons the task; once released it must exit without
+		// touching the freed logger (AddressSanitizer builds catch any access).
+		logger.reset();
+		release.store(true);
+		const auto exitStart = std::chrono::steady_clock::now();
+		while (test_support::liveTasks() > 0 &&
+		       std::chrono::steady_clock::now() - exitStart < std::chrono::seconds(5)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		expect_equal(test_support::liveTasks(), 0, "The abandoned task should exit on its own");
+		expect_equal(calls.load(), 1, "An abandoned task should not call any further handler");
+	}
+	test_support::setRunTasks(false);
+}
+
+void test_reconfigure_applies_changes_in_place() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.maxLogInRam = 10;
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the reconfigure test");
+	}
+
+	int liveCount = 0;
+	int syncCount = 0;
+	logger.attach([&liveCount](const Log &) { ++liveCount; });
+	logger.onSync([&syncCount](const std::vector<Log> &) { ++syncCount; });
+
+	for (int index = 0; index < 10; ++index) {
+		logger.info("CFG", "entry %d", index);
+	}
+
+	config.maxLogInRam = 4;
+	config.consoleLogLevel = LogLevel::Warn;
+	config.usePrettyJson = false;
+	expect_true(logger.reconfigure(config), "Shrinking the buffer should apply in place");
+	auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(4), "Shrinking keeps maxLogInRam entries");
+	expect_equal(logs.front().message, std::string("entry 6"), "Shrinking keeps the newest");
+	expect_equal(syncCount, 0, "Reconfigure must not flush");
+	const size_t info = static_cast<size_t>(LogLevel::Info);
+	expect_equal(
+	    logger.getStats().droppedCount[info],
+	    static_cast<uint32_t>(6),
+	    "Entries evicted by shrinking count as dropped"
+	);
+	expect_true(logger.logLevel() == LogLevel::Warn, "Console level should update");
+	expect_true(!logger.currentConfig().usePrettyJson, "usePrettyJson should update");
+
+	config.maxLogInRam = 8;
+	expect_true(logger.reconfigure(config), "Growing the buffer should apply in place");
+	logger.info("CFG", "after grow");
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(5), "Entries survive growing");
+	expect_equal(liveCount, 11, "Live callback should stay attached");
+
+	// Shrinking honors the per-level reserves like an overflow does.
+	logger.error("CFG", "reserved %d", 1);
+	logger.error("CFG", "reserved %d", 2);
+	config.maxLogInRam = 3;
+	config.reservedPerLevel[static_cast<size_t>(LogLevel::Error)] = 2;
+	expect_true(logger.reconfigure(config), "Shrinking with reserves should apply in place");
+	expect_equal(logger.getLogCount(LogLevel::Error), 2, "Reserved entries survive shrinking");
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(3), "Shrunk to maxLogInRam");
+	expect_equal(
+	    logger.getStats().droppedCount[info],
+	    static_cast<uint32_t>(10),
+	    "Entries evicted for the reserves count as dropped"
+	);
+	config.reservedPerLevel[static_cast<size_t>(LogLevel::Error)] = 0;
+
+	LoggerConfig structural = config;
+	structural.useLockFreeRing = true;
+	expect_true(!logger.reconfigure(structural), "Storage layout changes need init()");
+	expect_true(!logger.currentConfig().useLockFreeRing, "Rejected changes are not applied");
+	logger.deinit();
+
+	LoggerConfig ring = config;
+	ring.useLockFreeRing = true;
+	if (!logger.init(ring)) {
+		fail("ESPLogger failed to initialize the ring for the reconfigure test");
+	}
+	ring.maxLogInRam = 16;
+	expect_true(!logger.reconfigure(ring), "The lock-free ring cannot be resized in place");
+	expect_equal(logger.currentConfig().maxLogInRam, config.maxLogInRam, "Ring size is kept");
+	logger.deinit();
+
+	config.maxLogBytes = 4096;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize the arena for the reconfigure test");
+	}
+	for (int index = 0; index < 40; ++index) {
+		logger.info("CFG", "arena entry %d", index);
+	}
+	config.maxLogBytes = 512;
+	expect_true(logger.reconfigure(config), "Arena resize should apply in place");
+	logs = logger.getAllLogs();
+	expect_true(!logs.empty() && logs.size() < 40, "Smaller arena should evict the oldest");
+	expect_equal(logs.back().message, std::string("arena entry 39"), "Newest entry survives");
+	expect_equal(logs.back().tag, std::string("CFG"), "Tags survive the arena copy");
+	expect_equal(
+	    logger.getStats().droppedCount[info],
+	    static_cast<uint32_t>(40 - logs.size()),
+	    "Entries the smaller arena cannot hold count as dropped"
+	);
+	logger.deinit();
+}
+
+void test_reconfigure_recreates_task_only_for_core_or_stack() {
+	test_support::resetMillis();
+	test_support::setRunTasks(true);
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.syncIntervalMS = 60000;
+	config.consoleLogLevel = LogLevel::Error;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with a running sync task");
+	}
+	std::atomic<int> synced{0};
+	logger.onSync([&synced](const std::vector<Log> &logs) {
+		synced.fetch_add(static_cast<int>(logs.size()));
+	});
+
+	auto waitForSynced = [&synced](int expected) {
+		const auto start = std::chrono::steady_clock::now();
+		while (synced.load() < expected &&
+		       std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return synced.load() == expected;
+	};
+
+	config.syncIntervalMS = 5;
+	config.priority = 3;
+	expect_true(logger.reconfigure(config), "Interval and priority should change in place");
+	logger.info("TASK", "flushed by the shorter interval");
+	expect_true(waitForSynced(1), "New interval should take effect without waiting out the old");
+
+	config.stackSize *= 2;
+	config.syncIntervalMS = 60000;
+	expect_true(logger.reconfigure(config), "Stack size change should recreate the task");
+	logger.error("TASK", "flushed by the recreated task");
+	expect_true(waitForSynced(2), "Recreated task should still respond to triggers");
+
+	LoggerConfig failing = config;
+	failing.coreId = 1;
+	failing.maxLogInRam = 7;
+	test_support::failTaskCreates(1);
+	expect_true(!logger.reconfigure(failing), "A task that cannot be created should fail");
+	expect_equal(
+	    logger.currentConfig().coreId,
+	    config.coreId,
+	    "A failed reconfigure should keep the previous task settings"
+	);
+	expect_true(logger.currentConfig().maxLogInRam != 7, "A failed reconfigure changes nothing");
+	logger.error("TASK", "flushed by the restored task");
+	expect_true(waitForSynced(3), "The previous task should be running again");
+
+	// When the previous task cannot be restarted either, the config stops claiming one.
+	test_support::failTaskCreates(2);
+	expect_true(!logger.reconfigure(failing), "Both task creations fail");
+	expect_true(!logger.currentConfig().enableSyncTask, "No task runs, and the config says so");
+	expect_true(logger.reconfigure(config), "A later reconfigure starts the task again");
+	logger.error("TASK", "flushed by the task started again");
+	expect_true(waitForSynced(4), "The task started again should flush");
+
+	config.enableSyncTask = false;
+	expect_true(logger.reconfigure(config), "Disabling the task should stop it");
+	logger.error("TASK", "stays buffered");
+	expect_equal(logger.getLogCount(LogLevel::Error), 1, "Without a task entries stay buffered");
+
+	logger.deinit();
+	test_support::setRunTasks(false);
+}
+
+int g_argumentEvaluations = 0;
+
+int countedArgument(int value) {
+	++g_argumentEvaluations;
+	return value;
+}
+
+int g_tagEvaluations = 0;
+
+const char *countedTag(const char *tag) {
+	++g_tagEvaluations;
+	return tag;
+}
+
+void test_capture_level_gates_before_formatting() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.captureLevel = LogLevel::Warn;
+
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the capture level test");
+	}
+
+	int liveCount = 0;
+	logger.attach([&liveCount](const Log &) { ++liveCount; });
+
+	expect_true(!logger.isLevelEnabled(LogLevel::Info), "Info should be below the capture level");
+	expect_true(logger.isLevelEnabled(LogLevel::Warn), "Warn should be captured");
+
+	logger.debug("GATE", "dropped %d", 1);
+	logger.info("GATE", "dropped %d", 2);
+	logger.warn("GATE", "kept %d", 3);
+	g_argumentEvaluations = 0;
+	ESPLOGGER_INFO(logger, "GATE", "dropped %d", countedArgument(4));
+	expect_equal(g_argumentEvaluations, 0, "Disabled macro calls should not evaluate arguments");
+	ESPLOGGER_ERROR(logger, "GATE", "kept %d", countedArgument(5));
+	expect_equal(g_argumentEvaluations, 1, "Enabled macro calls should evaluate arguments once");
+
+	auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(2), "Only captured levels should be stored");
+	expect_equal(logs.back().message, std::string("kept 5"), "Macro should log like the method");
+	expect_equal(liveCount, 2, "Dropped entries should not reach the live callback");
+
+	logger.setCaptureLevel(LogLevel::Debug);
+	expect_true(logger.currentConfig().captureLevel == LogLevel::Debug, "Config should follow");
+	ESPLOGGER_DEBUG(logger, "GATE", "now kept %d", countedArgument(6));
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(3), "Lowered level captures");
+
+	logger.deinit();
+	expect_true(logger.captureLevel() == LogLevel::Debug, "deinit should reset the capture level");
+}
+
+void test_tag_levels_override_the_capture_level() {
+	test_support::resetMillis();
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.captureLevel = LogLevel::Warn;
+	config.maxTags = 4;
+
+	expect_true(
+	    !logger.setTagLevel("WIFI", LogLevel::Debug),
+	    "Tag levels need an initialized logger"
+	);
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the tag level test");
+	}
+
+	expect_true(logger.setTagLevel("WIFI", LogLevel::Debug), "Tag level should be accepted");
+	expect_true(logger.setTagLevel("NOISY", LogLevel::Error), "Tags can also be raised");
+
+	char wifiCopy[] = "WIFI";
+	logger.debug(wifiCopy, "verbose wifi trace");
+	logger.info("MQTT", "info without override");
+	logger.warn("MQTT", "warn without override");
+	logger.warn("NOISY", "raised tag warn");
+	logger.error("NOISY", "raised tag error");
+	g_argumentEvaluations = 0;
+	ESPLOGGER_DEBUG(logger, "MQTT", "skipped %d", countedArgument(1));
+	ESPLOGGER_DEBUG(logger, "WIFI", "kept %d", countedArgument(2));
+	expect_equal(g_argumentEvaluations, 1, "Macros should apply tag levels before arguments");
+	g_tagEvaluations = 0;
+	ESPLOGGER_DEBUG(logger, countedTag("MQTT"), "skipped %d", countedArgument(3));
+	ESPLOGGER_WARN(logger, countedTag("MQTT"), "warn %d", countedArgument(4));
+	expect_equal(g_tagEvaluations, 2, "Macros should evaluate the tag once per call");
+	expect_equal(g_argumentEvaluations, 2, "Only the enabled call evaluates its arguments");
+
+	auto logs = logger.getAllLogs();
+	std::vector<std::string> messages;
+	for (const auto &entry : logs) {
+		messages.push_back(entry.tag + ":" + entry.message);
+	}
+	const std::vector<std::string> expected = {
+	    "WIFI:verbose wifi trace",
+	    "MQTT:warn without override",
+	    "NOISY:raised tag error",
+	    "WIFI:kept 2",
+	    "MQTT:warn 4",
+	};
+	expect_equal(messages.size(), expected.size(), "Tag levels should filter per tag");
+	for (size_t index = 0; index < expected.size(); ++index) {
+		expect_equal(messages[index], expected[index], "Unexpected entry after tag filtering");
+	}
+
+	logger.clearTagLevel("WIFI");
+	logger.debug("WIFI", "dropped again");
+	logger.clearTagLevels();
+	logger.warn("NOISY", "back to the capture level");
+	logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(6), "Cleared overrides follow captureLevel");
+	expect_equal(logs.back().message, std::string("back to the capture level"), "Warn is kept");
+
+	logger.setTagLevel("A", LogLevel::Debug);
+	logger.setTagLevel("B", LogLevel::Debug);
+	expect_true(!logger.setTagLevel("C", LogLevel::Debug), "Full tag table should reject tags");
+	logger.deinit();
+}
+
+void test_typed_format_writes_arguments_without_printf() {
+	using logger_fmt_detail::format;
+
+	expect_equal(
+	    format("temp={} rx={}", 21.37f, 42),
+	    std::string("temp=21.37 rx=42"),
+	    "Typed formatting should render floats and integers"
+	);
+	expect_equal(
+	    format("{} {} {} {}", -9223372036854775807LL - 1, UINT64_MAX, true, 'c'),
+	    std::string("-9223372036854775808 18446744073709551615 true c"),
+	    "Integer limits, bools and chars should render exactly"
+	);
+	expect_equal(
+	    format("{:x} {:X} {:.2} {:.0f} {:.3}", 255, 0xBEEFu, 3.14159, 2.5, -0.0005),
+	    std::string("ff BEEF 3.14 3 -0.001"),
+	    "Hex and precision specs should apply"
+	);
+	expect_equal(
+	    format("{} {} {} {}", 0.1 + 0.2, 1e20, 5e-6, 1.0 / 0.0),
+	    std::string("0.3 1e+20 5e-06 inf"),
+	    "Default floating point output should be short and switch to scientific"
+	);
+	const std::string ip = "10.0.0.7";
+	const char *missing = nullptr;
+	expect_equal(
+	    format("{{ip}}={} name={} {}", ip, "node", missing),
+	    std::string("{ip}=10.0.0.7 name=node (null)"),
+	    "Strings and escaped braces should render"
+	);
+	const std::string longText(300, 'x');
+	expect_equal(
+	    format("{}!", longText),
+	    longText + "!",
+	    "Messages beyond the scratch buffer should spill to the heap"
+	);
+
+	test_support::resetMillis();
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.captureLevel = LogLevel::Info;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the typed format test");
+	}
+
+	logger.info("NET", ESPLOGGER_FMT("rssi={} ip={}"), -61, ip);
+	g_argumentEvaluations = 0;
+	ESPLOGGER_DEBUG(logger, "NET", ESPLOGGER_FMT("dropped {}"), countedArgument(1));
+	expect_equal(g_argumentEvaluations, 0, "Disabled typed macro calls should not evaluate");
+	ESPLOGGER_WARN(logger, "NET", ESPLOGGER_FMT("retry {} of {}"), countedArgument(2), 3);
+	logger.error("NET", ESPLOGGER_FMT("plain"));
+
+	const auto logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(3), "Captured typed calls should be stored");
+	expect_equal(logs[0].message, std::string("rssi=-61 ip=10.0.0.7"), "Typed info message");
+	expect_equal(logs[1].message, std::string("retry 2 of 3"), "Typed macro message");
+	expect_true(logs[1].level == LogLevel::Warn, "Typed warn keeps its level");
+	expect_equal(logs[2].message, std::string("plain"), "Typed call without arguments");
+	logger.deinit();
+}
+
+void test_structured_fields_render_on_demand() {
+	test_support::resetMillis();
+
+	for (const size_t maxLogBytes : {static_cast<size_t>(0), static_cast<size_t>(2048)}) {
+		ESPLogger logger;
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.consoleLogLevel = LogLevel::Error;
+		config.captureLevel = LogLevel::Info;
+		config.maxLogBytes = maxLogBytes;
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize for the structured field test");
+		}
+
+		const std::string ip = "10.0.0.7";
+		logger.info("NET")
+		    .kv("rssi", -61)
+		    .kv("ip", ip)
+		    .kv("up", true)
+		    .kv("ratio", 0.25f)
+		    .kv("note", "two words")
+		    .kv("uptime", UINT64_MAX)
+		    .emit();
+		logger.debug("NET").kv("dropped", countedArgument(1)).emit();
+		logger.info("PLAIN", "printf %d", 7);
+
+		std::vector<Log> synced;
+		logger.onSync([&synced](const std::vector<Log> &logs) { synced = logs; });
+		logger.sync();
+
+		expect_equal(synced.size(), static_cast<size_t>(2), "Disabled builders should not store");
+		const Log &entry = synced[0];
+		expect_equal(
+		    entry.message,
+		    std::string("rssi=-61 ip=10.0.0.7 up=true ratio=0.25 note=\"two words\" "
+		                "uptime=18446744073709551615"),
+		    "Fields should render to text for the message"
+		);
+		expect_equal(
+		    logFieldsToJson(entry.fields),
+		    std::string("{\"rssi\":-61,\"ip\":\"10.0.0.7\",\"up\":true,\"ratio\":0.25,"
+		                "\"note\":\"two words\",\"uptime\":18446744073709551615}"),
+		    "Fields should render to JSON on request"
+		);
+		expect_true(synced[1].fields.empty(), "Plain entries carry no fields");
+
+		LogFieldReader reader(entry.fields);
+		LogField field;
+		expect_true(reader.next(field), "Reader should decode the first field");
+		expect_true(field.key == "rssi" && field.type == LogFieldType::Int, "Typed key");
+		expect_equal(field.intValue, static_cast<int64_t>(-61), "Typed integer value");
+		logger.deinit();
+	}
+}
+
+void test_binary_stream_round_trips_batches() {
+	test_support::resetMillis();
+
+	std::vector<Log> batch;
+	size_t textBytes = 0;
+	for (int index = 0; index < 40; ++index) {
+		Log entry;
+		entry.level = index % 10 == 0 ? LogLevel::Warn : LogLevel::Info;
+		entry.tag = index % 3 == 0 ? "NET" : "SENSOR";
+		entry.millis = 1000 + static_cast<uint32_t>(index) * 250;
+		entry.timestamp = 1700000000 + index / 4;
+		entry.message = "loop=" + std::to_string(index) + " temp=21." +
+		                std::to_string(index % 10) + " id=007";
+		textBytes += entry.tag.size() + entry.message.size() + 24;
+		batch.push_back(entry);
+	}
+	Log structured;
+	structured.level = LogLevel::Error;
+	structured.tag = "NET";
+	structured.millis = 500; // Clock wrap between entries must survive the delta
+	structured.timestamp = 1699999990;
+	logger_fields_detail::appendField(structured.fields, "rssi", logger_fmt_detail::makeArg(-61));
+	structured.message = logFieldsToText(structured.fields);
+	batch.push_back(structured);
+	Log raw;
+	raw.level = LogLevel::Debug;
+	raw.tag = "RAW";
+	raw.millis = 600;
+	raw.timestamp = 1699999990;
+	raw.message = std::string("ctrl \x01 byte") + '\x01';
+	batch.push_back(raw);
+
+	LogBinaryEncoder encoder(2, 8);
+	std::string bytes;
+	encoder.encodeBatch(batch, bytes);
+	expect_true(bytes.size() * 3 < textBytes, "Binary stream should be far smaller than text");
+
+	// Byte-by-byte feeding exercises every partial-entry boundary.
+	LogBinaryDecoder decoder;
+	std::vector<LogBinaryEntry> decoded;
+	for (const char byte : bytes) {
+		expect_true(decoder.feed(&byte, 1, decoded), "Decoder should accept every slice");
+	}
+	expect_true(!decoder.hasPending(), "Decoder should consume the whole stream");
+	expect_equal(decoded.size(), batch.size(), "Every entry should decode");
+	for (size_t index = 0; index < batch.size(); ++index) {
+		expect_equal(decoded[index].level, static_cast<uint8_t>(batch[index].level), "Level");
+		expect_equal(decoded[index].tag, batch[index].tag, "Tag");
+		expect_equal(decoded[index].millis, batch[index].millis, "Millis");
+		expect_equal(
+		    decoded[index].timestamp,
+		    static_cast<int64_t>(batch[index].timestamp),
+		    "Timestamp"
+		);
+		expect_equal(decoded[index].message, batch[index].message, "Message");
+		expect_equal(decoded[index].fields, batch[index].fields, "Fields");
+	}
+	expect_equal(
+	    logBinaryEntryToJson(decoded[40]),
+	    std::string("{\"level\":\"error\",\"tag\":\"NET\",\"millis\":500,"
+	                "\"timestamp\":1699999990,\"message\":\"rssi=-61\","
+	                "\"fields\":{\"rssi\":-61}}"),
+	    "Structured entries should render as NDJSON with nested fields"
+	);
+	expect_equal(
+	    logBinaryEntryToText(decoded[0]),
+	    std::string("[W] [NET] [1000][1700000000] loop=0 temp=21.0 id=007"),
+	    "Text rendering"
+	);
+
+	// A second stream appended to the same dump restarts the dictionaries.
+	LogBinaryEncoder second;
+	std::string more;
+	second.encode(batch[1], more);
+	decoded.clear();
+	expect_true(decoder.feed(more.data(), more.size(), decoded), "Concatenated stream");
+	expect_equal(decoded.size(), static_cast<size_t>(1), "Second stream entry");
+	expect_equal(decoded[0].message, batch[1].message, "Second stream message");
+
+	const char garbage[] = {static_cast<char>(0x84), 0x00};
+	LogBinaryDecoder fresh;
+	expect_true(!fresh.feed(garbage, sizeof(garbage), decoded), "Entries need a header");
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the binary sync test");
+	}
+	std::string dump;
+	logger.onSync(binarySyncCallback([&dump](const std::string &chunk) { dump += chunk; }));
+	logger.info("BIN", "value=%d", 1);
+	logger.sync();
+	logger.info("BIN", "value=%d", 2);
+	logger.sync();
+	logger.deinit();
+
+	decoded.clear();
+	LogBinaryDecoder syncDecoder;
+	expect_true(syncDecoder.feed(dump.data(), dump.size(), decoded), "Synced dump decodes");
+	expect_equal(decoded.size(), static_cast<size_t>(2), "Both syncs should be in the dump");
+	expect_equal(decoded[1].message, std::string("value=2"), "Dictionaries span batches");
+	expect_equal(decoded[1].tag, std::string("BIN"), "Tag ids span batches");
+}
+
+void test_batch_streamer_fills_fixed_chunks_and_resumes() {
+	std::vector<Log> batch;
+	for (int index = 0; index < 12; ++index) {
+		Log entry;
+		entry.level = LogLevel::Info;
+		entry.tag = "NET";
+		entry.millis = static_cast<uint32_t>(index);
+		entry.timestamp = 1700000000;
+		entry.message = "line \"" + std::to_string(index) + "\"\n";
+		batch.push_back(entry);
+	}
+	Log structured;
+	structured.level = LogLevel::Warn;
+	structured.tag = "T";
+	structured.millis = 1;
+	structured.timestamp = -2;
+	structured.message = "hi";
+	logger_fields_detail::appendField(structured.fields, "rssi", logger_fmt_detail::makeArg(-61));
+	batch.push_back(structured);
+
+	std::string expected;
+	for (const Log &entry : batch) {
+		expected += "{\"level\":\"";
+		expected += entry.level == LogLevel::Warn ? "warn" : "info";
+		expected += "\",\"tag\":\"" + entry.tag + "\",\"millis\":";
+		expected += std::to_string(entry.millis) + ",\"timestamp\":";
+		expected += std::to_string(entry.timestamp) + ",\"message\":";
+		if (entry.fields.empty()) {
+			expected += "\"line \\\"" + std::to_string(entry.millis) + "\\\"\\n\"}\n";
+		} else {
+			expected += "\"hi\",\"fields\":{\"rssi\":-61}}\n";
+		}
+	}
+
+	// A sink that refuses every third chunk: write() must stop and resume byte-exactly.
+	uint8_t buffer[32];
+	std::string output;
+	std::vector<size_t> chunkSizes;
+	size_t calls = 0;
+	LogBatchStreamer streamer(
+	    LogStreamFormat::Ndjson,
+	    buffer,
+	    sizeof(buffer),
+	    [&](const uint8_t *data, size_t size) {
+		    if (++calls % 3 == 0) {
+			    return false;
+		    }
+		    output.append(reinterpret_cast<const char *>(data), size);
+		    chunkSizes.push_back(size);
+		    return true;
+	    }
+	);
+	size_t attempts = 0;
+	while (!streamer.write(batch)) {
+		expect_true(streamer.interrupted(), "A refused chunk should leave a resume point");
+		expect_true(++attempts < 1000, "Streaming should make progress");
+	}
+	expect_true(attempts > 0, "The refusing sink should have interrupted the batch");
+	while (!streamer.flush()) {
+	}
+	expect_equal(output, expected, "Resumed NDJSON output should match a single pass");
+	for (size_t index = 0; index + 1 < chunkSizes.size(); ++index) {
+		expect_equal(chunkSizes[index], sizeof(buffer), "Chunks should fill the buffer");
+	}
+
+	// CBOR: one map per entry with the same keys.
+	std::string cbor;
+	LogBatchStreamer cborStreamer(
+	    LogStreamFormat::Cbor,
+	    buffer,
+	    sizeof(buffer),
+	    [&cbor](const uint8_t *data, size_t size) {
+		    cbor.append(reinterpret_cast<const char *>(data), size);
+		    return true;
+	    }
+	);
+	expect_true(cborStreamer.write(std::vector<Log>{structured}), "CBOR write");
+	expect_true(cborStreamer.flush(), "CBOR flush");
+	const std::string expectedCbor(
+	    "\xA6\x65level\x64warn\x63tag\x61T\x66millis\x01\x69timestamp\x21\x67message\x62hi"
+	    "\x66"
+	    "fields\xA1\x64rssi\x38\x3C"
+	);
+	expect_equal(cbor, expectedCbor, "CBOR encoding of a structured entry");
+}
+
+void test_compressor_frames_round_trip_through_the_streamer() {
+	std::vector<Log> batch;
+	for (int index = 0; index < 300; ++index) {
+		Log entry;
+		entry.level = index % 7 == 0 ? LogLevel::Warn : LogLevel::Info;
+		entry.tag = index % 2 == 0 ? "WIFI" : "SENSOR";
+		entry.millis = 120000 + static_cast<uint32_t>(index) * 37;
+		entry.timestamp = 1700000000 + index / 10;
+		entry.message = index % 2 == 0 ? "rssi=-" + std::to_string(50 + index % 20) + " channel=6"
+		                               : "temp=" + std::to_string(20 + index % 5) + ".5 ok";
+		batch.push_back(entry);
+	}
+
+	std::string frames;
+	size_t calls = 0;
+	LogCompressor compressor(
+	    [&](const uint8_t *data, size_t size) {
+		    if (++calls % 4 == 0) {
+			    return false;
+		    }
+		    frames.append(reinterpret_cast<const char *>(data), size);
+		    return true;
+	    },
+	    256
+	);
+	expect_true(compressor.isValid(), "Default compressor parameters should be valid");
+
+	uint8_t chunk[256];
+	std::string plain;
+	LogBatchStreamer plainStreamer(
+	    LogStreamFormat::Ndjson,
+	    chunk,
+	    sizeof(chunk),
+	    [&plain](const uint8_t *data, size_t size) {
+		    plain.append(reinterpret_cast<const char *>(data), size);
+		    return true;
+	    }
+	);
+	expect_true(plainStreamer.write(batch) && plainStreamer.flush(), "Plain NDJSON export");
+
+	LogBatchStreamer streamer(
+	    LogStreamFormat::Ndjson,
+	    chunk,
+	    sizeof(chunk),
+	    compressor.chunkSink()
+	);
+	while (!streamer.write(batch)) {
+	}
+	while (!streamer.flush()) {
+	}
+	expect_equal(compressor.rawBytes(), static_cast<uint64_t>(plain.size()), "Raw byte count");
+	expect_equal(compressor.frameBytes(), static_cast<uint64_t>(frames.size()), "Frame bytes");
+	expect_true(frames.size() * 3 <= plain.size(), "Typical log NDJSON should compress 3x");
+
+	// Byte-by-byte feeding exercises partial frame headers and payloads.
+	LogDecompressor decompressor;
+	std::string inflated;
+	for (const char byte : frames) {
+		const uint8_t value = static_cast<uint8_t>(byte);
+		expect_true(decompressor.feed(&value, 1, inflated), "Frames should decode");
+	}
+	expect_true(!decompressor.hasPending(), "No partial frame should remain");
+	expect_equal(inflated, plain, "Decompressed frames should match the plain export");
+
+	// Incompressible chunks fall back to stored frames; a reset starts a new stream that
+	// the same decompressor follows.
+	compressor.reset();
+	frames.clear();
+	calls = 0;
+	uint8_t noise[200];
+	uint32_t state = 12345;
+	for (uint8_t &value : noise) {
+		state = state * 1103515245u + 12345u;
+		value = static_cast<uint8_t>(state >> 16);
+	}
+	expect_true(compressor.write(noise, sizeof(noise)), "Noise chunk should be accepted");
+	expect_true(frames.size() <= sizeof(noise) + 6, "Stored frames add only a header");
+	expect_true(!compressor.write(noise, 257), "Chunks above maxChunk are rejected");
+	inflated.clear();
+	const auto *frameBytes = reinterpret_cast<const uint8_t *>(frames.data());
+	expect_true(
+	    decompressor.feed(frameBytes, frames.size(), inflated),
+	    "Stored frame should decode"
+	);
+	expect_equal(
+	    inflated,
+	    std::string(reinterpret_cast<const char *>(noise), sizeof(noise)),
+	    "Stored frame payload"
+	);
+}
+
+void test_file_store_rotates_recovers_and_seeks() {
+	const std::string directory =
+	    (std::filesystem::temp_directory_path() / "esplogger_store_test").string();
+	std::filesystem::remove_all(directory);
+
+	LogStoreConfig storeConfig;
+	storeConfig.directory = directory;
+	storeConfig.maxSegmentBytes = 600;
+	storeConfig.maxSegments = 4;
+	storeConfig.indexInterval = 4;
+	storeConfig.fsyncOnCommit = false;
+
+	const auto makeBatch = [](int first, int count) {
+		std::vector<Log> batch;
+		for (int index = first; index < first + count; ++index) {
+			Log entry;
+			entry.level = LogLevel::Info;
+			entry.tag = "STORE";
+			entry.millis = static_cast<uint32_t>(index);
+			entry.timestamp = 1000 + index;
+			entry.message = "stored entry " + std::to_string(index);
+			batch.push_back(entry);
+		}
+		return batch;
+	};
+
+	{
+		LogFileStore store;
+		expect_true(store.open(storeConfig), "Store should open in a fresh directory");
+		for (int batch = 0; batch < 6; ++batch) {
+			expect_true(store.append(makeBatch(batch * 10, 10)), "Group commit should succeed");
+		}
+		expect_equal(store.nextSeq(), static_cast<uint64_t>(60), "Sequence numbers per record");
+		expect_equal(store.segmentCount(), storeConfig.maxSegments, "Old segments are dropped");
+
+		const std::vector<StoredLog> all = store.readFromSeq(0);
+		expect_true(!all.empty() && all.back().seq == 59, "Newest record should be readable");
+		for (size_t index = 1; index < all.size(); ++index) {
+			expect_equal(all[index].seq, all[index - 1].seq + 1, "Records come back in order");
+		}
+
+		const std::vector<StoredLog> recent = store.readSince(1050);
+		expect_equal(recent.size(), static_cast<size_t>(10), "Time seek returns the tail");
+		expect_equal(recent.front().log.message, std::string("stored entry 50"), "Seek start");
+		expect_equal(recent.front().log.tag, std::string("STORE"), "Stored tag");
+
+		const std::vector<StoredLog> window = store.readFromSeq(53, 3);
+		expect_equal(window.size(), static_cast<size_t>(3), "Sequence seek honors maxCount");
+		expect_equal(window.front().seq, static_cast<uint64_t>(53), "Sequence seek start");
+	}
+
+	// Simulate a torn write: a partial record at the end of the newest segment.
+	std::string newest;
+	for (const auto &item : std::filesystem::directory_iterator(directory)) {
+		const std::string path = item.path().string();
+		if (item.path().extension() == ".log" && std::filesystem::file_size(item.path()) > 0 &&
+		    path > newest) {
+			newest = path;
+		}
+	}
+	{
+		std::ofstream torn(newest, std::ios::binary | std::ios::app);
+		torn.write("\x40\x00\x00\x00\x12\x34", 6);
+	}
+
+	LogFileStore reopened;
+	expect_true(reopened.open(storeConfig), "Store should reopen over a torn tail");
+	expect_equal(reopened.nextSeq(), static_cast<uint64_t>(60), "Next seq survives reopen");
+	expect_true(reopened.append(makeBatch(60, 2)), "Appends continue in a new segment");
+	const std::vector<StoredLog> tail = reopened.readSince(1058);
+	expect_equal(tail.size(), static_cast<size_t>(4), "Reads skip the torn record");
+	expect_equal(tail.back().seq, static_cast<uint64_t>(61), "New records follow recovery");
+
+	ESPLogger logger;
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for the file store test");
+	}
+	logger.onSync(reopened.syncCallback());
+	logger.warn("SYNC", "persisted %d", 1);
+	logger.sync();
+	logger.deinit();
+	const std::vector<StoredLog> synced = reopened.readFromSeq(62);
+	expect_equal(synced.size(), static_cast<size_t>(1), "onSync handler should persist");
+	expect_equal(synced[0].log.message, std::string("persisted 1"), "Persisted message");
+
+	const size_t segments = reopened.segmentCount();
+	reopened.close();
+
+	// Open/close cycles without appends must not leave empty segments behind.
+	for (int cycle = 0; cycle < 3; ++cycle) {
+		LogFileStore idle;
+		expect_true(idle.open(storeConfig), "Store should reopen without appending");
+		expect_equal(idle.segmentCount(), segments, "Opening alone should not add a segment");
+	}
+	LogFileStore last;
+	expect_true(last.open(storeConfig), "Store should reopen after idle cycles");
+	expect_equal(last.readFromSeq(0).back().seq, static_cast<uint64_t>(62), "Data is kept");
+	last.close();
+	std::filesystem::remove_all(directory);
+}
+
+void test_retained_ring_replays_unsynced_entries_after_a_reset() {
+	test_support::resetMillis();
+
+	// Stands in for an RTC_NOINIT region: garbage at power-on, kept across a reset.
+	alignas(4) static uint8_t retained[2048];
+	std::memset(retained, 0xA5, sizeof(retained));
+	uint8_t snapshot[sizeof(retained)];
+
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.deferFormatting = true;
+	config.retainedBuffer = retained;
+	config.retainedBufferSize = sizeof(retained);
+	{
+		std::vector<Log> synced;
+		ESPLogger logger;
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize with a retained buffer");
+		}
+		logger.onSync([&synced](const std::vector<Log> &logs) {
+			synced.insert(synced.end(), logs.begin(), logs.end());
+		});
+		logger.sync();
+		expect_true(synced.empty(), "Garbage in the region should not be replayed");
+
+		logger.info("BOOT", "delivered %d", 1);
+		logger.sync();
+		logger.warn("NET", "rssi=%d", -61);
+		logger.error("NET").kv("code", 7).emit();
+		// A reset skips deinit(), which would otherwise empty the ring.
+		std::memcpy(snapshot, retained, sizeof(retained));
+	}
+	std::memcpy(retained, snapshot, sizeof(retained));
+
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to re-initialize with a retained buffer");
+	}
+	std::vector<std::vector<Log>> batches;
+	logger.onSync([&batches](LogBatchView batch) {
+		batches.emplace_back(batch.begin(), batch.end());
+	});
+	logger.info("BOOT", "fresh");
+	logger.sync();
+
+	expect_equal(batches.size(), static_cast<size_t>(2), "Survivors should form their own batch");
+	expect_equal(batches[0].size(), static_cast<size_t>(2), "Only unsynced entries survive");
+	expect_true(batches[0][0].previousBoot && batches[0][1].previousBoot, "previousBoot flag");
+	expect_equal(batches[0][0].tag, std::string("NET"), "Recovered tag");
+	expect_true(batches[0][0].level == LogLevel::Warn, "Recovered level");
+	expect_equal(batches[0][0].message, std::string("rssi=-61"), "Deferred entry should render");
+	expect_equal(batches[0][1].message, std::string("code=7"), "Structured entry should render");
+	expect_true(!batches[0][1].fields.empty(), "Recovered fields stay typed");
+	expect_equal(batches[1].size(), static_cast<size_t>(1), "This boot's batch follows");
+	expect_true(!batches[1][0].previousBoot, "Fresh entries are not flagged");
+	logger.deinit();
+
+	// A clean deinit() leaves nothing behind.
+	batches.clear();
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to re-initialize after a clean shutdown");
+	}
+	logger.onSync([&batches](LogBatchView batch) {
+		batches.emplace_back(batch.begin(), batch.end());
+	});
+	logger.sync();
+	expect_true(batches.empty(), "A clean shutdown should not replay entries");
+	logger.deinit();
+
+	// Wrapping keeps the newest suffix in order; a damaged header drops the whole ring.
+	LogRetainedRing ring(retained, 512);
+	ring.reset(7);
+	for (int index = 0; index < 100; ++index) {
+		const std::string message = "entry " + std::to_string(index);
+		ring.append(LogLevel::Info, RetainedKind::Text, 0, 0, "T", {}, message);
+	}
+	std::vector<std::string> survivors;
+	expect_true(
+	    ring.recover([&survivors](const RetainedRecordView &view) {
+		    survivors.emplace_back(view.payload);
+	    }),
+	    "Wrapped ring should be intact"
+	);
+	expect_equal(ring.storedGeneration(), static_cast<uint32_t>(7), "Generation is stored");
+	expect_true(survivors.size() > 5 && survivors.size() < 100, "Oldest entries are evicted");
+	for (size_t index = 0; index < survivors.size(); ++index) {
+		const size_t expected = 100 - survivors.size() + index;
+		expect_equal(survivors[index], "entry " + std::to_string(expected), "Survivor order");
+	}
+	retained[12] ^= 0x01;
+	expect_true(!ring.recover(nullptr), "A header CRC mismatch should reject the ring");
+}
+
+void test_mapped_storage_persists_and_can_be_tailed() {
+	test_support::resetMillis();
+	const std::string path =
+	    (std::filesystem::temp_directory_path() / "esplogger_mapped_test.bin").string();
+	std::filesystem::remove(path);
+
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.deferFormatting = true;
+	config.mappedLogPath = path.c_str();
+	config.mappedLogBytes = 4096;
+
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with mapped storage");
+	}
+	// An external reader: a read-only mapping of the same file.
+	LogMappedFile mapping;
+	expect_true(mapping.open(path.c_str(), 0, true), "File should map read-only");
+	const LogRetainedRing reader(mapping.data(), mapping.size());
+	uint64_t cursor = reader.tailCursor();
+
+	logger.info("MAP", "value=%d", 1);
+	logger.warn("MAP").kv("x", 2).emit();
+	std::vector<std::string> tailed;
+	const auto collect = [&tailed](const RetainedRecordView &view) {
+		tailed.emplace_back(std::string(view.tag) + ":" + std::string(view.format));
+	};
+	expect_true(reader.follow(cursor, collect), "Reader should keep up");
+	expect_equal(tailed.size(), static_cast<size_t>(2), "Reader should see both records");
+	expect_equal(tailed[0], std::string("MAP:value=%d"), "Format text is stored for readers");
+
+	const std::vector<Log> buffered = logger.getAllLogs();
+	expect_equal(buffered.size(), static_cast<size_t>(2), "Mapped entries are queryable");
+	expect_equal(buffered[0].message, std::string("value=1"), "Deferred entry renders");
+	expect_equal(buffered[1].message, std::string("x=2"), "Structured entry renders");
+
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &logs) {
+		synced.insert(synced.end(), logs.begin(), logs.end());
+	});
+	logger.sync();
+	expect_equal(synced.size(), static_cast<size_t>(2), "Sync should hand out mapped entries");
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(0), "Sync drains the ring");
+
+	// Wrapping evicts the oldest bytes; sync still sees the newest entries in order and a
+	// reader that fell behind is told it missed some.
+	synced.clear();
+	for (int index = 0; index < 400; ++index) {
+		logger.info("MAP", "line %d", index);
+	}
+	const size_t pending = logger.getAllLogs().size();
+	expect_true(pending > 10 && pending < 400, "Pending entries are bounded by the file");
+	logger.sync();
+	expect_equal(synced.size(), pending, "Sync batch matches the pending count");
+	expect_equal(synced.back().message, std::string("line 399"), "Newest entry is last");
+	for (size_t index = 1; index < synced.size(); ++index) {
+		expect_true(synced[index].millis > synced[index - 1].millis, "Mapped order");
+	}
+	tailed.clear();
+	expect_true(!reader.follow(cursor, collect), "A lapped reader should be told");
+	expect_true(!tailed.empty(), "A lapped reader resumes at the oldest record");
+	logger.deinit();
+
+	// Records persist in the file, but a new logger does not sync them again.
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to reopen mapped storage");
+	}
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(0), "Old entries not pending");
+	size_t persisted = 0;
+	uint64_t start = reader.tailCursor();
+	reader.follow(start, [&persisted](const RetainedRecordView &) { ++persisted; });
+	expect_true(persisted > 10, "Records should persist across runs");
+	logger.deinit();
+
+	mapping.close();
+	std::filesystem::remove(path);
+}
+
+void test_spill_store_replays_overflow_in_order() {
+	test_support::resetMillis();
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.deferFormatting = true;
+	config.maxLogInRam = 8;
+
+	std::vector<std::vector<Log>> batches;
+	LogMemorySpill spill(4096, false);
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for spilling");
+	}
+	logger.setSpillStore(spill.store());
+	for (int index = 0; index < 40; ++index) {
+		logger.info("SPILL", "line %d", index);
+	}
+	LoggerStats stats = logger.getStats();
+	expect_equal(
+	    stats.spilledCount + logger.getAllLogs().size(),
+	    static_cast<size_t>(40),
+	    "Nothing should be lost"
+	);
+	expect_equal(stats.spillFailedCount, static_cast<uint32_t>(0), "Spill store has room");
+	expect_equal(spill.count(), static_cast<size_t>(stats.spilledCount), "Spilled entries held");
+
+	logger.onSync([&batches](LogBatchView batch) {
+		batches.emplace_back(batch.begin(), batch.end());
+	});
+	logger.sync();
+	std::vector<Log> synced;
+	for (const auto &batch : batches) {
+		expect_true(batch.size() <= config.maxLogInRam, "Replay batches are buffer-sized");
+		synced.insert(synced.end(), batch.begin(), batch.end());
+	}
+	expect_equal(synced.size(), static_cast<size_t>(40), "Sync should deliver every entry");
+	for (size_t index = 0; index < synced.size(); ++index) {
+		expect_equal(synced[index].message, "line " + std::to_string(index), "Spill order");
+	}
+	expect_equal(spill.count(), static_cast<size_t>(0), "Replayed entries leave the store");
+
+	// A full spill store keeps the oldest overflow; what it refuses is dropped, and the
+	// entries that do come back are still in order.
+	LogMemorySpill small(512, false);
+	logger.setSpillStore(small.store());
+	for (int index = 0; index < 40; ++index) {
+		logger.info("SPILL", "line %d", index);
+	}
+	expect_true(logger.getStats().spillFailedCount > 0, "Refused entries should be counted");
+	batches.clear();
+	logger.sync();
+	synced.clear();
+	size_t notices = 0;
+	for (const auto &batch : batches) {
+		for (const Log &entry : batch) {
+			if (entry.tag == ESPLogger::kDropNoticeTag) {
+				++notices;
+			} else {
+				synced.push_back(entry);
+			}
+		}
+	}
+	expect_equal(notices, static_cast<size_t>(1), "Refused entries should be announced");
+	expect_true(synced.size() > config.maxLogInRam && synced.size() < 40, "Partial spill");
+	expect_equal(synced.front().message, std::string("line 0"), "Oldest spill survives");
+	expect_equal(synced.back().message, std::string("line 39"), "Newest entry is last");
+	for (size_t index = 1; index < synced.size(); ++index) {
+		expect_true(synced[index].millis > synced[index - 1].millis, "Partial spill order");
+	}
+
+	// A store that comes back short (a damaged file) ends the replay; the entries it lost
+	// are counted as dropped by level and announced with the buffered batch.
+	LogMemorySpill lossy(4096, false);
+	const LogSpillStore inner = lossy.store();
+	LogSpillStore lossyStore = inner;
+	size_t readable = 4;
+	lossyStore.read = [inner, &readable](size_t maxCount, std::vector<Log> &out) {
+		const size_t read = inner.read(std::min(maxCount, readable), out);
+		readable -= read;
+		return read;
+	};
+	logger.setSpillStore(lossyStore);
+	const LoggerStats before = logger.getStats();
+	for (int index = 0; index < 40; ++index) {
+		if (index < 2) {
+			logger.warn("SPILL", "line %d", index);
+		} else {
+			logger.info("SPILL", "line %d", index);
+		}
+	}
+	const uint32_t spilledNow = logger.getStats().spilledCount - before.spilledCount;
+	expect_true(spilledNow > 4, "The lossy store should take more than it returns");
+	batches.clear();
+	logger.sync();
+	const LoggerStats after = logger.getStats();
+	const size_t info = static_cast<size_t>(LogLevel::Info);
+	const size_t warn = static_cast<size_t>(LogLevel::Warn);
+	expect_equal(
+	    after.droppedCount[info] - before.droppedCount[info],
+	    spilledNow - 4,
+	    "Entries the store lost should count as dropped"
+	);
+	expect_equal(
+	    after.droppedCount[warn],
+	    before.droppedCount[warn],
+	    "Entries read back are not dropped"
+	);
+	expect_equal(batches.size(), static_cast<size_t>(2), "Short replay, then the buffer");
+	expect_equal(batches[0].size(), static_cast<size_t>(4), "Only readable entries replay");
+	expect_equal(
+	    batches[1].front().message,
+	    std::to_string(spilledNow - 4) + " entries dropped (info " +
+	        std::to_string(spilledNow - 4) + ")",
+	    "Lost entries should be announced"
+	);
+	logger.deinit();
+
+	// Arena mode spilling to a file store; structured fields survive the round trip.
+	const std::string directory =
+	    (std::filesystem::temp_directory_path() / "esplogger_spill_test").string();
+	std::filesystem::remove_all(directory);
+	LogStoreConfig storeConfig;
+	storeConfig.directory = directory;
+	storeConfig.fsyncOnCommit = false;
+	LogFileStore store;
+	expect_true(store.open(storeConfig), "Spill file store should open");
+
+	config.maxLogBytes = 1024;
+	config.spillBatch = 5;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize in arena mode for spilling");
+	}
+	logger.setSpillStore(store.spillStore());
+	for (int index = 0; index < 60; ++index) {
+		logger.info("SPILL").kv("index", index).emit();
+	}
+	expect_true(logger.getStats().spilledCount >= 5, "Arena overflow should spill");
+	synced.clear();
+	logger.onSync([&synced](const std::vector<Log> &logs) {
+		synced.insert(synced.end(), logs.begin(), logs.end());
+	});
+	logger.sync();
+	expect_equal(synced.size(), static_cast<size_t>(60), "Arena spill delivers every entry");
+	for (size_t index = 0; index < synced.size(); ++index) {
+		expect_equal(synced[index].message, "index=" + std::to_string(index), "Arena order");
+	}
+	expect_true(!synced.front().fields.empty(), "Spilled fields stay typed");
+	logger.deinit();
+	store.close();
+	std::filesystem::remove_all(directory);
+}
+
+void test_overflow_policies_count_and_announce_drops() {
+	test_support::resetMillis();
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.maxLogInRam = 4;
+	config.overflowPolicy = LogOverflowPolicy::DropNewest;
+
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with DropNewest");
+	}
+	for (int index = 0; index < 6; ++index) {
+		logger.info("POLICY", "entry %d", index);
+	}
+	std::vector<Log> logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(4), "DropNewest keeps the buffer full");
+	expect_equal(logs.back().message, std::string("entry 3"), "DropNewest keeps the oldest");
+	LoggerStats stats = logger.getStats();
+	expect_equal(
+	    stats.droppedCount[static_cast<size_t>(LogLevel::Info)],
+	    static_cast<uint32_t>(2),
+	    "Dropped entries are counted by level"
+	);
+	logger.deinit();
+
+	// Lowest level first: Debug goes before Info, and an incoming entry below everything
+	// buffered is the one dropped.
+	config.overflowPolicy = LogOverflowPolicy::DropLowestLevel;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with DropLowestLevel");
+	}
+	std::vector<Log> synced;
+	logger.onSync([&synced](const std::vector<Log> &batch) { synced = batch; });
+	logger.error("POLICY", "E0");
+	logger.debug("POLICY", "D0");
+	logger.info("POLICY", "I0");
+	logger.debug("POLICY", "D1");
+	logger.warn("POLICY", "W0");
+	logger.debug("POLICY", "D2");
+	logger.info("POLICY", "I1");
+	logger.debug("POLICY", "D3");
+	logger.sync();
+	expect_equal(synced.size(), static_cast<size_t>(5), "Notice plus the surviving entries");
+	expect_equal(synced[0].tag, std::string(ESPLogger::kDropNoticeTag), "Notice comes first");
+	expect_true(synced[0].level == LogLevel::Warn, "Notice is a warning");
+	expect_equal(synced[0].message, std::string("4 entries dropped (debug 4)"), "Notice text");
+	const char *expected[] = {"E0", "I0", "W0", "I1"};
+	for (size_t index = 0; index < 4; ++index) {
+		expect_equal(synced[index + 1].message, std::string(expected[index]), "Arrival order");
+	}
+	logger.info("POLICY", "after");
+	logger.sync();
+	expect_equal(synced.size(), static_cast<size_t>(1), "Drops are announced once");
+	logger.deinit();
+
+	// Block with nothing to make room waits out the timeout, then drops the new entry.
+	config.overflowPolicy = LogOverflowPolicy::Block;
+	config.overflowBlockMS = 5;
+	config.maxLogInRam = 2;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with Block");
+	}
+	logger.info("POLICY", "a");
+	logger.info("POLICY", "b");
+	const TickType_t before = xTaskGetTickCount();
+	logger.info("POLICY", "c");
+	expect_true(xTaskGetTickCount() - before >= 5, "Block should wait for the timeout");
+	logs = logger.getAllLogs();
+	expect_equal(logs.back().message, std::string("b"), "A timed-out entry is dropped");
+	expect_equal(
+	    logger.getStats().droppedCount[static_cast<size_t>(LogLevel::Info)],
+	    static_cast<uint32_t>(1),
+	    "Timed-out entry is counted"
+	);
+	logger.sync();
+	logger.info("POLICY", "d");
+	expect_equal(logger.getAllLogs().size(), static_cast<size_t>(1), "Room after a sync");
+	logger.deinit();
+}
+
+void test_level_reserves_protect_entries_from_floods() {
+	test_support::resetMillis();
+	LoggerConfig config;
+	config.enableSyncTask = false;
+	config.consoleLogLevel = LogLevel::Error;
+	config.maxLogInRam = 10;
+	config.reservedPerLevel[static_cast<size_t>(LogLevel::Error)] = 2;
+
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize with level reserves");
+	}
+	logger.error("FLOOD", "E0");
+	logger.error("FLOOD", "E1");
+	logger.error("FLOOD", "E2");
+	for (int index = 0; index < 50; ++index) {
+		logger.debug("FLOOD", "D%d", index);
+	}
+	std::vector<Log> logs = logger.getAllLogs();
+	expect_equal(logs.size(), static_cast<size_t>(10), "Reserves keep the buffer size");
+	expect_equal(logger.getLogCount(LogLevel::Error), 3, "A Debug flood never evicts Errors");
+	expect_equal(logs[0].message, std::string("E0"), "Entries stay in arrival order");
+	expect_equal(logs[3].message, std::string("D43"), "The flood keeps its newest entries");
+	expect_equal(logs.back().message, std::string("D49"), "Newest entry is last");
+
+	// The incoming entry counts toward its level: a reserved low level keeps its share
+	// against a flood of a higher one, then cycles through that share.
+	logger.deinit();
+	config.reservedPerLevel[static_cast<size_t>(LogLevel::Error)] = 0;
+	config.reservedPerLevel[static_cast<size_t>(LogLevel::Debug)] = 3;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to re-initialize with level reserves");
+	}
+	std::vector<Log> synced;
+	logger.onSync([&synced](LogBatchView batch) { synced.assign(batch.begin(), batch.end()); });
+	for (int index = 0; index < 10; ++index) {
+		logger.info("FLOOD", "I%d", index);
+	}
+	for (int index = 0; index < 5; ++index) {
+		logger.debug("FLOOD", "D%d", index);
+	}
+	logger.sync();
+	expect_equal(synced.size(), static_cast<size_t>(11), "Notice plus a full buffer");
+	expect_equal(synced[0].message, std::string("5 entries dropped (debug 2, info 3)"), "Drops");
+	const char *expected[] = {"I3", "I4", "I5", "I6", "I7", "I8", "I9", "D2", "D3", "D4"};
+	for (size_t index = 0; index < 10; ++index) {
+		expect_equal(synced[index + 1].message, std::string(expected[index]), "Merged order");
+	}
+	logger.deinit();
+}
+
+// Runs `fn` with stdout redirected to a temporary file and returns what it printed.
+template <typename Fn> std::string captureStdout(Fn &&fn) {
+	std::fflush(stdout);
+	std::FILE *capture = std::tmpfile();
+	const int saved = dup(fileno(stdout));
+	dup2(fileno(capture), fileno(stdout));
+	fn();
+	std::fflush(stdout);
+	dup2(saved, fileno(stdout));
+	close(saved);
+
+	std::string output;
+	std::rewind(capture);
+	char buffer[256];
+	size_t read = 0;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), capture)) > 0) {
+		output.append(buffer, read);
+	}
+	std::fclose(capture);
+	return output;
+}
+
+void test_evicted_deferred_records_still_reach_the_console() {
+	test_support::resetMillis();
+	LoggerConfig config;
+	config.enableSyncTask = true; // Never runs here; its presence keeps records deferred
+	config.consoleLogLevel = LogLevel::Info;
+	config.deferFormatting = true;
+	config.maxLogInRam = 2;
+
+	ESPLogger logger;
+	if (!logger.init(config)) {
+		fail("ESPLogger failed to initialize for console eviction");
+	}
+	const std::string output = captureStdout([&logger] {
+		for (int index = 0; index < 5; ++index) {
+			logger.info("EVICT", "deferred %d", index);
+		}
+		logger.debug("EVICT", "below console %d", 0);
+		logger.sync();
+	});
+	for (int index = 0; index < 5; ++index) {
+		const std::string line = "[I] [EVICT] ~ deferred " + std::to_string(index) + "\n";
+		const size_t at = output.find(line);
+		expect_true(at != std::string::npos, "Every deferred line should print: " + line);
+		expect_true(output.find(line, at + 1) == std::string::npos, "Printed once: " + line);
+	}
+	expect_true(output.find("below console") == std::string::npos, "Console level applies");
+	logger.deinit();
+}
+
+void test_unsynced_records_print_when_logged() {
+	for (const size_t maxLogBytes : {static_cast<size_t>(0), static_cast<size_t>(2048)}) {
+		test_support::resetMillis();
+		LoggerConfig config;
+		config.enableSyncTask = false;
+		config.consoleLogLevel = LogLevel::Warn;
+		config.deferFormatting = true;
+		config.maxLogBytes = maxLogBytes;
+
+		ESPLogger logger;
+		if (!logger.init(config)) {
+			fail("ESPLogger failed to initialize for log-time console output");
+		}
+		std::vector<Log> synced;
+		logger.onSync([&synced](const std::vector<Log> &logs) { synced = logs; });
+		const std::string logged = captureStdout([&logger] {
+			logger.error("UNSYNCED", "deferred %d", 1);
+			logger.warn("UNSYNCED").kv("code", 7).emit();
+			logger.info("UNSYNCED", "quiet %d", 2);
+			logger.info("UNSYNCED", "%s", "");
+		});
+		const std::string flushed = captureStdout([&logger] { logger.sync(); });
+
+		expect_true(
+		    logged.find("[E] [UNSYNCED] ~ deferred 1\n") != std::string::npos,
+		    "Errors should print when logged without a sync task"
+		);
+		expect_true(
+		    logged.find("[W] [UNSYNCED] ~ code=7\n") != std::string::npos,
+		    "Structured records should print when logged without a sync task"
+		);
+		expect_true(logged.find("quiet") == std::string::npos, "Console level applies");
+		expect_true(flushed.find("UNSYNCED") == std::string::npos, "sync() should not reprint");
+		expect_equal(synced.size(), static_cast<size_t>(3), "Empty messages should be dropped");
+		expect_equal(synced[1].message, std::string("code=7"), "Fields still render");
+		expect_true(!synced[1].fields.empty(), "Printed records keep their fields");
+		expect_equal(synced[2].message, std::string("quiet 2"), "Quiet records are still kept");
+		logger.deinit();
+	}
+}
+
 } // namespace
 
 int main() {
@@ -585,6 +2693,39 @@ int main() {
 		test_get_logs_by_level();
 		test_static_helpers_on_snapshot();
 		test_destructor_calls_deinit_and_flushes_pending_logs();
+		test_formats_short_and_oversized_messages();
+		test_lock_free_ring_keeps_newest_entries();
+		test_lock_free_ring_accepts_concurrent_producers();
+		test_deferred_formatting_matches_immediate_output();
+		test_deferred_formatting_renders_for_live_callback();
+		test_level_queue_keeps_arrival_order_across_levels();
+		test_arena_keeps_a_contiguous_newest_suffix();
+		test_byte_budget_storage_evicts_oldest_by_bytes();
+	test_tag_registry_interns_by_pointer_and_content();
+	test_interned_tags_survive_every_storage_mode();
+	test_sync_view_callback_receives_drained_batch();
+	test_sync_retires_buffer_and_reports_stats();
+	test_watermark_and_severity_wake_the_sync_task();
+	test_running_sync_task_flushes_on_trigger_and_stops_promptly();
+	test_deinit_abandons_a_task_blocked_in_on_sync();
+	test_abandoned_task_never_touches_a_destroyed_logger();
+	test_reconfigure_applies_changes_in_place();
+	test_reconfigure_recreates_task_only_for_core_or_stack();
+	test_capture_level_gates_before_formatting();
+	test_tag_levels_override_the_capture_level();
+	test_typed_format_writes_arguments_without_printf();
+	test_structured_fields_render_on_demand();
+	test_binary_stream_round_trips_batches();
+	test_batch_streamer_fills_fixed_chunks_and_resumes();
+	test_compressor_frames_round_trip_through_the_streamer();
+	test_file_store_rotates_recovers_and_seeks();
+	test_retained_ring_replays_unsynced_entries_after_a_reset();
+	test_mapped_storage_persists_and_can_be_tailed();
+	test_spill_store_replays_overflow_in_order();
+	test_overflow_policies_count_and_announce_drops();
+	test_level_reserves_protect_entries_from_floods();
+	test_evicted_deferred_records_still_reach_the_console();
+	test_unsynced_records_print_when_logged();
 	} catch (const std::exception &ex) {
 		std::cerr << "Test failure: " << ex.what() << '\n';
 		return 1;
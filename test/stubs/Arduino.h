@@ -7,6 +7,7 @@ extern "C" {
 #endif
 
 unsigned long millis(void);
+unsigned long micros(void);
 
 #ifdef __cplusplus
 }
@@ -15,6 +15,8 @@ typedef uint32_t StackType_t;
 
 #define pdPASS 1
 #define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
 #define portMAX_DELAY ((TickType_t) - 1)
 #define tskNO_AFFINITY (-1)
 
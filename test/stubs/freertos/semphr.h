@@ -7,6 +7,7 @@ extern "C" {
 #endif
 
 SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
 BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks);
 BaseType_t xSemaphoreGive(SemaphoreHandle_t handle);
 void vSemaphoreDelete(SemaphoreHandle_t handle);
@@ -20,7 +20,11 @@ BaseType_t xTaskCreatePinnedToCore(
 
 void vTaskDelete(TaskHandle_t task);
 void vTaskDelay(TickType_t ticks);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
 TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
 
 #ifdef __cplusplus
 }
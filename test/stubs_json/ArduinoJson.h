@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -113,6 +114,13 @@ class JsonDocument {
 
 	template <typename T> T as() const;
 
+	// Replaces the document with an already-serialized variant (used by deserializeMsgPack).
+	void setRoot(JsonVariantConst root) {
+		_members.clear();
+		_root = std::move(root);
+		_hasRoot = true;
+	}
+
   private:
 	friend class MemberProxy;
 
@@ -128,6 +136,10 @@ class JsonDocument {
 	}
 
 	JsonVariantConst toVariant() const {
+		if (_hasRoot) {
+			return _root;
+		}
+
 		std::string compact = "{";
 		std::string pretty = "{";
 
@@ -165,6 +177,26 @@ class JsonDocument {
 	}
 
 	std::vector<std::pair<std::string, JsonVariantConst>> _members;
+	JsonVariantConst _root;
+	bool _hasRoot = false;
+};
+
+class DeserializationError {
+  public:
+	enum Code { Ok, InvalidInput };
+
+	DeserializationError(Code code = Ok) : _code(code) {
+	}
+
+	explicit operator bool() const {
+		return _code != Ok;
+	}
+	Code code() const {
+		return _code;
+	}
+
+  private:
+	Code _code;
 };
 
 template <> inline JsonVariantConst JsonDocument::as<JsonVariantConst>() const {
@@ -209,4 +241,66 @@ inline size_t serializeJsonPretty(JsonVariantConst source, void *buffer, size_t
 	return text.size();
 }
 
+template <typename Writer> size_t serializeJson(JsonVariantConst source, Writer &writer) {
+	const std::string &text = source.compact();
+	return writer.write(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+template <typename Writer> size_t serializeJsonPretty(JsonVariantConst source, Writer &writer) {
+	const std::string &text = source.pretty();
+	return writer.write(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+// The stub variant has no structure to encode, so its "MessagePack" form is the compact
+// text's length (4 bytes) followed by the compact and pretty renderings. Only the
+// function shapes match ArduinoJson.
+inline size_t measureMsgPack(JsonVariantConst source) {
+	return 4 + source.compact().size() + source.pretty().size();
+}
+
+inline size_t serializeMsgPack(JsonVariantConst source, void *buffer, size_t bufferSize) {
+	const size_t required = measureMsgPack(source);
+	if (buffer == nullptr || bufferSize < required) {
+		return 0;
+	}
+
+	const uint32_t compactSize = static_cast<uint32_t>(source.compact().size());
+	char *out = static_cast<char *>(buffer);
+	std::memcpy(out, &compactSize, 4);
+	std::memcpy(out + 4, source.compact().data(), compactSize);
+	std::memcpy(out + 4 + compactSize, source.pretty().data(), source.pretty().size());
+	return required;
+}
+
+template <typename Writer> size_t serializeMsgPack(JsonVariantConst source, Writer &writer) {
+	const uint32_t compactSize = static_cast<uint32_t>(source.compact().size());
+	size_t written = writer.write(reinterpret_cast<const uint8_t *>(&compactSize), 4);
+	written += writer.write(
+	    reinterpret_cast<const uint8_t *>(source.compact().data()),
+	    source.compact().size()
+	);
+	written += writer.write(
+	    reinterpret_cast<const uint8_t *>(source.pretty().data()),
+	    source.pretty().size()
+	);
+	return written;
+}
+
+inline DeserializationError
+deserializeMsgPack(JsonDocument &document, const char *input, size_t inputSize) {
+	uint32_t compactSize = 0;
+	if (input == nullptr || inputSize < 4) {
+		return DeserializationError::InvalidInput;
+	}
+	std::memcpy(&compactSize, input, 4);
+	if (inputSize - 4 < compactSize) {
+		return DeserializationError::InvalidInput;
+	}
+
+	std::string compact(input + 4, compactSize);
+	std::string pretty(input + 4 + compactSize, inputSize - 4 - compactSize);
+	document.setRoot(JsonVariantConst::fromRaw(std::move(compact), std::move(pretty)));
+	return DeserializationError::Ok;
+}
+
 } // namespace ArduinoJson
@@ -1,7 +1,16 @@
 #pragma once
 
+#include <cstdint>
+
 namespace test_support {
 
 void resetMillis(unsigned long start = 0);
+uint32_t pendingNotifications();
+// Runs tasks created through xTaskCreatePinnedToCore on real threads.
+void setRunTasks(bool runTasks);
+// Task threads that have not returned yet.
+int liveTasks();
+// Makes the next `count` xTaskCreatePinnedToCore calls fail.
+void failTaskCreates(int count);
 
 }
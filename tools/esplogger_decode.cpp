@@ -0,0 +1,102 @@
+// Decodes binary log dumps written through binarySyncCallback / LogBinaryEncoder.
+//
+//   esplogger_decode [--ndjson] [--compressed [--raw]] [file]
+//
+// Reads `file` (or stdin) and prints one line per entry, as text by default or as NDJSON.
+// With --compressed the input is a LogCompressor frame stream that is decompressed first;
+// --raw then writes the decompressed bytes as they are (e.g. streamed NDJSON or CBOR).
+
+#include "esp_logger/logger_binary.h"
+#include "esp_logger/logger_compress.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage(const char *program) {
+	std::fprintf(stderr, "usage: %s [--ndjson] [--compressed [--raw]] [file]\n", program);
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	bool ndjson = false;
+	bool compressed = false;
+	bool raw = false;
+	const char *path = nullptr;
+	for (int index = 1; index < argc; ++index) {
+		if (std::strcmp(argv[index], "--ndjson") == 0) {
+			ndjson = true;
+		} else if (std::strcmp(argv[index], "--compressed") == 0) {
+			compressed = true;
+		} else if (std::strcmp(argv[index], "--raw") == 0) {
+			raw = true;
+		} else if (argv[index][0] == '-' && argv[index][1] != '\0') {
+			return usage(argv[0]);
+		} else if (path == nullptr) {
+			path = argv[index];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (raw && !compressed) {
+		return usage(argv[0]);
+	}
+
+	std::FILE *input = stdin;
+	if (path != nullptr && std::strcmp(path, "-") != 0) {
+		input = std::fopen(path, "rb");
+		if (input == nullptr) {
+			std::fprintf(stderr, "cannot open %s\n", path);
+			return 1;
+		}
+	}
+
+	LogDecompressor decompressor;
+	LogBinaryDecoder decoder;
+	std::vector<LogBinaryEntry> entries;
+	std::string inflated;
+	char chunk[4096];
+	bool valid = true;
+	size_t read = 0;
+	while (valid && (read = std::fread(chunk, 1, sizeof(chunk), input)) > 0) {
+		const char *data = chunk;
+		size_t size = read;
+		if (compressed) {
+			inflated.clear();
+			valid = decompressor.feed(reinterpret_cast<const uint8_t *>(chunk), read, inflated);
+			if (raw) {
+				std::fwrite(inflated.data(), 1, inflated.size(), stdout);
+				continue;
+			}
+			data = inflated.data();
+			size = inflated.size();
+		}
+		entries.clear();
+		valid = decoder.feed(data, size, entries) && valid;
+		for (const LogBinaryEntry &entry : entries) {
+			const std::string line =
+			    ndjson ? logBinaryEntryToJson(entry) : logBinaryEntryToText(entry);
+			std::fwrite(line.data(), 1, line.size(), stdout);
+			std::fputc('\n', stdout);
+		}
+	}
+	if (input != stdin) {
+		std::fclose(input);
+	}
+
+	if (!valid) {
+		std::fprintf(stderr, "malformed input\n");
+		return 1;
+	}
+	if (decoder.hasPending() || decompressor.hasPending()) {
+		std::fprintf(stderr, "truncated input: last entry incomplete\n");
+		return 1;
+	}
+	return 0;
+}